@@ -14,13 +14,41 @@ template <typename T, std::size_t Dim>
 class NdArray;
 
 template <typename T, std::size_t Dim, typename Derived>
-class NdArrayBase {
+class NdArrayBase;
+
+namespace util {
+
+/* Storage of the shape of an array. Arrays whose shape is known at compile time specialize it with a static _shape,
+ * so that they do not carry a copy of it. */
+template <std::size_t Dim, typename Derived>
+class ShapeHolder {
+protected:
+    ShapeHolder() = default;
+    ShapeHolder(const Shape<Dim> &shape) : _shape(shape) {}
+
+private:
+    template <typename, std::size_t, typename>
+    friend class ndarray::NdArrayBase;
+
+    template <typename, std::size_t>
+    friend class ndarray::NdArray;
+
+    template <typename, std::size_t, typename>
+    friend class ndarray::NdArraySlice;
+
+    Shape<Dim> _shape;
+};
+
+}  // namespace util
+
+template <typename T, std::size_t Dim, typename Derived>
+class NdArrayBase : public util::ShapeHolder<Dim, Derived> {
 public:
     using dtype = T;
     static constexpr std::size_t dim = Dim;
 
     NdArrayBase() = default;
-    NdArrayBase(const Shape<Dim> &shape) : _shape(shape) {}
+    NdArrayBase(const Shape<Dim> &shape) : util::ShapeHolder<Dim, Derived>(shape) {}
 
     operator std::string() const {
         return this->to_string();
@@ -157,8 +185,6 @@ private:
 
         return result;
     }
-
-    Shape<Dim> _shape;
 };
 
 template <typename T, std::size_t Dim, typename Derived>
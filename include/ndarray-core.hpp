@@ -1,26 +1,42 @@
 #ifndef NDARRAY_CORE_HPP
 #define NDARRAY_CORE_HPP
 
+#include <memory>
+
 #include "ndarray-base.hpp"
+#include "ndarray-memory.hpp"
 #include "ndarray-shape.hpp"
 #include "ndarray-slice.hpp"
 
 namespace ndarray {
 
+/* Number of elements an NdArray of T stores inline instead of on the heap. Specialize it to tune the threshold for a
+ * type; zero disables the inline buffer. */
+template <typename T>
+class SmallBufferSize {
+public:
+    static constexpr std::size_t value =
+        std::is_trivially_default_constructible_v<T> && std::is_trivially_copyable_v<T> ? 256 / sizeof(T) : 0;
+};
+
+/* Dense array owning its elements. Elements are stored in C order by default, or in Fortran order when constructed with
+ * Order::F; the order only affects the memory layout, so indexing, item() and printing are the same for both. */
 template <typename T, std::size_t Dim>
 class NdArray : public NdArrayBase<T, Dim, NdArray<T, Dim>> {
 public:
-    NdArray(const Shape<Dim> &shape) : NdArrayBase<T, Dim, NdArray<T, Dim>>(shape), _data(new T[shape.size()]) {}
+    NdArray(const Shape<Dim> &shape, Order order = Order::C)
+        : NdArrayBase<T, Dim, NdArray<T, Dim>>(shape), _order(normalize_order(order)), _data(allocate(shape.size())) {}
 
-    NdArray(const Shape<Dim> &shape, const T *data)
-        : NdArrayBase<T, Dim, NdArray<T, Dim>>(shape), _data(new T[shape.size()]) {
+    /* Copies the elements from data, which is laid out in the given order. */
+    NdArray(const Shape<Dim> &shape, const T *data, Order order = Order::C)
+        : NdArrayBase<T, Dim, NdArray<T, Dim>>(shape), _order(normalize_order(order)), _data(allocate(shape.size())) {
         std::copy(data, data + shape.size(), _data);
     }
 
     NdArray(const std::initializer_list<NdArray<T, Dim - 1>> &list)
         requires(Dim > 1)
         : NdArrayBase<T, Dim, NdArray<T, Dim>>(Shape<Dim>(static_cast<index_t>(list.size()), list.begin()->_shape)),
-          _data(new T[this->_shape.size()]) {
+          _data(allocate(this->_shape.size())) {
         const Shape<Dim - 1> &sub_shape = list.begin()->_shape;
         for (const NdArray<T, Dim - 1> &sub_array : list) {
             if (sub_array._shape != sub_shape)
@@ -29,7 +45,7 @@ public:
 
         auto data_ptr = _data;
         for (auto &sub_array : list) {
-            std::copy(sub_array._data, sub_array._data + sub_array._shape.size(), data_ptr);
+            sub_array.copy_in_order(data_ptr, Order::C);
             data_ptr += sub_array._shape.size();
         }
     }
@@ -37,7 +53,7 @@ public:
     NdArray(const std::initializer_list<T> &list)
         requires(Dim == 1)
         : NdArrayBase<T, Dim, NdArray<T, Dim>>(Shape<1>({static_cast<index_t>(list.size())})),
-          _data(new T[list.size()]) {
+          _data(allocate(list.size())) {
         if (list.size() == 0) {
             throw std::invalid_argument("Length of initializer list cannot be 0");
         }
@@ -47,34 +63,48 @@ public:
 
     template <typename Operator>
     NdArray(const NdArraySlice<T, Dim, Operator> &array_slice)
-        : NdArrayBase<T, Dim, NdArray<T, Dim>>(array_slice._shape), _data(new T[this->size()]) {
-        std::array<index_t, Dim> indices;
-        const index_t size = this->size();
-        for (index_t i = 0; i < size; ++i) {
-            util::unravel_index<Dim>(i, this->_shape, indices);
-            this->_data[i] = array_slice[indices];
-        }
+        : NdArrayBase<T, Dim, NdArray<T, Dim>>(array_slice._shape), _data(allocate(this->size())) {
+        util::strided_copy(this->_data, util::contiguous_strides(this->_shape),
+                           static_cast<const T *>(array_slice._data), array_slice._strides, this->_shape);
     }
 
     ~NdArray() {
-        delete[] _data;
+        deallocate();
     }
 
     NdArray(const NdArray<T, Dim> &other)
-        : NdArrayBase<T, Dim, NdArray<T, Dim>>(other._shape), _data(new T[other._shape.size()]) {
+        : NdArrayBase<T, Dim, NdArray<T, Dim>>(other._shape), _order(other._order),
+          _data(allocate(other._shape.size())) {
         std::copy(other._data, other._data + other._shape.size(), this->_data);
     }
 
-    NdArray(NdArray<T, Dim> &&other) : NdArrayBase<T, Dim, NdArray<T, Dim>>(other._shape), _data(other._data) {
-        other._data = nullptr;
+    NdArray(NdArray<T, Dim> &&other) noexcept
+        : NdArrayBase<T, Dim, NdArray<T, Dim>>(other._shape), _order(other._order),
+          _external(std::move(other._external)) {
+        if (other.is_small()) {
+            this->_data = this->_small_buffer.data();
+            std::move(other._data, other._data + other._shape.size(), this->_data);
+        } else {
+            this->_data = other._data;
+            other._data = nullptr;
+        }
     }
 
+    /* Assigning an array of the same size to one using an external or mapped buffer, by copy or by move, writes into
+     * the buffer and keeps its layout. Otherwise the array takes the storage of a copy of other, or of other itself. */
     NdArray<T, Dim> &operator=(const NdArray<T, Dim> &other) {
         if (this != &other) {
-            delete[] this->_data;
-            this->_shape = other._shape;
-            this->_data = new T[other._shape.size()];
-            std::copy(other._data, other._data + other._shape.size(), this->_data);
+            if (this->_shape.size() != other._shape.size()) {
+                /* Copying first leaves this array unchanged if the allocation throws. */
+                this->take(NdArray<T, Dim>(other));
+            } else if (this->_external) {
+                this->_shape = other._shape;
+                other.copy_in_order(this->_data, this->_order);
+            } else {
+                this->_shape = other._shape;
+                this->_order = other._order;
+                std::copy(other._data, other._data + other._shape.size(), this->_data);
+            }
         }
 
         return *this;
@@ -82,15 +112,54 @@ public:
 
     NdArray<T, Dim> &operator=(NdArray<T, Dim> &&other) {
         if (this != &other) {
-            delete[] this->_data;
-            this->_shape = other._shape;
-            this->_data = other._data;
-            other._data = nullptr;
+            if (this->_external && this->_shape.size() == other._shape.size()) {
+                this->_shape = other._shape;
+                other.copy_in_order(this->_data, this->_order);
+            } else {
+                this->take(std::move(other));
+            }
         }
 
         return *this;
     }
 
+    /* External buffers ***********************************************************************************************/
+
+    /* Returns an array using data in place, which is released with deleter(data) when the array is destroyed or
+     * reallocated. Copies of the array own their own storage. */
+    template <typename Deleter = std::default_delete<T[]>>
+    static NdArray<T, Dim> adopt(const Shape<Dim> &shape, T *data, Deleter deleter = Deleter()) {
+        return adopt(shape, data, Order::C, std::move(deleter));
+    }
+
+    template <typename Deleter = std::default_delete<T[]>>
+    static NdArray<T, Dim> adopt(const Shape<Dim> &shape, T *data, Order order, Deleter deleter = Deleter()) {
+        return NdArray<T, Dim>(shape, data, order, std::shared_ptr<void>(data, [deleter](void *ptr) mutable {
+                                   deleter(static_cast<T *>(ptr));
+                               }));
+    }
+
+    /* Returns an array using data in place without taking ownership of it. If lifetime is given, the array keeps it
+     * alive, e.g. the buffer or message object data points into; otherwise data must outlive the array. Assigning an
+     * array of the same size to it writes to the buffer. */
+    static NdArray<T, Dim> borrow(const Shape<Dim> &shape, T *data, std::shared_ptr<const void> lifetime = nullptr) {
+        return borrow(shape, data, Order::C, std::move(lifetime));
+    }
+
+    /* Returns an uninitialized array whose buffer is allocated under the given policy instead of the global one. */
+    static NdArray<T, Dim> with_policy(const Shape<Dim> &shape, const MemoryPolicy &policy, Order order = Order::C) {
+        return NdArray<T, Dim>(shape, order, policy);
+    }
+
+    /* Borrows data laid out in the given order, e.g. a column-major matrix shared with Fortran code. */
+    static NdArray<T, Dim> borrow(const Shape<Dim> &shape, T *data, Order order,
+                                  std::shared_ptr<const void> lifetime = nullptr) {
+        if (!lifetime) {
+            lifetime = std::shared_ptr<const void>(data, [](const void *) {});
+        }
+        return NdArray<T, Dim>(shape, data, order, std::const_pointer_cast<void>(std::move(lifetime)));
+    }
+
     /* Indexing *******************************************************************************************************/
 
     template <typename... Args>
@@ -108,25 +177,15 @@ public:
     }
 
     T &operator[](const std::array<index_t, Dim> &indices) {
-        std::array<index_t, Dim> normalized_indices = util::normalize_indices(this->_shape, indices);
-
-        index_t index = 0;
-        for (std::size_t i = 0; i < Dim; ++i) {
-            index += normalized_indices[i] * this->_shape.partial[i];
-        }
-
-        return _data[index];
+        return _data[this->offset(util::normalize_indices(this->_shape, indices))];
     }
 
     const T &operator[](const std::array<index_t, Dim> &indices) const {
-        std::array<index_t, Dim> normalized_indices = util::normalize_indices(this->_shape, indices);
-
-        index_t index = 0;
-        for (std::size_t i = 0; i < Dim; ++i) {
-            index += normalized_indices[i] * this->_shape.partial[i];
-        }
+        return _data[this->offset(util::normalize_indices(this->_shape, indices))];
+    }
 
-        return _data[index];
+    NdArray<T, 1> operator[](const NdArrayMask<Dim> &mask) const {
+        return masked_select(*this, mask);
     }
 
     /* Slicing ********************************************************************************************************/
@@ -213,7 +272,7 @@ public:
 
     template <typename U>
     NdArray<U, Dim> as_type(void) const {
-        NdArray<U, Dim> result(this->_shape);
+        NdArray<U, Dim> result(this->_shape, this->_order);
 
         std::transform(this->_data, this->_data + this->_shape.size(), result._data,
                        [](const T &val) { return static_cast<U>(val); });
@@ -233,8 +292,11 @@ public:
         std::fill(this->_data, this->_data + this->size(), val);
     }
 
-    NdArray<T, 1> flatten(void) const {
-        return NdArray<T, 1>(Shape<1>({this->size()}), this->_data);
+    /* Returns the elements in the given order; this is a plain copy when it is the order of the array. */
+    NdArray<T, 1> flatten(Order order = Order::C) const {
+        NdArray<T, 1> result(Shape<1>({this->size()}));
+        this->copy_in_order(result._data, order);
+        return result;
     }
 
     T &item(index_t index) {
@@ -248,7 +310,7 @@ public:
             index += size;
         }
 
-        return this->_data[index];
+        return this->_data[this->_order == Order::C ? index : this->offset(index)];
     }
 
     const T &item(index_t index) const {
@@ -262,17 +324,30 @@ public:
             index += size;
         }
 
-        return this->_data[index];
+        return this->_data[this->_order == Order::C ? index : this->offset(index)];
     }
 
+    /* Reads the elements in the given order and writes them in that order into an array of that order, as in NumPy.
+     * When it is the order of the array, the elements are copied as they are. */
     template <std::size_t NewDim>
-    NdArray<T, NewDim> reshape(const Shape<NewDim> &new_shape) const {
+    NdArray<T, NewDim> reshape(const Shape<NewDim> &new_shape, Order order = Order::C) const {
         if (this->size() != new_shape.size()) {
             throw std::invalid_argument(
                 std::format("Cannot reshape array of size {} into shape {}", this->size(), new_shape.to_string()));
         }
 
-        return NdArray<T, NewDim>(new_shape, this->_data);
+        NdArray<T, NewDim> result(new_shape, order);
+        this->copy_in_order(result._data, order);
+        return result;
+    }
+
+    Order order(void) const {
+        return this->_order;
+    }
+
+    /* Distance in elements between consecutive elements along each axis. */
+    std::array<index_t, Dim> strides(void) const {
+        return util::order_strides(this->_shape, this->_order);
     }
 
 private:
@@ -281,12 +356,128 @@ private:
     template <typename, std::size_t, typename>
     friend class NdArraySlice;
 
+    static constexpr index_t small_size = SmallBufferSize<T>::value;
+
+    NdArray(const Shape<Dim> &shape, T *data, Order order, std::shared_ptr<void> external)
+        : NdArrayBase<T, Dim, NdArray<T, Dim>>(shape), _order(normalize_order(order)), _external(std::move(external)),
+          _data(data) {}
+
+    NdArray(const Shape<Dim> &shape, Order order, const MemoryPolicy &policy)
+        : NdArrayBase<T, Dim, NdArray<T, Dim>>(shape), _order(normalize_order(order)),
+          _data(allocate(shape.size(), policy)) {}
+
+    /* Both orders are the same for one-dimensional arrays, which are always reported as C-ordered. */
+    static Order normalize_order(Order order) {
+        return Dim > 1 ? order : Order::C;
+    }
+
+    /* Offset of the element at the given normalized indices. */
+    index_t offset(const std::array<index_t, Dim> &indices) const {
+        index_t offset = 0;
+        if (this->_order == Order::C) {
+            for (std::size_t i = 0; i < Dim; ++i) {
+                offset += indices[i] * this->_shape.partial[i];
+            }
+        } else {
+            index_t stride = 1;
+            for (std::size_t i = 0; i < Dim; ++i) {
+                offset += indices[i] * stride;
+                stride *= this->_shape[i];
+            }
+        }
+        return offset;
+    }
+
+    /* Offset of the index-th element in C order. */
+    index_t offset(index_t index) const {
+        std::array<index_t, Dim> indices;
+        util::unravel_index<Dim>(index, this->_shape, indices);
+        return this->offset(indices);
+    }
+
+    /* Copies the elements into dst, contiguously in the given order. */
+    void copy_in_order(T *dst, Order order) const {
+        util::strided_copy(dst, util::order_strides(this->_shape, order), static_cast<const T *>(this->_data),
+                           this->strides(), this->_shape);
+    }
+
+    /* Large buffers may be mapped under the memory policy, in which case _external owns the mapping. */
+    T *allocate(index_t size) {
+        if (small_size > 0 && size <= small_size) {
+            return this->_small_buffer.data();
+        }
+        return this->allocate(size, get_memory_policy());
+    }
+
+    T *allocate(index_t size, const MemoryPolicy &policy) {
+        if (small_size > 0 && size <= small_size) {
+            return this->_small_buffer.data();
+        }
+        if constexpr (util::is_mappable<T>) {
+            if (std::shared_ptr<void> pages = util::map_pages(size, sizeof(T), policy)) {
+                this->_external = std::move(pages);
+                return static_cast<T *>(this->_external.get());
+            }
+        }
+        return new T[size];
+    }
+
+    /* Releases the storage and takes that of other. */
+    void take(NdArray<T, Dim> &&other) noexcept {
+        this->deallocate();
+        this->_shape = other._shape;
+        this->_order = other._order;
+        this->_external = std::move(other._external);
+        if (other.is_small()) {
+            this->_data = this->_small_buffer.data();
+            std::move(other._data, other._data + other._shape.size(), this->_data);
+        } else {
+            this->_data = other._data;
+            other._data = nullptr;
+        }
+    }
+
+    void deallocate(void) {
+        if (this->_external) {
+            this->_external.reset();
+        } else if (!this->is_small()) {
+            delete[] this->_data;
+        }
+    }
+
+    bool is_small(void) const {
+        return small_size > 0 && this->_data == this->_small_buffer.data();
+    }
+
+    [[no_unique_address]] std::array<T, small_size> _small_buffer;
+    Order _order = Order::C;
+    /* Set when _data is an external or mapped buffer; releasing it releases the buffer. */
+    std::shared_ptr<void> _external;
     T *_data;
 };
 
 template <typename T>
 class NdArray<T, 0>;
 
+namespace util {
+
+template <typename T, std::size_t Dim>
+constexpr bool is_contiguous<NdArray<T, Dim>> = true;
+
+}  // namespace util
+
+/* Returns a view of the whole array that shares ownership of it, so that the array outlives the view and every view
+ * sliced from it. */
+template <typename T, std::size_t Dim>
+NdArraySlice<T, Dim, NdArray<T, Dim>> view(const std::shared_ptr<NdArray<T, Dim>> &arr) {
+    return {arr->data(), arr->shape(), arr->strides(), arr};
+}
+
+template <typename T, std::size_t Dim>
+NdArraySlice<T, Dim, const NdArray<T, Dim>> view(const std::shared_ptr<const NdArray<T, Dim>> &arr) {
+    return {arr->data(), arr->shape(), arr->strides(), arr};
+}
+
 }  // namespace ndarray
 
 #endif
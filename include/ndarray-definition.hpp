@@ -7,6 +7,9 @@ namespace ndarray {
 
 using index_t = std::ptrdiff_t;
 
+/* Memory layout of an array: row-major (C) or column-major (Fortran). */
+enum class Order { C, F };
+
 }  // namespace ndarray
 
 #endif
@@ -0,0 +1,323 @@
+#ifndef NDARRAY_FIXED_HPP
+#define NDARRAY_FIXED_HPP
+
+#include <algorithm>
+#include <array>
+
+#include "ndarray-base.hpp"
+#include "ndarray-core.hpp"
+#include "ndarray-op.hpp"
+#include "ndarray-shape.hpp"
+#include "ndarray-slice.hpp"
+
+namespace ndarray {
+
+template <typename T, index_t... Extents>
+class FixedNdArray;
+
+namespace util {
+
+template <typename T, index_t First, index_t... Rest>
+class FixedSubArray {
+public:
+    using type = FixedNdArray<T, Rest...>;
+};
+
+template <typename T, index_t First>
+class FixedSubArray<T, First> {
+public:
+    using type = T;
+};
+
+template <std::size_t Dim>
+constexpr std::array<index_t, Dim> c_strides(const std::array<index_t, Dim> &extents) {
+    std::array<index_t, Dim> strides;
+    strides[Dim - 1] = 1;
+    for (std::size_t i = Dim - 1; i > 0; --i) {
+        strides[i - 1] = strides[i] * extents[i];
+    }
+    return strides;
+}
+
+/* The shape of a fixed-size array is part of its type, so the array stores nothing but its elements. */
+template <std::size_t Dim, typename T, index_t... Extents>
+class ShapeHolder<Dim, FixedNdArray<T, Extents...>> {
+protected:
+    ShapeHolder() = default;
+
+    static constexpr Shape<Dim> _shape = Shape<Dim>(std::array<index_t, Dim>{Extents...});
+};
+
+}  // namespace util
+
+/* An array whose extents are fixed at compile time. The elements are stored inline, so small arrays such as 3x3 or 4x4
+ * matrices never touch the heap and element-wise operations between them run over a compile-time trip count. */
+template <typename T, index_t... Extents>
+class FixedNdArray : public NdArrayBase<T, sizeof...(Extents), FixedNdArray<T, Extents...>> {
+public:
+    static_assert(sizeof...(Extents) > 0, "FixedNdArray must have at least one dimension");
+    static_assert(((Extents > 0) && ...), "Extents of FixedNdArray must be positive");
+
+    static constexpr std::size_t Dim = sizeof...(Extents);
+    static constexpr std::array<index_t, Dim> extents = {Extents...};
+    static constexpr std::array<index_t, Dim> strides = util::c_strides<Dim>(extents);
+    static constexpr index_t fixed_size = (Extents * ...);
+    static constexpr Shape<Dim> fixed_shape = Shape<Dim>(extents);
+
+    FixedNdArray(void) = default;
+
+    FixedNdArray(const std::initializer_list<typename util::FixedSubArray<T, Extents...>::type> &list) {
+        if (static_cast<index_t>(list.size()) != extents[0]) {
+            throw std::invalid_argument("Invalid length of initializer list");
+        }
+
+        if constexpr (Dim == 1) {
+            std::copy(list.begin(), list.end(), this->_data.begin());
+        } else {
+            auto data_ptr = this->_data.begin();
+            for (const auto &sub_array : list) {
+                data_ptr = std::copy(sub_array._data.begin(), sub_array._data.end(), data_ptr);
+            }
+        }
+    }
+
+    explicit FixedNdArray(const T *data) {
+        std::copy(data, data + fixed_size, this->_data.begin());
+    }
+
+    template <typename Derived>
+    explicit FixedNdArray(const NdArrayBase<T, Dim, Derived> &other) {
+        util::validate_shape_binary_op(fixed_shape, other.shape());
+
+        if constexpr (util::is_strided<Derived>) {
+            const Derived &derived = static_cast<const Derived &>(other);
+            util::strided_copy(this->_data.data(), util::contiguous_strides(fixed_shape),
+                               static_cast<const T *>(derived.data()), util::strides_of(derived), fixed_shape);
+        } else {
+            auto in = util::element_reader(other);
+            for (index_t i = 0; i < fixed_size; ++i) {
+                this->_data[i] = in(i);
+            }
+        }
+    }
+
+    operator NdArray<T, Dim>() const {
+        return NdArray<T, Dim>(fixed_shape, this->_data.data());
+    }
+
+    /* Indexing *******************************************************************************************************/
+
+    template <typename... Args>
+        requires(sizeof...(Args) == Dim && (util::is_index_type<Args> && ...))
+    T &operator[](Args... args) {
+        std::array<index_t, Dim> arg_array = {static_cast<index_t>(args)...};
+        return this->operator[](arg_array);
+    }
+
+    template <typename... Args>
+        requires(sizeof...(Args) == Dim && (util::is_index_type<Args> && ...))
+    const T &operator[](Args... args) const {
+        std::array<index_t, Dim> arg_array = {static_cast<index_t>(args)...};
+        return this->operator[](arg_array);
+    }
+
+    T &operator[](const std::array<index_t, Dim> &indices) {
+        return this->_data[offset(indices)];
+    }
+
+    const T &operator[](const std::array<index_t, Dim> &indices) const {
+        return this->_data[offset(indices)];
+    }
+
+    /* Slicing ********************************************************************************************************/
+
+    template <typename... Args>
+        requires(sizeof...(Args) <= Dim && (util::is_index_slice_type<Args> && ...) &&
+                 !(sizeof...(Args) == Dim && (util::is_index_type<Args> && ...)))
+    NdArraySlice<T, util::count_slice_type<Args...> + Dim - sizeof...(Args), FixedNdArray<T, Extents...>> operator[](
+        Args... args) {
+        static constexpr std::size_t NIndices = sizeof...(Args) - util::count_slice_type<Args...>;
+        static constexpr std::size_t NSlices = util::count_slice_type<Args...> + Dim - sizeof...(Args);
+
+        std::array<bool, Dim> is_slice_axis;
+        std::array<index_t, NIndices> indices;
+        std::array<Slice, NSlices> slices;
+
+        index_t i = 0;
+        ((is_slice_axis[i++] = util::is_slice_type<Args>), ...);
+        for (std::size_t i = sizeof...(Args); i < Dim; ++i) {
+            is_slice_axis[i] = true;
+        }
+
+        util::separate_index_slice<NIndices, NSlices, Args...>(indices.begin(), slices.begin(), args...);
+
+        util::normalize_indices_slices<NIndices, NSlices>(fixed_shape, is_slice_axis, indices, slices);
+
+        return {*this, is_slice_axis, indices, slices};
+    }
+
+    template <typename... Args>
+        requires(sizeof...(Args) <= Dim && (util::is_index_slice_type<Args> && ...) &&
+                 !(sizeof...(Args) == Dim && (util::is_index_type<Args> && ...)))
+    const NdArraySlice<T, util::count_slice_type<Args...> + Dim - sizeof...(Args), const FixedNdArray<T, Extents...>>
+    operator[](Args... args) const {
+        static constexpr std::size_t NIndices = sizeof...(Args) - util::count_slice_type<Args...>;
+        static constexpr std::size_t NSlices = util::count_slice_type<Args...> + Dim - sizeof...(Args);
+
+        std::array<bool, Dim> is_slice_axis;
+        std::array<index_t, NIndices> indices;
+        std::array<Slice, NSlices> slices;
+
+        index_t i = 0;
+        ((is_slice_axis[i++] = util::is_slice_type<Args>), ...);
+        for (std::size_t i = sizeof...(Args); i < Dim; ++i) {
+            is_slice_axis[i] = true;
+        }
+
+        util::separate_index_slice<NIndices, NSlices, Args...>(indices.begin(), slices.begin(), args...);
+
+        util::normalize_indices_slices<NIndices, NSlices>(fixed_shape, is_slice_axis, indices, slices);
+
+        return {*this, is_slice_axis, indices, slices};
+    }
+
+    /* Assignment *****************************************************************************************************/
+
+    FixedNdArray<T, Extents...> &operator=(const NdArray<T, Dim> &other) {
+        util::validate_shape_binary_op(fixed_shape, other.shape());
+        util::strided_copy(this->_data.data(), strides, other.data(), other.strides(), fixed_shape);
+        return *this;
+    }
+
+    FixedNdArray<T, Extents...> &operator=(const T &val) {
+        this->fill(val);
+        return *this;
+    }
+
+    /* Method *********************************************************************************************************/
+
+    bool all(void) const {
+        return std::all_of(this->_data.begin(), this->_data.end(), [](const T &val) { return val; });
+    }
+
+    bool any(void) const {
+        return std::any_of(this->_data.begin(), this->_data.end(), [](const T &val) { return val; });
+    }
+
+    template <typename U>
+    FixedNdArray<U, Extents...> as_type(void) const {
+        FixedNdArray<U, Extents...> result;
+        for (index_t i = 0; i < fixed_size; ++i) {
+            result._data[i] = static_cast<U>(this->_data[i]);
+        }
+        return result;
+    }
+
+    T *data(void) {
+        return this->_data.data();
+    }
+
+    const T *data(void) const {
+        return this->_data.data();
+    }
+
+    void fill(const T &val) {
+        this->_data.fill(val);
+    }
+
+    NdArray<T, 1> flatten(void) const {
+        return NdArray<T, 1>(Shape<1>({fixed_size}), this->_data.data());
+    }
+
+    T &item(index_t index) {
+        return this->_data[normalize_item_index(index)];
+    }
+
+    const T &item(index_t index) const {
+        return this->_data[normalize_item_index(index)];
+    }
+
+    template <std::size_t NewDim>
+    NdArray<T, NewDim> reshape(const Shape<NewDim> &new_shape) const {
+        if (fixed_size != new_shape.size()) {
+            throw std::invalid_argument(
+                std::format("Cannot reshape array of size {} into shape {}", fixed_size, new_shape.to_string()));
+        }
+
+        return NdArray<T, NewDim>(new_shape, this->_data.data());
+    }
+
+    template <index_t... NewExtents>
+    FixedNdArray<T, NewExtents...> reshape(void) const {
+        static_assert((NewExtents * ...) == fixed_size, "Cannot reshape array into a shape of different size");
+
+        return FixedNdArray<T, NewExtents...>(this->_data.data());
+    }
+
+    static constexpr const Shape<Dim> &shape(void) {
+        return fixed_shape;
+    }
+
+    static constexpr index_t size(void) {
+        return fixed_size;
+    }
+
+private:
+    template <typename, index_t...>
+    friend class FixedNdArray;
+    template <typename, std::size_t, typename>
+    friend class NdArraySlice;
+
+    static index_t offset(const std::array<index_t, Dim> &indices) {
+        std::array<index_t, Dim> normalized_indices = util::normalize_indices(fixed_shape, indices);
+
+        index_t index = 0;
+        for (std::size_t i = 0; i < Dim; ++i) {
+            index += normalized_indices[i] * strides[i];
+        }
+        return index;
+    }
+
+    static index_t normalize_item_index(index_t index) {
+        if (index < -fixed_size || index >= fixed_size) {
+            throw std::out_of_range(std::format("Index {} is out of bounds for size {}", index, fixed_size));
+        }
+
+        return index < 0 ? index + fixed_size : index;
+    }
+
+    std::array<T, fixed_size> _data;
+};
+
+namespace util {
+
+template <typename T, index_t... Extents>
+constexpr bool is_contiguous<FixedNdArray<T, Extents...>> = true;
+
+/* Element-wise operations and comparisons between fixed-size arrays of the same extents, or between one of them and a
+ * scalar, return fixed-size arrays. */
+
+template <typename R, std::size_t Dim, typename T, index_t... Extents>
+class ResultArray<R, Dim, FixedNdArray<T, Extents...>> {
+public:
+    using type = FixedNdArray<R, Extents...>;
+};
+
+template <typename R, std::size_t Dim, typename T1, typename T2, index_t... Extents>
+class ResultArray<R, Dim, FixedNdArray<T1, Extents...>, FixedNdArray<T2, Extents...>> {
+public:
+    using type = FixedNdArray<R, Extents...>;
+};
+
+template <std::size_t Dim, typename... Deriveds>
+    requires(is_fixed_size<result_array_t<bool, Dim, Deriveds...>>)
+class ResultMask<Dim, Deriveds...> {
+public:
+    using type = result_array_t<bool, Dim, Deriveds...>;
+};
+
+}  // namespace util
+
+}  // namespace ndarray
+
+#endif
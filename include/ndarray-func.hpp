@@ -1,21 +1,48 @@
 #ifndef NDARRAY_FUNC_HPP
 #define NDARRAY_FUNC_HPP
 
+#include <cmath>
+#include <concepts>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
 #include "ndarray-core.hpp"
+#include "ndarray-op.hpp"
+#include "ndarray-parallel.hpp"
 #include "ndarray-slice.hpp"
 
 namespace ndarray {
 
-template <typename T>
-NdArray<T, 1> arange(index_t stop) {
-    return arange<T>(0, stop, 1);
+namespace util {
+
+/* Writes f(i) to data[i] for each i in [0, size), in parallel for large sizes. Each thread runs a plain loop of stores,
+ * which the compiler vectorizes when f is simple arithmetic on i. */
+template <typename T, typename F>
+void generate_elements(T* data, index_t size, F f) {
+    parallel_for(0, size, parallel_grain_size, [data, &f](index_t first, index_t last) {
+        for (index_t i = first; i < last; ++i) {
+            data[i] = f(i);
+        }
+    });
 }
 
-template <typename T>
-NdArray<T, 1> arange(T start, T stop) {
-    return arange<T>(start, stop, 1);
+/* View of values repeated along every axis of shape except axis, which it spans with stride 1; the other axes have
+ * stride 0. The view shares ownership of values. */
+template <typename T, std::size_t Dim>
+NdArraySlice<T, Dim, const NdArray<T, 1>> broadcast_along(std::shared_ptr<const NdArray<T, 1>> values,
+                                                          const Shape<Dim>& shape, std::size_t axis) {
+    std::array<index_t, Dim> strides{};
+    strides[axis] = 1;
+    const T* data = values->data();
+    return NdArraySlice<T, Dim, const NdArray<T, 1>>(data, shape, strides, std::move(values));
 }
 
+}  // namespace util
+
+/* Ranges *************************************************************************************************************/
+
 template <typename T>
 NdArray<T, 1> arange(index_t start, index_t stop, index_t step) {
     index_t size;
@@ -27,28 +54,158 @@ NdArray<T, 1> arange(index_t start, index_t stop, index_t step) {
     } else {
         size = (start - stop - step - 1) / (-step);
     }
+    size = std::max<index_t>(size, 0);
+
+    NdArray<T, 1> result(Shape<1>({size}));
+    util::generate_elements(result.data(), size, [start, step](index_t i) { return static_cast<T>(start + i * step); });
+    return result;
+}
 
-    NdArray<T, 1> result(Shape({size}));
-    for (index_t i = 0; i < size; ++i) {
-        result[i] = start + i * step;
+template <typename T>
+NdArray<T, 1> arange(index_t stop) {
+    return arange<T>(0, stop, 1);
+}
+
+template <typename T>
+NdArray<T, 1> arange(T start, T stop) {
+    return arange<T>(start, stop, 1);
+}
+
+/* num evenly spaced values from start to stop, including stop unless endpoint is false. */
+template <std::floating_point T = double>
+NdArray<T, 1> linspace(std::type_identity_t<T> start, std::type_identity_t<T> stop, index_t num, bool endpoint = true) {
+    if (num < 0) {
+        throw std::invalid_argument(std::format("linspace() number of samples {} is negative", num));
+    }
+
+    const index_t divisions = endpoint ? num - 1 : num;
+    const T step = divisions > 0 ? (stop - start) / static_cast<T>(divisions) : T(0);
+    NdArray<T, 1> result(Shape<1>({num}));
+    util::generate_elements(result.data(), num, [start, step](index_t i) { return start + static_cast<T>(i) * step; });
+    if (endpoint && num > 1) {
+        result.data()[num - 1] = stop;
     }
     return result;
 }
 
+/* num values spaced evenly on a log scale, from base^start to base^stop. */
+template <std::floating_point T = double>
+NdArray<T, 1> logspace(std::type_identity_t<T> start, std::type_identity_t<T> stop, index_t num, bool endpoint = true,
+                       std::type_identity_t<T> base = 10) {
+    NdArray<T, 1> result = linspace<T>(start, stop, num, endpoint);
+    T* data = result.data();
+    util::generate_elements(data, num, [data, base](index_t i) { return std::pow(base, data[i]); });
+    return result;
+}
+
+/* Filled arrays ******************************************************************************************************/
+
 template <typename T, std::size_t Dim>
-NdArray<T, Dim> ones(const Shape<Dim>& shape) {
+NdArray<T, Dim> full(const Shape<Dim>& shape, const T& value) {
     NdArray<T, Dim> result(shape);
-    result.fill(1);
+    util::generate_elements(result.data(), result.size(), [&value](index_t) { return value; });
     return result;
 }
 
+template <typename T, std::size_t Dim>
+NdArray<T, Dim> ones(const Shape<Dim>& shape) {
+    return full<T>(shape, T(1));
+}
+
 template <typename T, std::size_t Dim>
 NdArray<T, Dim> zeros(const Shape<Dim>& shape) {
-    NdArray<T, Dim> result(shape);
-    result.fill(0);
+    return full<T>(shape, T(0));
+}
+
+/* Matrix of the given size with ones on the k-th diagonal, above the main one for positive k, and zeros elsewhere. */
+template <typename T>
+NdArray<T, 2> eye(index_t rows, index_t cols, index_t k = 0) {
+    NdArray<T, 2> result = zeros<T>(Shape<2>({rows, cols}));
+    T* data = result.data();
+    for (index_t i = std::max<index_t>(0, -k); i < rows && i + k < cols; ++i) {
+        data[i * cols + i + k] = T(1);
+    }
     return result;
 }
 
+template <typename T>
+NdArray<T, 2> eye(index_t n) {
+    return eye<T>(n, n);
+}
+
+/* Uninitialized array with the shape and memory order of arr. */
+template <typename T, std::size_t Dim, typename Derived>
+NdArray<T, Dim> empty_like(const NdArrayBase<T, Dim, Derived>& arr) {
+    return NdArray<T, Dim>(arr.shape(), util::layout_order(arr));
+}
+
+template <typename T, std::size_t Dim, typename Derived>
+NdArray<T, Dim> full_like(const NdArrayBase<T, Dim, Derived>& arr, const T& value) {
+    NdArray<T, Dim> result = empty_like(arr);
+    util::generate_elements(result.data(), result.size(), [&value](index_t) { return value; });
+    return result;
+}
+
+template <typename T, std::size_t Dim, typename Derived>
+NdArray<T, Dim> ones_like(const NdArrayBase<T, Dim, Derived>& arr) {
+    return full_like(arr, T(1));
+}
+
+template <typename T, std::size_t Dim, typename Derived>
+NdArray<T, Dim> zeros_like(const NdArrayBase<T, Dim, Derived>& arr) {
+    return full_like(arr, T(0));
+}
+
+/* Grids **************************************************************************************************************/
+
+/* Axis order of the grids returned by meshgrid(): xy swaps the first two axes as for Cartesian coordinates, and ij
+ * follows the order of the arguments as for matrix indices. */
+enum class Indexing { xy, ij };
+
+/* Coordinate grids of the one-dimensional arrays, one per array. The grids are read-only views that repeat a copy of
+ * each array with stride 0 along the other axes, so building them costs no more than copying the arrays; they can be
+ * used in any operation and materialized by converting them to NdArray. */
+template <typename... Arrays>
+    requires(sizeof...(Arrays) > 0 && ((Arrays::dim == 1) && ...))
+auto meshgrid(Indexing indexing, const Arrays&... arrays) {
+    constexpr std::size_t Dim = sizeof...(Arrays);
+    std::array<index_t, Dim> extents = {arrays.shape()[0]...};
+    bool swap = false;
+    if constexpr (Dim > 1) {
+        swap = indexing == Indexing::xy;
+        if (swap) {
+            std::swap(extents[0], extents[1]);
+        }
+    }
+    const Shape<Dim> shape(extents);
+
+    std::size_t k = 0;
+    auto grid = [&](const auto& arr) {
+        using T = typename std::remove_cvref_t<decltype(arr)>::dtype;
+        const std::size_t axis = swap && k < 2 ? 1 - k : k;
+        ++k;
+        return util::broadcast_along<T, Dim>(std::make_shared<const NdArray<T, 1>>(util::materialize(arr)), shape,
+                                             axis);
+    };
+    return std::tuple{grid(arrays)...};
+}
+
+template <typename... Arrays>
+    requires(sizeof...(Arrays) > 0 && ((Arrays::dim == 1) && ...))
+auto meshgrid(const Arrays&... arrays) {
+    return meshgrid(Indexing::xy, arrays...);
+}
+
+/* Index grids of an array of the given shape: the k-th grid holds the index along axis k of each element. Like the
+ * grids of meshgrid(), they are read-only views that only store one range per axis. */
+template <typename T = index_t, std::size_t Dim>
+std::array<NdArraySlice<T, Dim, const NdArray<T, 1>>, Dim> indices(const Shape<Dim>& shape) {
+    return [&]<std::size_t... Axes>(std::index_sequence<Axes...>) {
+        return std::array{util::broadcast_along<T, Dim>(std::make_shared<const NdArray<T, 1>>(arange<T>(shape[Axes])),
+                                                        shape, Axes)...};
+    }(std::make_index_sequence<Dim>());
+}
+
 }  // namespace ndarray
 
 #endif
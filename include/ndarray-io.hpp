@@ -0,0 +1,482 @@
+#ifndef NDARRAY_IO_HPP
+#define NDARRAY_IO_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "ndarray-core.hpp"
+#include "ndarray-definition.hpp"
+#include "ndarray-op.hpp"
+#include "ndarray-parallel.hpp"
+
+namespace ndarray {
+
+/* How save() encodes an array. The elements are split into chunks of about chunk_bytes bytes, which are filtered and
+ * compressed independently and in parallel.
+ *
+ * - delta: each element is replaced by its difference from the previous one in the chunk, computed on the bits of the
+ *   element as an unsigned integer. This turns slowly varying integers into small values. Only elements of 1, 2, 4 or 8
+ *   bytes can be delta-encoded.
+ * - shuffle: the bytes of the elements are regrouped by significance, first byte of every element first, so that the
+ *   mostly constant high bytes of integers and exponents of floats form long runs.
+ *
+ * Chunks are then compressed with a built-in LZ77 codec, and stored as is when that does not make them smaller. */
+class Compression {
+public:
+    bool delta = false;
+    bool shuffle = true;
+    std::size_t chunk_bytes = std::size_t(1) << 20;
+};
+
+namespace util {
+
+/* LZ codec ***********************************************************************************************************/
+
+/* Byte-oriented LZ77 in the style of LZ4. The stream is a sequence of a token byte, literals and a match: the high
+ * nibble of the token is the literal count and the low nibble the match length minus 4, with 15 meaning that more
+ * length bytes follow (each adding its value, until one is below 255). The match is a 2-byte little-endian offset back
+ * into the output. The last sequence has literals only. */
+constexpr std::size_t lz_min_match = 4;
+constexpr std::size_t lz_max_offset = 65535;
+constexpr int lz_hash_bits = 14;
+
+inline std::uint32_t lz_read32(const std::uint8_t *ptr) {
+    std::uint32_t value;
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+inline void lz_write_length(std::vector<std::uint8_t> &out, std::size_t length) {
+    for (; length >= 255; length -= 255) {
+        out.push_back(255);
+    }
+    out.push_back(static_cast<std::uint8_t>(length));
+}
+
+inline void lz_write_literals(std::vector<std::uint8_t> &out, const std::uint8_t *literals, std::size_t count,
+                              std::uint8_t match_nibble) {
+    out.push_back(static_cast<std::uint8_t>((std::min<std::size_t>(count, 15) << 4) | match_nibble));
+    if (count >= 15) {
+        lz_write_length(out, count - 15);
+    }
+    out.insert(out.end(), literals, literals + count);
+}
+
+/* Compresses size bytes of src into out. Returns false, leaving out unspecified, if the result is not smaller than
+ * the input. */
+inline bool lz_compress(const std::uint8_t *src, std::size_t size, std::vector<std::uint8_t> &out) {
+    out.clear();
+    out.reserve(size);
+    std::vector<std::uint32_t> table(std::size_t(1) << lz_hash_bits, 0);
+
+    std::size_t anchor = 0;
+    std::size_t pos = 0;
+    while (size >= lz_min_match && pos <= size - lz_min_match) {
+        const std::uint32_t sequence = lz_read32(src + pos);
+        const std::uint32_t hash = (sequence * 2654435761u) >> (32 - lz_hash_bits);
+        const std::size_t candidate = table[hash];
+        table[hash] = static_cast<std::uint32_t>(pos);
+
+        if (candidate < pos && pos - candidate <= lz_max_offset && lz_read32(src + candidate) == sequence) {
+            std::size_t length = lz_min_match;
+            while (pos + length < size && src[candidate + length] == src[pos + length]) {
+                ++length;
+            }
+
+            const std::size_t extra = length - lz_min_match;
+            const std::size_t offset = pos - candidate;
+            lz_write_literals(out, src + anchor, pos - anchor,
+                              static_cast<std::uint8_t>(std::min<std::size_t>(extra, 15)));
+            out.push_back(static_cast<std::uint8_t>(offset));
+            out.push_back(static_cast<std::uint8_t>(offset >> 8));
+            if (extra >= 15) {
+                lz_write_length(out, extra - 15);
+            }
+
+            pos += length;
+            anchor = pos;
+            if (out.size() >= size) {
+                return false;
+            }
+        } else {
+            /* Skip faster through data that does not compress. */
+            pos += 1 + ((pos - anchor) >> 6);
+        }
+    }
+
+    lz_write_literals(out, src + anchor, size - anchor, 0);
+    return out.size() < size;
+}
+
+/* Decompresses size bytes of src into exactly dst_size bytes of dst. Throws std::runtime_error if src is corrupt. */
+inline void lz_decompress(const std::uint8_t *src, std::size_t size, std::uint8_t *dst, std::size_t dst_size) {
+    std::size_t ip = 0;
+    std::size_t op = 0;
+    auto read_length = [&](std::size_t length) {
+        if (length == 15) {
+            std::uint8_t byte;
+            do {
+                if (ip >= size) {
+                    throw std::runtime_error("Corrupt compressed data: truncated length");
+                }
+                byte = src[ip++];
+                length += byte;
+            } while (byte == 255);
+        }
+        return length;
+    };
+
+    while (ip < size) {
+        const std::uint8_t token = src[ip++];
+        const std::size_t literals = read_length(token >> 4);
+        if (literals > size - ip || literals > dst_size - op) {
+            throw std::runtime_error("Corrupt compressed data: literals out of bounds");
+        }
+        std::memcpy(dst + op, src + ip, literals);
+        ip += literals;
+        op += literals;
+        if (ip == size) {
+            break;
+        }
+
+        if (size - ip < 2) {
+            throw std::runtime_error("Corrupt compressed data: truncated offset");
+        }
+        const std::size_t offset = src[ip] | (static_cast<std::size_t>(src[ip + 1]) << 8);
+        ip += 2;
+        const std::size_t length = read_length(token & 15) + lz_min_match;
+        if (offset == 0 || offset > op || length > dst_size - op) {
+            throw std::runtime_error("Corrupt compressed data: match out of bounds");
+        }
+        /* Matches may overlap their own output, which repeats the last offset bytes. */
+        if (offset >= length) {
+            std::memcpy(dst + op, dst + op - offset, length);
+        } else {
+            for (std::size_t i = 0; i < length; ++i) {
+                dst[op + i] = dst[op + i - offset];
+            }
+        }
+        op += length;
+    }
+
+    if (op != dst_size) {
+        throw std::runtime_error("Corrupt compressed data: wrong decompressed size");
+    }
+}
+
+/* Filters ************************************************************************************************************/
+
+/* Regroups the bytes of count elements of elem_size bytes by their position in the element. */
+inline void shuffle_bytes(const std::uint8_t *src, std::uint8_t *dst, std::size_t count, std::size_t elem_size) {
+    for (std::size_t b = 0; b < elem_size; ++b) {
+        for (std::size_t i = 0; i < count; ++i) {
+            dst[b * count + i] = src[i * elem_size + b];
+        }
+    }
+}
+
+inline void unshuffle_bytes(const std::uint8_t *src, std::uint8_t *dst, std::size_t count, std::size_t elem_size) {
+    for (std::size_t b = 0; b < elem_size; ++b) {
+        for (std::size_t i = 0; i < count; ++i) {
+            dst[i * elem_size + b] = src[b * count + i];
+        }
+    }
+}
+
+template <std::unsigned_integral U>
+void delta_encode(std::uint8_t *data, std::size_t count) {
+    U prev = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        U value;
+        std::memcpy(&value, data + i * sizeof(U), sizeof(U));
+        const U diff = static_cast<U>(value - prev);
+        std::memcpy(data + i * sizeof(U), &diff, sizeof(U));
+        prev = value;
+    }
+}
+
+template <std::unsigned_integral U>
+void delta_decode(std::uint8_t *data, std::size_t count) {
+    U sum = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        U diff;
+        std::memcpy(&diff, data + i * sizeof(U), sizeof(U));
+        sum = static_cast<U>(sum + diff);
+        std::memcpy(data + i * sizeof(U), &sum, sizeof(U));
+    }
+}
+
+/* Calls f with a value of the unsigned integer type of elem_size bytes. */
+template <typename F>
+void with_unsigned_of_size(std::size_t elem_size, F f) {
+    switch (elem_size) {
+        case 1:
+            return f(std::uint8_t{});
+        case 2:
+            return f(std::uint16_t{});
+        case 4:
+            return f(std::uint32_t{});
+        case 8:
+            return f(std::uint64_t{});
+        default:
+            throw std::invalid_argument(std::format("Cannot delta-encode elements of {} bytes", elem_size));
+    }
+}
+
+/* Chunks *************************************************************************************************************/
+
+constexpr std::uint8_t filter_delta = 1;
+constexpr std::uint8_t filter_shuffle = 2;
+
+/* Filters and compresses count elements of elem_size bytes into out. The chunk is stored uncompressed, so that out
+ * has exactly count * elem_size bytes, if compression does not make it smaller. */
+inline void encode_chunk(const std::uint8_t *data, std::size_t count, std::size_t elem_size, std::uint8_t filters,
+                         std::vector<std::uint8_t> &out) {
+    const std::size_t bytes = count * elem_size;
+    std::vector<std::uint8_t> filtered(data, data + bytes);
+    if (filters & filter_delta) {
+        with_unsigned_of_size(elem_size, [&]<typename U>(U) { delta_encode<U>(filtered.data(), count); });
+    }
+    if ((filters & filter_shuffle) && elem_size > 1) {
+        std::vector<std::uint8_t> shuffled(bytes);
+        shuffle_bytes(filtered.data(), shuffled.data(), count, elem_size);
+        filtered.swap(shuffled);
+    }
+    if (!lz_compress(filtered.data(), bytes, out)) {
+        out.swap(filtered);
+    }
+}
+
+/* Inverse of encode_chunk(): decodes size bytes of src into count elements of elem_size bytes at dst. */
+inline void decode_chunk(const std::uint8_t *src, std::size_t size, std::uint8_t *dst, std::size_t count,
+                         std::size_t elem_size, std::uint8_t filters) {
+    const std::size_t bytes = count * elem_size;
+    const bool shuffled = (filters & filter_shuffle) && elem_size > 1;
+    std::vector<std::uint8_t> buffer(shuffled ? bytes : 0);
+    std::uint8_t *target = shuffled ? buffer.data() : dst;
+
+    if (size == bytes) {
+        std::memcpy(target, src, bytes);
+    } else {
+        lz_decompress(src, size, target, bytes);
+    }
+    if (shuffled) {
+        unshuffle_bytes(buffer.data(), dst, count, elem_size);
+    }
+    if (filters & filter_delta) {
+        with_unsigned_of_size(elem_size, [&]<typename U>(U) { delta_decode<U>(dst, count); });
+    }
+}
+
+/* Container format ***************************************************************************************************/
+
+/* Kind of element recorded in the header so that load() can check the requested type. */
+template <typename T>
+constexpr std::uint8_t dtype_kind = std::same_as<T, bool>      ? 1
+                                    : std::floating_point<T>   ? 2
+                                    : std::signed_integral<T>  ? 3
+                                    : std::unsigned_integral<T> ? 4
+                                                                : 0;
+
+constexpr std::array<char, 4> container_magic = {'N', 'D', 'A', 'Z'};
+constexpr std::uint8_t container_version = 1;
+
+/* Fixed part of the header, followed by the Dim extents, the chunk length in elements, the number of chunks, the
+ * stored size of each chunk and the chunks themselves. All integers are in the byte order recorded in big_endian,
+ * which must be the native one to load the array. */
+class ContainerHeader {
+public:
+    std::array<char, 4> magic = container_magic;
+    std::uint8_t version = container_version;
+    std::uint8_t big_endian = std::endian::native == std::endian::big;
+    std::uint8_t kind = 0;
+    std::uint8_t elem_size = 0;
+    std::uint8_t dim = 0;
+    std::uint8_t order = 0;
+    std::uint8_t filters = 0;
+    std::uint8_t reserved = 0;
+};
+
+template <typename V>
+void write_value(std::ostream &os, const V &value) {
+    os.write(reinterpret_cast<const char *>(&value), sizeof(V));
+}
+
+template <typename V>
+V read_value(std::istream &is) {
+    V value;
+    if (!is.read(reinterpret_cast<char *>(&value), sizeof(V))) {
+        throw std::runtime_error("Unexpected end of stream");
+    }
+    return value;
+}
+
+inline std::uint8_t compression_filters(const Compression &compression, std::size_t elem_size) {
+    std::uint8_t filters = 0;
+    if (compression.delta) {
+        with_unsigned_of_size(elem_size, [](auto) {});
+        filters |= filter_delta;
+    }
+    if (compression.shuffle) {
+        filters |= filter_shuffle;
+    }
+    return filters;
+}
+
+template <typename T, std::size_t Dim>
+void save_buffer(std::ostream &os, const T *data, const Shape<Dim> &shape, Order order,
+                 const Compression &compression) {
+    ContainerHeader header;
+    header.kind = dtype_kind<T>;
+    header.elem_size = static_cast<std::uint8_t>(sizeof(T));
+    header.dim = static_cast<std::uint8_t>(Dim);
+    header.order = static_cast<std::uint8_t>(order);
+    header.filters = compression_filters(compression, sizeof(T));
+
+    const std::size_t size = static_cast<std::size_t>(shape.size());
+    const std::size_t chunk_elements = std::max<std::size_t>(1, compression.chunk_bytes / sizeof(T));
+    const std::size_t num_chunks = (size + chunk_elements - 1) / chunk_elements;
+
+    std::vector<std::vector<std::uint8_t>> chunks(num_chunks);
+    const std::uint8_t *bytes = reinterpret_cast<const std::uint8_t *>(data);
+    parallel_for(0, static_cast<index_t>(num_chunks), 1, [&](index_t first, index_t last) {
+        for (index_t c = first; c < last; ++c) {
+            const std::size_t begin = static_cast<std::size_t>(c) * chunk_elements;
+            const std::size_t count = std::min(chunk_elements, size - begin);
+            encode_chunk(bytes + begin * sizeof(T), count, sizeof(T), header.filters, chunks[c]);
+        }
+    });
+
+    write_value(os, header);
+    for (std::size_t i = 0; i < Dim; ++i) {
+        write_value<std::int64_t>(os, shape[i]);
+    }
+    write_value<std::uint64_t>(os, chunk_elements);
+    write_value<std::uint64_t>(os, num_chunks);
+    for (const std::vector<std::uint8_t> &chunk : chunks) {
+        write_value<std::uint64_t>(os, chunk.size());
+    }
+    for (const std::vector<std::uint8_t> &chunk : chunks) {
+        os.write(reinterpret_cast<const char *>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+    }
+    if (!os) {
+        throw std::runtime_error("Failed to write array");
+    }
+}
+
+}  // namespace util
+
+/* Saving and loading *************************************************************************************************/
+
+/* Writes arr to os in a compressed binary container. NdArrays are saved in their memory order; other arrays are saved
+ * in C order. */
+template <typename T, std::size_t Dim, typename Derived>
+    requires std::is_trivially_copyable_v<T>
+void save(std::ostream &os, const NdArrayBase<T, Dim, Derived> &arr, const Compression &compression = Compression()) {
+    if constexpr (util::is_contiguous<Derived>) {
+        util::save_buffer(os, static_cast<const Derived &>(arr).data(), arr.shape(), util::layout_order(arr),
+                          compression);
+    } else {
+        const NdArray<T, Dim> contiguous = util::materialize(arr);
+        util::save_buffer(os, contiguous.data(), arr.shape(), Order::C, compression);
+    }
+}
+
+template <typename T, std::size_t Dim, typename Derived>
+    requires std::is_trivially_copyable_v<T>
+void save(const std::string &path, const NdArrayBase<T, Dim, Derived> &arr,
+          const Compression &compression = Compression()) {
+    std::ofstream os(path, std::ios::binary);
+    if (!os) {
+        throw std::runtime_error(std::format("Cannot open {} for writing", path));
+    }
+    save(os, arr, compression);
+}
+
+/* Reads an array written by save(). Throws std::runtime_error if the stream does not hold an array of type T and
+ * dimension Dim or is corrupt. */
+template <typename T, std::size_t Dim>
+    requires std::is_trivially_copyable_v<T>
+NdArray<T, Dim> load(std::istream &is) {
+    const util::ContainerHeader header = util::read_value<util::ContainerHeader>(is);
+    if (header.magic != util::container_magic || header.version != util::container_version) {
+        throw std::runtime_error("Not an array container");
+    }
+    if (header.big_endian != (std::endian::native == std::endian::big)) {
+        throw std::runtime_error("Array container has a different byte order");
+    }
+    if (header.kind != util::dtype_kind<T> || header.elem_size != sizeof(T) || header.dim != Dim) {
+        throw std::runtime_error(std::format("Array container holds {}-dimensional elements of {} bytes", header.dim,
+                                             header.elem_size));
+    }
+    if (header.order > static_cast<std::uint8_t>(Order::F) ||
+        (header.filters & ~(util::filter_delta | util::filter_shuffle)) != 0) {
+        throw std::runtime_error("Corrupt array container header");
+    }
+
+    std::array<index_t, Dim> extents;
+    for (std::size_t i = 0; i < Dim; ++i) {
+        extents[i] = util::read_value<std::int64_t>(is);
+        if (extents[i] < 0) {
+            throw std::runtime_error("Corrupt array container shape");
+        }
+    }
+    const Shape<Dim> shape(extents);
+    const std::size_t size = static_cast<std::size_t>(shape.size());
+    const std::size_t chunk_elements = util::read_value<std::uint64_t>(is);
+    const std::size_t num_chunks = util::read_value<std::uint64_t>(is);
+    if (chunk_elements == 0 || num_chunks != (size + chunk_elements - 1) / chunk_elements) {
+        throw std::runtime_error("Corrupt array container chunk table");
+    }
+
+    std::vector<std::size_t> offsets(num_chunks + 1, 0);
+    for (std::size_t c = 0; c < num_chunks; ++c) {
+        const std::size_t stored = util::read_value<std::uint64_t>(is);
+        const std::size_t count = std::min(chunk_elements, size - c * chunk_elements);
+        if (stored > count * sizeof(T)) {
+            throw std::runtime_error("Corrupt array container chunk table");
+        }
+        offsets[c + 1] = offsets[c] + stored;
+    }
+    std::vector<std::uint8_t> payload(offsets[num_chunks]);
+    if (!is.read(reinterpret_cast<char *>(payload.data()), static_cast<std::streamsize>(payload.size()))) {
+        throw std::runtime_error("Unexpected end of stream");
+    }
+
+    NdArray<T, Dim> result(shape, static_cast<Order>(header.order));
+    std::uint8_t *bytes = reinterpret_cast<std::uint8_t *>(result.data());
+    util::parallel_for(0, static_cast<index_t>(num_chunks), 1, [&](index_t first, index_t last) {
+        for (index_t c = first; c < last; ++c) {
+            const std::size_t begin = static_cast<std::size_t>(c) * chunk_elements;
+            const std::size_t count = std::min(chunk_elements, size - begin);
+            util::decode_chunk(payload.data() + offsets[c], offsets[c + 1] - offsets[c], bytes + begin * sizeof(T),
+                               count, sizeof(T), header.filters);
+        }
+    });
+    return result;
+}
+
+template <typename T, std::size_t Dim>
+    requires std::is_trivially_copyable_v<T>
+NdArray<T, Dim> load(const std::string &path) {
+    std::ifstream is(path, std::ios::binary);
+    if (!is) {
+        throw std::runtime_error(std::format("Cannot open {} for reading", path));
+    }
+    return load<T, Dim>(is);
+}
+
+}  // namespace ndarray
+
+#endif
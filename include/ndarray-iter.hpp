@@ -0,0 +1,222 @@
+#ifndef NDARRAY_ITER_HPP
+#define NDARRAY_ITER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <format>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "ndarray-definition.hpp"
+#include "ndarray-parallel.hpp"
+#include "ndarray-util.hpp"
+
+namespace ndarray {
+
+namespace util {
+
+/* Axes of N strided operands of a common shape, as traversed by nditer(): axes of length 1 are dropped, the others are
+ * sorted from the outermost to the innermost in memory, and adjacent axes along which every operand is contiguous are
+ * merged. The innermost of the ndim remaining axes is the last one. */
+template <std::size_t N, std::size_t Dim>
+class IterLayout {
+public:
+    std::size_t ndim = 0;
+    std::array<index_t, Dim> shape{};
+    std::array<std::array<index_t, N>, Dim> strides{};
+};
+
+template <std::size_t N, std::size_t Dim>
+IterLayout<N, Dim> iter_layout(const Shape<Dim> &shape, const std::array<std::array<index_t, Dim>, N> &strides) {
+    std::array<std::size_t, Dim> axes;
+    std::size_t num_axes = 0;
+    for (std::size_t i = 0; i < Dim; ++i) {
+        if (shape[i] != 1) {
+            axes[num_axes++] = i;
+        }
+    }
+
+    /* Larger strides go outside, comparing the first operand, usually the output, then the next ones on ties. Stable
+     * sorting keeps C order for operands that do not tell axes apart, such as broadcast ones. */
+    std::stable_sort(axes.begin(), axes.begin() + num_axes, [&strides](std::size_t a, std::size_t b) {
+        for (std::size_t k = 0; k < N; ++k) {
+            const index_t stride_a = strides[k][a] < 0 ? -strides[k][a] : strides[k][a];
+            const index_t stride_b = strides[k][b] < 0 ? -strides[k][b] : strides[k][b];
+            if (stride_a != stride_b) {
+                return stride_a > stride_b;
+            }
+        }
+        return false;
+    });
+
+    IterLayout<N, Dim> layout;
+    for (std::size_t j = 0; j < num_axes; ++j) {
+        const std::size_t axis = axes[j];
+        bool merge = layout.ndim > 0;
+        for (std::size_t k = 0; k < N && merge; ++k) {
+            merge = layout.strides[layout.ndim - 1][k] == strides[k][axis] * shape[axis];
+        }
+        if (merge) {
+            layout.shape[layout.ndim - 1] *= shape[axis];
+        } else {
+            layout.shape[layout.ndim++] = shape[axis];
+        }
+        for (std::size_t k = 0; k < N; ++k) {
+            layout.strides[layout.ndim - 1][k] = strides[k][axis];
+        }
+    }
+    return layout;
+}
+
+/* Calls f on the elements at the same position of runs of length elements with the given strides. Runs with unit
+ * strides are indexed directly so that the compiler can vectorize the loop. */
+template <std::size_t N, typename F, typename... Pointers>
+    requires(sizeof...(Pointers) == N)
+void for_each_in_run(index_t length, const std::array<index_t, N> &strides, F &&f, Pointers... pointers) {
+    if (std::all_of(strides.begin(), strides.end(), [](index_t stride) { return stride == 1; })) {
+        for (index_t i = 0; i < length; ++i) {
+            f(pointers[i]...);
+        }
+    } else {
+        [&]<std::size_t... K>(std::index_sequence<K...>) {
+            for (index_t i = 0; i < length; ++i) {
+                f(pointers[i * strides[K]]...);
+            }
+        }(std::make_index_sequence<N>());
+    }
+}
+
+/* Whether two strided views of the same shape may share memory. */
+template <typename T, typename U, std::size_t Dim>
+bool may_overlap(const T *a, const std::array<index_t, Dim> &a_strides, const U *b,
+                 const std::array<index_t, Dim> &b_strides, const Shape<Dim> &shape) {
+    if (shape.size() == 0) {
+        return false;
+    }
+    const auto addr = [](const void *ptr) { return reinterpret_cast<std::uintptr_t>(ptr); };
+    std::uintptr_t a_lo = addr(a), a_hi = addr(a + 1), b_lo = addr(b), b_hi = addr(b + 1);
+    for (std::size_t i = 0; i < Dim; ++i) {
+        const std::intptr_t a_extent = (shape[i] - 1) * a_strides[i] * static_cast<std::intptr_t>(sizeof(T));
+        const std::intptr_t b_extent = (shape[i] - 1) * b_strides[i] * static_cast<std::intptr_t>(sizeof(U));
+        (a_extent < 0 ? a_lo : a_hi) += a_extent;
+        (b_extent < 0 ? b_lo : b_hi) += b_extent;
+    }
+    return a_lo < b_hi && b_lo < a_hi;
+}
+
+/* Calls run(length, strides, pointers...) and returns whether the iteration should go on, which is the result of run
+ * if it returns bool. */
+template <typename Run, std::size_t N, typename Pointers>
+bool call_run(Run &run, index_t length, const std::array<index_t, N> &strides, const Pointers &pointers) {
+    return std::apply(
+        [&](auto... ptrs) {
+            if constexpr (std::is_same_v<decltype(run(length, strides, ptrs...)), bool>) {
+                return run(length, strides, ptrs...);
+            } else {
+                run(length, strides, ptrs...);
+                return true;
+            }
+        },
+        pointers);
+}
+
+/* Calls run on the runs covering the elements [first, last) of layout in traversal order, the operands starting at
+ * pointers. Returns false if run stopped the iteration. */
+template <std::size_t N, std::size_t Dim, typename Pointers, typename Run>
+bool iterate_layout(const IterLayout<N, Dim> &layout, Pointers pointers, index_t first, index_t last, Run &run) {
+    if (first >= last) {
+        return true;
+    }
+    if (layout.ndim == 0) {
+        return call_run(run, 1, std::array<index_t, N>{}, pointers);
+    }
+
+    const auto advance = [&]<std::size_t... K>(std::size_t axis, index_t steps, std::index_sequence<K...>) {
+        ((std::get<K>(pointers) += steps * layout.strides[axis][K]), ...);
+    };
+    constexpr auto operands = std::make_index_sequence<N>();
+
+    std::array<index_t, Dim> counter{};
+    index_t index = first;
+    for (std::size_t axis = layout.ndim; axis > 0; --axis) {
+        counter[axis - 1] = index % layout.shape[axis - 1];
+        index /= layout.shape[axis - 1];
+        advance(axis - 1, counter[axis - 1], operands);
+    }
+
+    const std::size_t inner = layout.ndim - 1;
+    for (index_t position = first;;) {
+        const index_t length = std::min(layout.shape[inner] - counter[inner], last - position);
+        if (!call_run(run, length, layout.strides[inner], pointers)) {
+            return false;
+        }
+        position += length;
+        if (position == last) {
+            return true;
+        }
+
+        /* Step to the next run, carrying into the outer axes like an odometer. */
+        counter[inner] += length;
+        advance(inner, length, operands);
+        if constexpr (Dim > 1) {
+            for (std::size_t axis = inner; axis > 0 && counter[axis] == layout.shape[axis]; --axis) {
+                advance(axis, -layout.shape[axis], operands);
+                counter[axis] = 0;
+                ++counter[axis - 1];
+                advance(axis - 1, 1, operands);
+            }
+        }
+    }
+}
+
+/* Checks that the operands of nditer() have the same shape and returns their layout. */
+template <typename First, typename... Rest>
+IterLayout<1 + sizeof...(Rest), First::dim> operand_layout(const First &first, const Rest &...rest) {
+    constexpr std::size_t Dim = First::dim;
+    static_assert(((Rest::dim == Dim) && ...), "nditer() operands must have the same dimension");
+
+    const Shape<Dim> &shape = first.shape();
+    [[maybe_unused]] const auto validate = [&shape](const Shape<Dim> &other) {
+        if (other != shape) {
+            throw std::invalid_argument(std::format("nditer() operands could not have different shapes {} and {}",
+                                                    shape.to_string(), other.to_string()));
+        }
+    };
+    (validate(rest.shape()), ...);
+    return iter_layout<1 + sizeof...(Rest), Dim>(shape, {strides_of(first), strides_of(rest)...});
+}
+
+}  // namespace util
+
+/* Iterates over N strided arrays of the same shape at once, such as an output and its inputs. The axes are reordered
+ * so that memory is traversed in the order of the first operand, and axes along which every operand is contiguous are
+ * merged, so f is called with runs as long as the layout allows: f(length, strides, pointers...) must process length
+ * elements of each operand, the i-th one at pointers[i * strides[k]] for the k-th operand. Operands that are contiguous
+ * in the same order are thus handled in a single call. If f returns bool, the iteration stops after the first call that
+ * returns false. Elements are visited in an unspecified order, so the operands must not overlap unless f only reads
+ * them. Slices may be passed as temporaries, since they are views. */
+template <typename F, typename First, typename... Rest>
+    requires(util::is_strided<std::remove_cvref_t<First>> && (util::is_strided<std::remove_cvref_t<Rest>> && ...))
+void nditer(F &&f, First &&first, Rest &&...rest) {
+    const auto layout = util::operand_layout(first, rest...);
+    util::iterate_layout(layout, std::tuple{first.data(), rest.data()...}, 0, first.size(), f);
+}
+
+/* nditer() with the traversal split into contiguous ranges run by parallel threads, each given at least
+ * util::parallel_grain_size elements. f is called concurrently on disjoint runs and cannot stop the iteration. */
+template <typename F, typename First, typename... Rest>
+    requires(util::is_strided<std::remove_cvref_t<First>> && (util::is_strided<std::remove_cvref_t<Rest>> && ...))
+void parallel_nditer(F &&f, First &&first, Rest &&...rest) {
+    const auto layout = util::operand_layout(first, rest...);
+    const auto pointers = std::tuple{first.data(), rest.data()...};
+    util::parallel_for(0, first.size(), util::parallel_grain_size, [&](index_t begin, index_t end) {
+        util::iterate_layout(layout, pointers, begin, end, f);
+    });
+}
+
+}  // namespace ndarray
+
+#endif
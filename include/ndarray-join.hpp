@@ -0,0 +1,319 @@
+#ifndef NDARRAY_JOIN_HPP
+#define NDARRAY_JOIN_HPP
+
+#include <algorithm>
+#include <functional>
+#include <ranges>
+#include <vector>
+
+#include "ndarray-base.hpp"
+#include "ndarray-core.hpp"
+#include "ndarray-op.hpp"
+#include "ndarray-parallel.hpp"
+#include "ndarray-slice.hpp"
+
+namespace ndarray {
+
+namespace util {
+
+template <typename A>
+concept ndarray_type =
+    std::derived_from<std::remove_const_t<A>, NdArrayBase<typename A::dtype, A::dim, std::remove_const_t<A>>>;
+
+/* Array type of the elements of a range; std::reference_wrapper elements are unwrapped so that large arrays can be
+ * joined without copying them into the range. */
+template <typename Range>
+using range_array_t = std::remove_cvref_t<std::unwrap_reference_t<std::ranges::range_value_t<Range>>>;
+
+template <typename Range>
+concept array_range = std::ranges::forward_range<Range> && ndarray_type<range_array_t<Range>>;
+
+/* Copies a strided view into its blocks of out (see join_blocks()) with strided copies, which move whole contiguous
+ * runs at a time. The copy is split across threads along the outermost axis longer than 1. */
+template <typename T, typename Array>
+void join_strided(T *out, const Array &arr, index_t block, index_t row_size) {
+    constexpr std::size_t Dim = Array::dim;
+    const Shape<Dim> &shape = arr.shape();
+    if (shape.size() == 0) {
+        return;
+    }
+
+    /* Axes inside a block keep the strides of the array; each step of an axis outside it moves to the next row. */
+    std::array<index_t, Dim> dst_strides = contiguous_strides(shape);
+    for (index_t &stride : dst_strides) {
+        if (stride >= block) {
+            stride = stride / block * row_size;
+        }
+    }
+    const std::array<index_t, Dim> src_strides = strides_of(arr);
+    const T *src = arr.data();
+
+    std::size_t axis = 0;
+    while (axis + 1 < Dim && shape[axis] == 1) {
+        ++axis;
+    }
+    const index_t grain = std::max<index_t>(1, parallel_grain_size / (shape.size() / shape[axis]));
+    parallel_for(0, shape[axis], grain, [&](index_t first, index_t last) {
+        std::array<index_t, Dim> part;
+        for (std::size_t i = 0; i < Dim; ++i) {
+            part[i] = i == axis ? last - first : shape[i];
+        }
+        strided_copy(out + first * dst_strides[axis], dst_strides, src + first * src_strides[axis], src_strides,
+                     Shape<Dim>(part));
+    });
+}
+
+/* Copies the arrays into out, whose C-order layout is outer rows each made of one block of blocks[k] elements from
+ * every array in turn. Each block is a contiguous run of its array, copied with a single std::copy when the array is
+ * contiguous; views are copied with join_strided(). The output range is split across threads for large outputs. */
+template <typename T, typename Array>
+void join_blocks(T *out, const std::vector<const Array *> &arrays, const std::vector<index_t> &blocks, index_t outer) {
+    std::vector<index_t> starts(arrays.size());
+    index_t row_size = 0;
+    for (std::size_t k = 0; k < arrays.size(); ++k) {
+        starts[k] = row_size;
+        row_size += blocks[k];
+    }
+    if (row_size == 0) {
+        return;
+    }
+
+    if constexpr (is_strided<Array> && !is_contiguous<Array>) {
+        for (std::size_t k = 0; k < arrays.size(); ++k) {
+            if (blocks[k] != 0) {
+                join_strided(out + starts[k], *arrays[k], blocks[k], row_size);
+            }
+        }
+        return;
+    }
+
+    /* Buffers of contiguous arrays in C order; arrays stored in Fortran order are copied into C order first. Other
+     * arrays get their element readers here, since a reader may copy its array once. */
+    std::vector<const T *> sources(arrays.size());
+    std::vector<NdArray<T, Array::dim>> reordered;
+    std::vector<decltype(element_reader(*arrays[0]))> readers;
+    if constexpr (is_contiguous<Array>) {
+        reordered.reserve(arrays.size());
+        for (std::size_t k = 0; k < arrays.size(); ++k) {
+            if (layout_order(*arrays[k]) == Order::C) {
+                sources[k] = arrays[k]->data();
+            } else {
+                sources[k] = reordered.emplace_back(materialize(*arrays[k])).data();
+            }
+        }
+    } else {
+        readers.reserve(arrays.size());
+        for (const Array *arr : arrays) {
+            readers.push_back(element_reader(*arr));
+        }
+    }
+
+    parallel_for(0, outer * row_size, parallel_grain_size, [&](index_t first, index_t last) {
+        index_t pos = first;
+        while (pos < last) {
+            const index_t o = pos / row_size;
+            const index_t r = pos % row_size;
+            const std::size_t k = std::upper_bound(starts.begin(), starts.end(), r) - starts.begin() - 1;
+            const index_t offset = r - starts[k];
+            const index_t count = std::min(blocks[k] - offset, last - pos);
+            const index_t src = o * blocks[k] + offset;
+
+            if constexpr (is_contiguous<Array>) {
+                std::copy(sources[k] + src, sources[k] + src + count, out + pos);
+            } else {
+                for (index_t i = 0; i < count; ++i) {
+                    out[pos + i] = readers[k](src + i);
+                }
+            }
+            pos += count;
+        }
+    });
+}
+
+template <typename Range>
+std::vector<const range_array_t<Range> *> collect_arrays(const Range &arrays) {
+    using Array = range_array_t<Range>;
+
+    std::vector<const Array *> result;
+    for (const auto &elem : arrays) {
+        result.push_back(&static_cast<const Array &>(elem));
+    }
+    if (result.empty()) {
+        throw std::invalid_argument("Need at least one array to join");
+    }
+    return result;
+}
+
+template <typename Array>
+auto axis_slice(Array &arr, std::size_t axis, index_t start, index_t stop) {
+    std::array<Slice, Array::dim> slices;
+    slices[axis] = Slice(start, stop);
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+        return arr[slices[I]...];
+    }(std::make_index_sequence<Array::dim>{});
+}
+
+template <typename Array>
+using axis_slice_t = std::remove_const_t<decltype(axis_slice(std::declval<Array &>(), 0, 0, 0))>;
+
+}  // namespace util
+
+/* Joining ************************************************************************************************************/
+
+template <typename Range>
+    requires util::array_range<Range>
+NdArray<typename util::range_array_t<Range>::dtype, util::range_array_t<Range>::dim> concatenate(const Range &arrays,
+                                                                                                 index_t axis = 0) {
+    using Array = util::range_array_t<Range>;
+    using T = typename Array::dtype;
+    constexpr std::size_t Dim = Array::dim;
+
+    const std::vector<const Array *> operands = util::collect_arrays(arrays);
+    const std::size_t ax = util::normalize_axis(axis, Dim);
+
+    std::array<index_t, Dim> shape;
+    for (std::size_t i = 0; i < Dim; ++i) {
+        shape[i] = operands[0]->shape()[i];
+    }
+    for (std::size_t k = 1; k < operands.size(); ++k) {
+        for (std::size_t i = 0; i < Dim; ++i) {
+            if (i != ax && operands[k]->shape()[i] != shape[i]) {
+                throw std::invalid_argument(std::format("Cannot concatenate arrays of shapes {} and {} along axis {}",
+                                                        operands[0]->shape().to_string(),
+                                                        operands[k]->shape().to_string(), ax));
+            }
+        }
+    }
+
+    index_t outer = 1;
+    for (std::size_t i = 0; i < ax; ++i) {
+        outer *= shape[i];
+    }
+    index_t inner = 1;
+    for (std::size_t i = ax + 1; i < Dim; ++i) {
+        inner *= shape[i];
+    }
+
+    std::vector<index_t> blocks(operands.size());
+    shape[ax] = 0;
+    for (std::size_t k = 0; k < operands.size(); ++k) {
+        blocks[k] = operands[k]->shape()[ax] * inner;
+        shape[ax] += operands[k]->shape()[ax];
+    }
+
+    NdArray<T, Dim> result{Shape<Dim>(shape)};
+    util::join_blocks(result.data(), operands, blocks, outer);
+    return result;
+}
+
+template <typename Range>
+    requires util::array_range<Range>
+NdArray<typename util::range_array_t<Range>::dtype, util::range_array_t<Range>::dim + 1> stack(const Range &arrays,
+                                                                                               index_t axis = 0) {
+    using Array = util::range_array_t<Range>;
+    using T = typename Array::dtype;
+    constexpr std::size_t Dim = Array::dim;
+
+    const std::vector<const Array *> operands = util::collect_arrays(arrays);
+    const std::size_t ax = util::normalize_axis(axis, Dim + 1);
+
+    const Shape<Dim> &sub_shape = operands[0]->shape();
+    for (std::size_t k = 1; k < operands.size(); ++k) {
+        if (operands[k]->shape() != sub_shape) {
+            throw std::invalid_argument(std::format("Cannot stack arrays of different shapes {} and {}",
+                                                    sub_shape.to_string(), operands[k]->shape().to_string()));
+        }
+    }
+
+    std::array<index_t, Dim + 1> shape;
+    index_t outer = 1;
+    index_t inner = 1;
+    for (std::size_t i = 0, j = 0; i < Dim + 1; ++i) {
+        if (i == ax) {
+            shape[i] = static_cast<index_t>(operands.size());
+        } else {
+            shape[i] = sub_shape[j];
+            (i < ax ? outer : inner) *= sub_shape[j];
+            ++j;
+        }
+    }
+
+    NdArray<T, Dim + 1> result{Shape<Dim + 1>(shape)};
+    util::join_blocks(result.data(), operands, std::vector<index_t>(operands.size(), inner), outer);
+    return result;
+}
+
+template <typename Range>
+    requires util::array_range<Range>
+auto vstack(const Range &arrays) {
+    if constexpr (util::range_array_t<Range>::dim == 1) {
+        return stack(arrays, 0);
+    } else {
+        return concatenate(arrays, 0);
+    }
+}
+
+template <typename Range>
+    requires util::array_range<Range>
+auto hstack(const Range &arrays) {
+    if constexpr (util::range_array_t<Range>::dim == 1) {
+        return concatenate(arrays, 0);
+    } else {
+        return concatenate(arrays, 1);
+    }
+}
+
+/* Splitting **********************************************************************************************************/
+
+/* The splitting functions return views into arr, which must outlive them. */
+
+template <typename Array>
+    requires util::ndarray_type<Array>
+std::vector<util::axis_slice_t<Array>> split(Array &arr, const std::vector<index_t> &indices, index_t axis = 0) {
+    const std::size_t ax = util::normalize_axis(axis, Array::dim);
+
+    std::vector<util::axis_slice_t<Array>> result;
+    result.reserve(indices.size() + 1);
+    index_t start = 0;
+    for (index_t index : indices) {
+        result.push_back(util::axis_slice(arr, ax, start, index));
+        start = index;
+    }
+    result.push_back(util::axis_slice(arr, ax, start, Slice::none));
+    return result;
+}
+
+template <typename Array>
+    requires util::ndarray_type<Array>
+std::vector<util::axis_slice_t<Array>> array_split(Array &arr, index_t sections, index_t axis = 0) {
+    if (sections <= 0) {
+        throw std::invalid_argument("Number of sections must be larger than 0");
+    }
+
+    const std::size_t ax = util::normalize_axis(axis, Array::dim);
+    const index_t size = arr.shape()[ax];
+
+    std::vector<util::axis_slice_t<Array>> result;
+    result.reserve(sections);
+    for (std::size_t k = 0; k < static_cast<std::size_t>(sections); ++k) {
+        auto [start, stop] = util::block_range(0, size, sections, k);
+        result.push_back(util::axis_slice(arr, ax, start, stop));
+    }
+    return result;
+}
+
+template <typename Array>
+    requires util::ndarray_type<Array>
+std::vector<util::axis_slice_t<Array>> split(Array &arr, index_t sections, index_t axis = 0) {
+    const index_t size = arr.shape()[util::normalize_axis(axis, Array::dim)];
+    if (sections <= 0 || size % sections != 0) {
+        throw std::invalid_argument(
+            std::format("Array of size {} cannot be split into {} equal sections", size, sections));
+    }
+
+    return array_split(arr, sections, axis);
+}
+
+}  // namespace ndarray
+
+#endif
@@ -0,0 +1,512 @@
+#ifndef NDARRAY_LAZY_HPP
+#define NDARRAY_LAZY_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "ndarray-base.hpp"
+#include "ndarray-core.hpp"
+#include "ndarray-op.hpp"
+#include "ndarray-parallel.hpp"
+
+namespace ndarray {
+
+template <typename T, std::size_t Dim>
+class LazyNdArray;
+
+namespace util {
+
+enum class LazyOp { input, add, sub, mul, div, neg };
+
+/* Node of a deferred computation. Binary nodes either have two operands or one operand and a scalar, which is the
+ * left-hand side when scalar_lhs is set. */
+template <typename T, std::size_t Dim>
+class LazyNode {
+public:
+    LazyOp op;
+    Shape<Dim> shape;
+    std::shared_ptr<const LazyNode> lhs;
+    std::shared_ptr<const LazyNode> rhs;
+    bool has_scalar = false;
+    bool scalar_lhs = false;
+    T scalar = T();
+
+    /* Input nodes only. Inputs that are not contiguous are copied and kept in owned. */
+    const T *data = nullptr;
+    std::shared_ptr<const NdArray<T, Dim>> owned;
+};
+
+/* Location of an operand while a program runs: an input buffer, an output buffer or a scratch slot. */
+class LazyLocation {
+public:
+    enum class Kind { input, output, slot };
+
+    Kind kind;
+    std::size_t index;
+};
+
+template <typename T>
+class LazyInstruction {
+public:
+    LazyOp op;
+    LazyLocation dst;
+    LazyLocation lhs;
+    LazyLocation rhs;
+    bool has_scalar;
+    bool scalar_lhs;
+    T scalar;
+};
+
+/* Straight-line program computing a set of outputs element-wise. */
+template <typename T, std::size_t Dim>
+class LazyProgram {
+public:
+    /* Number of elements processed per block; each scratch slot holds one block. */
+    static constexpr index_t block_size = 1024;
+
+    Shape<Dim> shape;
+    std::vector<const T *> inputs;
+    std::vector<std::shared_ptr<const NdArray<T, Dim>>> owned_inputs;
+    std::vector<LazyInstruction<T>> instructions;
+    std::size_t num_slots = 0;
+    /* For each requested output, the location holding it once the program has run. */
+    std::vector<LazyLocation> results;
+    std::size_t num_outputs = 0;
+
+    std::vector<NdArray<T, Dim>> run(void) const {
+        std::vector<NdArray<T, Dim>> outputs;
+        outputs.reserve(this->results.size());
+        for (std::size_t i = 0; i < this->results.size(); ++i) {
+            outputs.emplace_back(this->shape);
+        }
+
+        std::vector<T *> output_data(this->num_outputs);
+        for (std::size_t i = 0; i < this->results.size(); ++i) {
+            if (this->results[i].kind == LazyLocation::Kind::output) {
+                output_data[this->results[i].index] = outputs[i].data();
+            }
+        }
+
+        parallel_for(0, this->shape.size(), parallel_grain_size, [&](index_t first, index_t last) {
+            std::vector<T> scratch(this->num_slots * block_size);
+            for (index_t begin = first; begin < last; begin += block_size) {
+                this->run_block(begin, std::min(last - begin, block_size), output_data, scratch.data());
+            }
+        });
+
+        /* Outputs that are inputs, or duplicates of another output, are copied. */
+        for (std::size_t i = 0; i < this->results.size(); ++i) {
+            const LazyLocation &result = this->results[i];
+            if (result.kind == LazyLocation::Kind::input) {
+                std::copy(this->inputs[result.index], this->inputs[result.index] + this->shape.size(),
+                          outputs[i].data());
+            } else if (output_data[result.index] != outputs[i].data()) {
+                std::copy(output_data[result.index], output_data[result.index] + this->shape.size(),
+                          outputs[i].data());
+            }
+        }
+
+        return outputs;
+    }
+
+private:
+    void run_block(index_t begin, index_t n, const std::vector<T *> &output_data, T *scratch) const {
+        const auto locate = [&](const LazyLocation &loc) -> T * {
+            switch (loc.kind) {
+                case LazyLocation::Kind::input:
+                    return const_cast<T *>(this->inputs[loc.index]) + begin;
+                case LazyLocation::Kind::output:
+                    return output_data[loc.index] + begin;
+                default:
+                    return scratch + loc.index * block_size;
+            }
+        };
+
+        for (const LazyInstruction<T> &inst : this->instructions) {
+            T *dst = locate(inst.dst);
+            const T *a = locate(inst.lhs);
+            if (inst.op == LazyOp::neg) {
+                for (index_t i = 0; i < n; ++i) {
+                    dst[i] = -a[i];
+                }
+            } else if (inst.has_scalar) {
+                run_scalar(inst.op, dst, a, inst.scalar, inst.scalar_lhs, n);
+            } else {
+                run_binary(inst.op, dst, a, locate(inst.rhs), n);
+            }
+        }
+    }
+
+    static void run_binary(LazyOp op, T *dst, const T *a, const T *b, index_t n) {
+        switch (op) {
+            case LazyOp::add:
+                for (index_t i = 0; i < n; ++i) {
+                    dst[i] = a[i] + b[i];
+                }
+                break;
+            case LazyOp::sub:
+                for (index_t i = 0; i < n; ++i) {
+                    dst[i] = a[i] - b[i];
+                }
+                break;
+            case LazyOp::mul:
+                for (index_t i = 0; i < n; ++i) {
+                    dst[i] = a[i] * b[i];
+                }
+                break;
+            case LazyOp::div:
+                for (index_t i = 0; i < n; ++i) {
+                    dst[i] = a[i] / b[i];
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    static void run_scalar(LazyOp op, T *dst, const T *a, T s, bool scalar_lhs, index_t n) {
+        switch (op) {
+            case LazyOp::add:
+                for (index_t i = 0; i < n; ++i) {
+                    dst[i] = a[i] + s;
+                }
+                break;
+            case LazyOp::sub:
+                for (index_t i = 0; i < n; ++i) {
+                    dst[i] = scalar_lhs ? s - a[i] : a[i] - s;
+                }
+                break;
+            case LazyOp::mul:
+                for (index_t i = 0; i < n; ++i) {
+                    dst[i] = a[i] * s;
+                }
+                break;
+            case LazyOp::div:
+                for (index_t i = 0; i < n; ++i) {
+                    dst[i] = scalar_lhs ? s / a[i] : a[i] / s;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+};
+
+/* Compiles the DAG reaching the outputs into a single fused program.
+ *
+ * 1. The nodes are sorted topologically.
+ * 2. Common subexpressions are merged: nodes with the same operation, scalar and (merged) operands are computed once,
+ *    with the operands of commutative operations taken in a canonical order.
+ * 3. Every remaining node becomes one instruction of a single element-wise pass, so chains of operations never write
+ *    intermediate arrays; the pass runs over blocks of elements, in parallel across threads.
+ * 4. Intermediates that are not outputs live in block-sized scratch slots. A slot is released after the last
+ *    instruction reading it, and reused by later instructions, including in place by the instruction that consumes it.
+ */
+template <typename T, std::size_t Dim>
+LazyProgram<T, Dim> compile_lazy(const std::vector<std::shared_ptr<const LazyNode<T, Dim>>> &outputs) {
+    using Node = LazyNode<T, Dim>;
+    using Kind = LazyLocation::Kind;
+
+    LazyProgram<T, Dim> program;
+    program.shape = outputs.front()->shape;
+    for (const auto &output : outputs) {
+        validate_shape_binary_op(program.shape, output->shape);
+    }
+
+    /* Topological order. */
+    std::vector<const Node *> order;
+    std::unordered_map<const Node *, std::size_t> ids;
+    std::vector<std::pair<const Node *, bool>> stack;
+    for (const auto &output : outputs) {
+        stack.push_back({output.get(), false});
+    }
+    while (!stack.empty()) {
+        auto [node, expanded] = stack.back();
+        stack.pop_back();
+        if (ids.contains(node)) {
+            continue;
+        }
+        if (expanded) {
+            ids[node] = order.size();
+            order.push_back(node);
+            continue;
+        }
+        stack.push_back({node, true});
+        for (const Node *operand : {node->rhs.get(), node->lhs.get()}) {
+            if (operand != nullptr && !ids.contains(operand)) {
+                stack.push_back({operand, false});
+            }
+        }
+    }
+
+    /* Common subexpression elimination. */
+    using Key = std::tuple<LazyOp, std::size_t, std::size_t, bool, bool, std::array<unsigned char, sizeof(T)>,
+                           const void *>;
+    constexpr std::size_t none = static_cast<std::size_t>(-1);
+    std::map<Key, std::size_t> known;
+    std::vector<std::size_t> rep(order.size());
+    std::vector<std::size_t> unique;
+    for (std::size_t id = 0; id < order.size(); ++id) {
+        const Node *node = order[id];
+        std::size_t a = node->lhs ? rep[ids[node->lhs.get()]] : none;
+        std::size_t b = node->rhs ? rep[ids[node->rhs.get()]] : none;
+        if ((node->op == LazyOp::add || node->op == LazyOp::mul) && b != none && b < a) {
+            std::swap(a, b);
+        }
+        const bool scalar_lhs = node->scalar_lhs && (node->op == LazyOp::sub || node->op == LazyOp::div);
+        const auto scalar = std::bit_cast<std::array<unsigned char, sizeof(T)>>(node->has_scalar ? node->scalar : T());
+        const Key key{node->op, a, b, node->has_scalar, scalar_lhs, scalar, node->data};
+
+        auto [it, inserted] = known.try_emplace(key, id);
+        rep[id] = it->second;
+        if (inserted) {
+            unique.push_back(id);
+        }
+    }
+
+    /* Remaining uses of each node, counting outputs as uses that never end. */
+    std::vector<std::size_t> uses(order.size(), 0);
+    std::vector<bool> is_output(order.size(), false);
+    for (std::size_t id : unique) {
+        const Node *node = order[id];
+        for (const Node *operand : {node->lhs.get(), node->rhs.get()}) {
+            if (operand != nullptr) {
+                ++uses[rep[ids[operand]]];
+            }
+        }
+    }
+    for (const auto &output : outputs) {
+        is_output[rep[ids[output.get()]]] = true;
+    }
+
+    /* Instruction selection and slot allocation. */
+    std::vector<LazyLocation> location(order.size());
+    std::vector<std::size_t> free_slots;
+    for (std::size_t id : unique) {
+        const Node *node = order[id];
+        if (node->op == LazyOp::input) {
+            location[id] = {Kind::input, program.inputs.size()};
+            program.inputs.push_back(node->data);
+            if (node->owned) {
+                program.owned_inputs.push_back(node->owned);
+            }
+            continue;
+        }
+
+        LazyInstruction<T> inst{node->op, {}, location[rep[ids[node->lhs.get()]]], {}, node->has_scalar,
+                                node->scalar_lhs, node->scalar};
+        if (node->rhs) {
+            inst.rhs = location[rep[ids[node->rhs.get()]]];
+        }
+
+        for (const Node *operand : {node->lhs.get(), node->rhs.get()}) {
+            if (operand == nullptr) {
+                continue;
+            }
+            const std::size_t operand_id = rep[ids[operand]];
+            if (--uses[operand_id] == 0 && location[operand_id].kind == Kind::slot) {
+                free_slots.push_back(location[operand_id].index);
+            }
+        }
+
+        if (is_output[id]) {
+            location[id] = {Kind::output, program.num_outputs++};
+        } else if (!free_slots.empty()) {
+            location[id] = {Kind::slot, free_slots.back()};
+            free_slots.pop_back();
+        } else {
+            location[id] = {Kind::slot, program.num_slots++};
+        }
+        inst.dst = location[id];
+        program.instructions.push_back(inst);
+    }
+
+    for (const auto &output : outputs) {
+        program.results.push_back(location[rep[ids[output.get()]]]);
+    }
+    return program;
+}
+
+template <typename T, std::size_t Dim>
+std::shared_ptr<const LazyNode<T, Dim>> lazy_node(LazyOp op, const std::shared_ptr<const LazyNode<T, Dim>> &lhs,
+                                                  const std::shared_ptr<const LazyNode<T, Dim>> &rhs) {
+    if (rhs) {
+        validate_shape_binary_op(lhs->shape, rhs->shape);
+    }
+
+    auto node = std::make_shared<LazyNode<T, Dim>>();
+    node->op = op;
+    node->shape = lhs->shape;
+    node->lhs = lhs;
+    node->rhs = rhs;
+    return node;
+}
+
+template <typename T, std::size_t Dim>
+std::shared_ptr<const LazyNode<T, Dim>> lazy_scalar_node(LazyOp op, const std::shared_ptr<const LazyNode<T, Dim>> &arr,
+                                                         const T &scalar, bool scalar_lhs) {
+    auto node = std::make_shared<LazyNode<T, Dim>>();
+    node->op = op;
+    node->shape = arr->shape;
+    node->lhs = arr;
+    node->has_scalar = true;
+    node->scalar_lhs = scalar_lhs;
+    node->scalar = scalar;
+    return node;
+}
+
+}  // namespace util
+
+/* Handle to a deferred element-wise computation. Operations on lazy arrays only record a DAG, which is optimized and
+ * computed in a single pass by eval(). Inputs are read when the computation is evaluated, so contiguous arrays passed
+ * to lazy() by lvalue must outlive the evaluation; temporaries are moved into the lazy array. */
+template <typename T, std::size_t Dim>
+class LazyNdArray {
+public:
+    static_assert(std::is_arithmetic_v<T>, "LazyNdArray supports arithmetic element types only");
+
+    using dtype = T;
+    static constexpr std::size_t dim = Dim;
+
+    explicit LazyNdArray(std::shared_ptr<const util::LazyNode<T, Dim>> node) : _node(std::move(node)) {}
+
+    const Shape<Dim> &shape(void) const {
+        return this->_node->shape;
+    }
+
+    NdArray<T, Dim> eval(void) const {
+        return std::move(util::compile_lazy<T, Dim>({this->_node}).run().front());
+    }
+
+    const std::shared_ptr<const util::LazyNode<T, Dim>> &node(void) const {
+        return this->_node;
+    }
+
+private:
+    std::shared_ptr<const util::LazyNode<T, Dim>> _node;
+};
+
+template <typename T, std::size_t Dim, typename Derived>
+LazyNdArray<T, Dim> lazy(const NdArrayBase<T, Dim, Derived> &arr) {
+    auto node = std::make_shared<util::LazyNode<T, Dim>>();
+    node->op = util::LazyOp::input;
+    node->shape = arr.shape();
+    if constexpr (util::is_contiguous<Derived>) {
+        if (util::layout_order(arr) == Order::C) {
+            node->data = static_cast<const Derived &>(arr).data();
+            return LazyNdArray<T, Dim>(std::move(node));
+        }
+    }
+    node->owned = std::make_shared<const NdArray<T, Dim>>(util::materialize(arr));
+    node->data = node->owned->data();
+    return LazyNdArray<T, Dim>(std::move(node));
+}
+
+/* Temporary arrays are kept by the input node, since nothing else would keep them alive until the evaluation. They
+ * are moved when possible; the const results of operators are copied. */
+template <typename Arr>
+    requires(!std::is_lvalue_reference_v<Arr> && util::is_contiguous<std::remove_cv_t<Arr>>)
+auto lazy(Arr &&arr) {
+    using T = typename std::remove_cv_t<Arr>::dtype;
+    constexpr std::size_t Dim = std::remove_cv_t<Arr>::dim;
+    auto node = std::make_shared<util::LazyNode<T, Dim>>();
+    node->op = util::LazyOp::input;
+    node->shape = arr.shape();
+    if constexpr (std::is_same_v<Arr, NdArray<T, Dim>>) {
+        if (util::layout_order(arr) == Order::C) {
+            node->owned = std::make_shared<const NdArray<T, Dim>>(std::move(arr));
+        }
+    }
+    if (!node->owned) {
+        node->owned = std::make_shared<const NdArray<T, Dim>>(util::materialize(arr));
+    }
+    node->data = node->owned->data();
+    return LazyNdArray<T, Dim>(std::move(node));
+}
+
+/* Evaluates several lazy arrays together, sharing their common subexpressions, and returns them as a tuple. */
+template <typename T, std::size_t Dim, typename... Rest>
+    requires(std::is_same_v<Rest, LazyNdArray<T, Dim>> && ...)
+auto eval(const LazyNdArray<T, Dim> &first, const Rest &...rest) {
+    std::vector<NdArray<T, Dim>> results = util::compile_lazy<T, Dim>({first.node(), rest.node()...}).run();
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+        return std::make_tuple(std::move(results[I])...);
+    }(std::make_index_sequence<1 + sizeof...(Rest)>{});
+}
+
+/* Lazy operators *****************************************************************************************************/
+
+template <typename T, std::size_t Dim>
+LazyNdArray<T, Dim> operator-(const LazyNdArray<T, Dim> &arr) {
+    return LazyNdArray<T, Dim>(util::lazy_node<T, Dim>(util::LazyOp::neg, arr.node(), nullptr));
+}
+
+template <typename T, std::size_t Dim>
+LazyNdArray<T, Dim> operator+(const LazyNdArray<T, Dim> &lhs, const LazyNdArray<T, Dim> &rhs) {
+    return LazyNdArray<T, Dim>(util::lazy_node<T, Dim>(util::LazyOp::add, lhs.node(), rhs.node()));
+}
+
+template <typename T, std::size_t Dim>
+LazyNdArray<T, Dim> operator+(const LazyNdArray<T, Dim> &lhs, const std::type_identity_t<T> &rhs) {
+    return LazyNdArray<T, Dim>(util::lazy_scalar_node<T, Dim>(util::LazyOp::add, lhs.node(), rhs, false));
+}
+
+template <typename T, std::size_t Dim>
+LazyNdArray<T, Dim> operator+(const std::type_identity_t<T> &lhs, const LazyNdArray<T, Dim> &rhs) {
+    return LazyNdArray<T, Dim>(util::lazy_scalar_node<T, Dim>(util::LazyOp::add, rhs.node(), lhs, true));
+}
+
+template <typename T, std::size_t Dim>
+LazyNdArray<T, Dim> operator-(const LazyNdArray<T, Dim> &lhs, const LazyNdArray<T, Dim> &rhs) {
+    return LazyNdArray<T, Dim>(util::lazy_node<T, Dim>(util::LazyOp::sub, lhs.node(), rhs.node()));
+}
+
+template <typename T, std::size_t Dim>
+LazyNdArray<T, Dim> operator-(const LazyNdArray<T, Dim> &lhs, const std::type_identity_t<T> &rhs) {
+    return LazyNdArray<T, Dim>(util::lazy_scalar_node<T, Dim>(util::LazyOp::sub, lhs.node(), rhs, false));
+}
+
+template <typename T, std::size_t Dim>
+LazyNdArray<T, Dim> operator-(const std::type_identity_t<T> &lhs, const LazyNdArray<T, Dim> &rhs) {
+    return LazyNdArray<T, Dim>(util::lazy_scalar_node<T, Dim>(util::LazyOp::sub, rhs.node(), lhs, true));
+}
+
+template <typename T, std::size_t Dim>
+LazyNdArray<T, Dim> operator*(const LazyNdArray<T, Dim> &lhs, const LazyNdArray<T, Dim> &rhs) {
+    return LazyNdArray<T, Dim>(util::lazy_node<T, Dim>(util::LazyOp::mul, lhs.node(), rhs.node()));
+}
+
+template <typename T, std::size_t Dim>
+LazyNdArray<T, Dim> operator*(const LazyNdArray<T, Dim> &lhs, const std::type_identity_t<T> &rhs) {
+    return LazyNdArray<T, Dim>(util::lazy_scalar_node<T, Dim>(util::LazyOp::mul, lhs.node(), rhs, false));
+}
+
+template <typename T, std::size_t Dim>
+LazyNdArray<T, Dim> operator*(const std::type_identity_t<T> &lhs, const LazyNdArray<T, Dim> &rhs) {
+    return LazyNdArray<T, Dim>(util::lazy_scalar_node<T, Dim>(util::LazyOp::mul, rhs.node(), lhs, true));
+}
+
+template <typename T, std::size_t Dim>
+LazyNdArray<T, Dim> operator/(const LazyNdArray<T, Dim> &lhs, const LazyNdArray<T, Dim> &rhs) {
+    return LazyNdArray<T, Dim>(util::lazy_node<T, Dim>(util::LazyOp::div, lhs.node(), rhs.node()));
+}
+
+template <typename T, std::size_t Dim>
+LazyNdArray<T, Dim> operator/(const LazyNdArray<T, Dim> &lhs, const std::type_identity_t<T> &rhs) {
+    return LazyNdArray<T, Dim>(util::lazy_scalar_node<T, Dim>(util::LazyOp::div, lhs.node(), rhs, false));
+}
+
+template <typename T, std::size_t Dim>
+LazyNdArray<T, Dim> operator/(const std::type_identity_t<T> &lhs, const LazyNdArray<T, Dim> &rhs) {
+    return LazyNdArray<T, Dim>(util::lazy_scalar_node<T, Dim>(util::LazyOp::div, rhs.node(), lhs, true));
+}
+
+}  // namespace ndarray
+
+#endif
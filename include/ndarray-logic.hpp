@@ -0,0 +1,194 @@
+#ifndef NDARRAY_LOGIC_HPP
+#define NDARRAY_LOGIC_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "ndarray-base.hpp"
+#include "ndarray-core.hpp"
+#include "ndarray-iter.hpp"
+#include "ndarray-mask.hpp"
+#include "ndarray-op.hpp"
+#include "ndarray-parallel.hpp"
+
+namespace ndarray {
+
+namespace util {
+
+/* Number of elements the fused predicates check between two tests for an early exit. A block is checked without
+ * branches, so the compiler can vectorize it. */
+constexpr index_t predicate_block = 1024;
+
+/* Calls f with arr as a strided array, or with a C-contiguous copy of it. */
+template <typename T, std::size_t Dim, typename Derived, typename F>
+decltype(auto) with_strided(const NdArrayBase<T, Dim, Derived> &arr, F f) {
+    if constexpr (is_strided<Derived>) {
+        return f(static_cast<const Derived &>(arr));
+    } else {
+        return f(materialize(arr));
+    }
+}
+
+/* Whether pred holds for every pair of elements at the same position in the strided arrays lhs and rhs. The arrays
+ * are traversed once, across threads, and every thread stops at the first block in which pred fails anywhere. */
+template <typename Lhs, typename Rhs, typename Pred>
+bool all_pairs(const Lhs &lhs, const Rhs &rhs, Pred pred) {
+    using T1 = typename Lhs::dtype;
+    using T2 = typename Rhs::dtype;
+    std::atomic<bool> result = true;
+    parallel_nditer(
+        [&result, &pred](index_t length, const std::array<index_t, 2> &strides, const T1 *a, const T2 *b) {
+            const bool unit = strides[0] == 1 && strides[1] == 1;
+            for (index_t begin = 0; begin < length && result.load(std::memory_order_relaxed);
+                 begin += predicate_block) {
+                const index_t end = std::min(length, begin + predicate_block);
+                index_t failures = 0;
+                if (unit) {
+                    for (index_t i = begin; i < end; ++i) {
+                        failures |= !pred(a[i], b[i]);
+                    }
+                } else {
+                    for (index_t i = begin; i < end; ++i) {
+                        failures |= !pred(a[i * strides[0]], b[i * strides[1]]);
+                    }
+                }
+                if (failures != 0) {
+                    result.store(false, std::memory_order_relaxed);
+                }
+            }
+        },
+        lhs, rhs);
+    return result.load();
+}
+
+/* Whether two buffers hold the same bytes, compared with memcmp in blocks across threads. */
+inline bool equal_bytes(const void *lhs, const void *rhs, std::size_t size) {
+    constexpr index_t block_bytes = index_t(1) << 16;
+    const auto *a = static_cast<const unsigned char *>(lhs);
+    const auto *b = static_cast<const unsigned char *>(rhs);
+    std::atomic<bool> result = true;
+    parallel_for(0, static_cast<index_t>(size), parallel_grain_size * 8, [&](index_t first, index_t last) {
+        for (index_t begin = first; begin < last && result.load(std::memory_order_relaxed); begin += block_bytes) {
+            const index_t n = std::min(block_bytes, last - begin);
+            if (std::memcmp(a + begin, b + begin, static_cast<std::size_t>(n)) != 0) {
+                result.store(false, std::memory_order_relaxed);
+            }
+        }
+    });
+    return result.load();
+}
+
+/* |a - b| <= atol + rtol * |b| as in NumPy, computed in C. Infinities are only close to themselves, and NaNs are only
+ * close to each other with equal_nan. */
+template <typename C>
+class IsClose {
+public:
+    C rtol, atol;
+    bool equal_nan;
+
+    template <typename T1, typename T2>
+    bool operator()(const T1 &lhs, const T2 &rhs) const {
+        const C a = static_cast<C>(lhs), b = static_cast<C>(rhs);
+        /* Only comparisons, so that the check vectorizes: |a - b| is infinite or NaN unless a is finite, and a finite
+         * |b| keeps the tolerance finite. */
+        const bool finite = std::abs(b) <= std::numeric_limits<C>::max();
+        return (a == b) | (finite & (std::abs(a - b) <= this->atol + this->rtol * std::abs(b))) |
+               (this->equal_nan & (a != a) & (b != b));
+    }
+};
+
+template <typename T1, typename T2>
+using close_type_t = std::conditional_t<std::is_floating_point_v<promote_t<T1, T2>>, promote_t<T1, T2>, double>;
+
+}  // namespace util
+
+/* Comparisons ********************************************************************************************************/
+
+/* Whether two arrays have the same shape and elements. Unlike (lhs == rhs).all(), no mask is built and the comparison
+ * stops at the first differing block; contiguous arrays of the same integer-like type stored in the same order are
+ * compared with memcmp. NaNs compare equal only with equal_nan. */
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+bool array_equal(const NdArrayBase<T1, Dim, Derived1> &lhs, const NdArrayBase<T2, Dim, Derived2> &rhs,
+                 bool equal_nan = false) {
+    if (lhs.shape() != rhs.shape()) {
+        return false;
+    }
+
+    if constexpr (std::is_same_v<T1, T2> && std::has_unique_object_representations_v<T1> &&
+                  util::is_contiguous<Derived1> && util::is_contiguous<Derived2>) {
+        if (util::layout_order(lhs) == util::layout_order(rhs)) {
+            return util::equal_bytes(static_cast<const Derived1 &>(lhs).data(),
+                                     static_cast<const Derived2 &>(rhs).data(), lhs.size() * sizeof(T1));
+        }
+    }
+
+    using C = util::promote_t<T1, T2>;
+    return util::with_strided(lhs, [&](const auto &a) {
+        return util::with_strided(rhs, [&](const auto &b) {
+            if constexpr (std::is_floating_point_v<C>) {
+                if (equal_nan) {
+                    return util::all_pairs(a, b, [](const T1 &x, const T2 &y) {
+                        const C u = static_cast<C>(x), v = static_cast<C>(y);
+                        return (u == v) | ((u != u) & (v != v));
+                    });
+                }
+            }
+            return util::all_pairs(a, b, [](const T1 &x, const T2 &y) {
+                return util::convert<C>(x) == util::convert<C>(y);
+            });
+        });
+    });
+}
+
+/* Element-wise |lhs - rhs| <= atol + rtol * |rhs|, as in NumPy. */
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+NdArrayMask<Dim> isclose(const NdArrayBase<T1, Dim, Derived1> &lhs, const NdArrayBase<T2, Dim, Derived2> &rhs,
+                         double rtol = 1e-5, double atol = 1e-8, bool equal_nan = false) {
+    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
+
+    using C = util::close_type_t<T1, T2>;
+    const util::IsClose<C> close{static_cast<C>(rtol), static_cast<C>(atol), equal_nan};
+    auto in1 = util::element_reader(lhs);
+    auto in2 = util::element_reader(rhs);
+    return util::build_mask(lhs.shape(), [&](index_t i) { return close(in1(i), in2(i)); });
+}
+
+/* Whether isclose() holds everywhere, checked in one pass that stops at the first block where it does not. */
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+bool allclose(const NdArrayBase<T1, Dim, Derived1> &lhs, const NdArrayBase<T2, Dim, Derived2> &rhs,
+              double rtol = 1e-5, double atol = 1e-8, bool equal_nan = false) {
+    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
+
+    using C = util::close_type_t<T1, T2>;
+    const util::IsClose<C> close{static_cast<C>(rtol), static_cast<C>(atol), equal_nan};
+    return util::with_strided(lhs, [&](const auto &a) {
+        return util::with_strided(rhs, [&](const auto &b) { return util::all_pairs(a, b, close); });
+    });
+}
+
+/* Number of elements that are not zero, counted in one pass across threads without building a mask. */
+template <typename T, std::size_t Dim, typename Derived>
+index_t count_nonzero(const NdArrayBase<T, Dim, Derived> &arr) {
+    return util::with_strided(arr, [](const auto &a) {
+        std::atomic<index_t> count = 0;
+        parallel_nditer(
+            [&count](index_t length, const std::array<index_t, 1> &strides, const T *in) {
+                index_t n = 0;
+                for (index_t i = 0; i < length; ++i) {
+                    n += static_cast<bool>(in[i * strides[0]]) ? 1 : 0;
+                }
+                count.fetch_add(n, std::memory_order_relaxed);
+            },
+            a);
+        return count.load();
+    });
+}
+
+}  // namespace ndarray
+
+#endif
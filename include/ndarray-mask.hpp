@@ -0,0 +1,272 @@
+#ifndef NDARRAY_MASK_HPP
+#define NDARRAY_MASK_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include "ndarray-core.hpp"
+#include "ndarray-parallel.hpp"
+#include "ndarray-shape.hpp"
+
+namespace ndarray {
+
+namespace util {
+
+/* Defined in ndarray-op.hpp. */
+template <typename T, std::size_t Dim, typename Derived>
+auto element_reader(const NdArrayBase<T, Dim, Derived> &arr, Order order = Order::C);
+
+}  // namespace util
+
+/* Boolean array storing one bit per element, in C order. Comparison operators return masks, and masks can be used to
+ * select the elements of an array of the same shape. Bits past the last element of the last word are always zero. */
+template <std::size_t Dim>
+class NdArrayMask {
+public:
+    using word_type = std::uint64_t;
+    static constexpr index_t word_bits = 64;
+    static constexpr std::size_t dim = Dim;
+
+    NdArrayMask(void) = default;
+    NdArrayMask(const NdArrayMask &other) = default;
+    NdArrayMask(NdArrayMask &&other) noexcept = default;
+
+    explicit NdArrayMask(const Shape<Dim> &shape, bool val = false)
+        : _shape(shape), _words(num_words(shape.size()), val ? ~word_type(0) : word_type(0)) {
+        this->clear_tail();
+    }
+
+    template <typename Derived>
+    explicit NdArrayMask(const NdArrayBase<bool, Dim, Derived> &arr) : NdArrayMask(arr.shape()) {
+        auto in = util::element_reader(arr);
+        for (index_t i = 0; i < this->size(); ++i) {
+            this->set(i, in(i));
+        }
+    }
+
+    ~NdArrayMask() = default;
+
+    NdArrayMask &operator=(const NdArrayMask &other) = default;
+    NdArrayMask &operator=(NdArrayMask &&other) noexcept = default;
+
+    /* Conversion *****************************************************************************************************/
+
+    operator NdArray<bool, Dim>() const {
+        return this->to_array();
+    }
+
+    NdArray<bool, Dim> to_array(void) const {
+        NdArray<bool, Dim> result(this->_shape);
+        bool *out = result.data();
+        for (index_t i = 0; i < this->size(); ++i) {
+            out[i] = this->test(i);
+        }
+        return result;
+    }
+
+    /* Indexing *******************************************************************************************************/
+
+    template <typename... Args>
+        requires(sizeof...(Args) == Dim && (util::is_index_type<Args> && ...))
+    bool operator[](Args... args) const {
+        const std::array<index_t, Dim> indices = util::normalize_indices(this->_shape, {static_cast<index_t>(args)...});
+
+        index_t index = 0;
+        for (std::size_t i = 0; i < Dim; ++i) {
+            index += indices[i] * this->_shape.partial[i];
+        }
+        return this->test(index);
+    }
+
+    /* Returns the value of the index-th element in C order. */
+    bool test(index_t index) const {
+        return (this->_words[index / word_bits] >> (index % word_bits)) & 1;
+    }
+
+    void set(index_t index, bool val = true) {
+        const word_type bit = word_type(1) << (index % word_bits);
+        word_type &word = this->_words[index / word_bits];
+        word = val ? (word | bit) : (word & ~bit);
+    }
+
+    /* Logical operators **********************************************************************************************/
+
+    NdArrayMask &operator&=(const NdArrayMask &other) {
+        this->combine(other, [](word_type a, word_type b) { return a & b; });
+        return *this;
+    }
+
+    NdArrayMask &operator|=(const NdArrayMask &other) {
+        this->combine(other, [](word_type a, word_type b) { return a | b; });
+        return *this;
+    }
+
+    NdArrayMask &operator^=(const NdArrayMask &other) {
+        this->combine(other, [](word_type a, word_type b) { return a ^ b; });
+        return *this;
+    }
+
+    NdArrayMask operator!(void) const {
+        NdArrayMask result(*this);
+        for (word_type &word : result._words) {
+            word = ~word;
+        }
+        result.clear_tail();
+        return result;
+    }
+
+    NdArrayMask operator~(void) const {
+        return !*this;
+    }
+
+    /* Method *********************************************************************************************************/
+
+    bool all(void) const {
+        if (this->_words.empty()) {
+            return true;
+        }
+        const index_t tail = this->size() % word_bits;
+        const word_type last = tail == 0 ? ~word_type(0) : (word_type(1) << tail) - 1;
+        return std::all_of(this->_words.begin(), this->_words.end() - 1,
+                           [](word_type w) { return w == ~word_type(0); }) &&
+               this->_words.back() == last;
+    }
+
+    bool any(void) const {
+        return std::any_of(this->_words.begin(), this->_words.end(), [](word_type w) { return w != 0; });
+    }
+
+    index_t count_nonzero(void) const {
+        index_t count = 0;
+        for (word_type word : this->_words) {
+            count += std::popcount(word);
+        }
+        return count;
+    }
+
+    word_type *data(void) {
+        return this->_words.data();
+    }
+
+    const word_type *data(void) const {
+        return this->_words.data();
+    }
+
+    std::size_t nbytes(void) const {
+        return this->_words.size() * sizeof(word_type);
+    }
+
+    const Shape<Dim> &shape(void) const {
+        return this->_shape;
+    }
+
+    index_t size(void) const {
+        return this->_shape.size();
+    }
+
+    std::string to_string(void) const {
+        std::string result = "NdArrayMask(";
+        result += this->to_array().to_string().substr(std::string("NdArray(").size());
+        return result;
+    }
+
+    static index_t num_words(index_t size) {
+        return (size + word_bits - 1) / word_bits;
+    }
+
+private:
+    template <typename Op>
+    void combine(const NdArrayMask &other, Op op) {
+        util::validate_shape_binary_op(this->_shape, other._shape);
+        for (std::size_t i = 0; i < this->_words.size(); ++i) {
+            this->_words[i] = op(this->_words[i], other._words[i]);
+        }
+    }
+
+    void clear_tail(void) {
+        const index_t tail = this->size() % word_bits;
+        if (tail != 0) {
+            this->_words.back() &= (word_type(1) << tail) - 1;
+        }
+    }
+
+    Shape<Dim> _shape;
+    std::vector<word_type> _words;
+};
+
+template <std::size_t Dim>
+NdArrayMask<Dim> operator&(NdArrayMask<Dim> lhs, const NdArrayMask<Dim> &rhs) {
+    return lhs &= rhs;
+}
+
+template <std::size_t Dim>
+NdArrayMask<Dim> operator|(NdArrayMask<Dim> lhs, const NdArrayMask<Dim> &rhs) {
+    return lhs |= rhs;
+}
+
+template <std::size_t Dim>
+NdArrayMask<Dim> operator^(NdArrayMask<Dim> lhs, const NdArrayMask<Dim> &rhs) {
+    return lhs ^= rhs;
+}
+
+template <std::size_t Dim>
+std::ostream &operator<<(std::ostream &os, const NdArrayMask<Dim> &mask) {
+    os << mask.to_string();
+    return os;
+}
+
+namespace util {
+
+/* Builds a mask whose index-th bit is pred(index). Each word is assembled from 64 predicate results in a branch-free
+ * loop, and the words are split across threads for large masks. */
+template <std::size_t Dim, typename Pred>
+NdArrayMask<Dim> build_mask(const Shape<Dim> &shape, Pred pred) {
+    using word_type = typename NdArrayMask<Dim>::word_type;
+    constexpr index_t word_bits = NdArrayMask<Dim>::word_bits;
+
+    NdArrayMask<Dim> result(shape);
+    word_type *words = result.data();
+    const index_t size = shape.size();
+    const index_t num_words = NdArrayMask<Dim>::num_words(size);
+
+    parallel_for(0, num_words, parallel_grain_size / word_bits, [&](index_t first, index_t last) {
+        for (index_t w = first; w < last; ++w) {
+            const index_t base = w * word_bits;
+            const index_t count = std::min(word_bits, size - base);
+            word_type word = 0;
+            for (index_t b = 0; b < count; ++b) {
+                word |= word_type(pred(base + b) ? 1 : 0) << b;
+            }
+            words[w] = word;
+        }
+    });
+    return result;
+}
+
+}  // namespace util
+
+/* Returns the elements of arr whose bit is set in mask, in C order. arr[mask] is equivalent. */
+template <typename T, std::size_t Dim, typename Derived>
+NdArray<T, 1> masked_select(const NdArrayBase<T, Dim, Derived> &arr, const NdArrayMask<Dim> &mask) {
+    using word_type = typename NdArrayMask<Dim>::word_type;
+    constexpr index_t word_bits = NdArrayMask<Dim>::word_bits;
+
+    util::validate_shape_binary_op(arr.shape(), mask.shape());
+
+    NdArray<T, 1> result(Shape<1>({mask.count_nonzero()}));
+    T *out = result.data();
+    const word_type *words = mask.data();
+    auto in = util::element_reader(arr);
+    for (index_t w = 0, n = 0; w < NdArrayMask<Dim>::num_words(mask.size()); ++w) {
+        for (word_type word = words[w]; word != 0; word &= word - 1) {
+            out[n++] = in(w * word_bits + std::countr_zero(word));
+        }
+    }
+    return result;
+}
+
+}  // namespace ndarray
+
+#endif
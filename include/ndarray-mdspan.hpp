@@ -0,0 +1,122 @@
+#ifndef NDARRAY_MDSPAN_HPP
+#define NDARRAY_MDSPAN_HPP
+
+#if __has_include(<mdspan>)
+#include <mdspan>
+#endif
+
+/* The conversions are only available when the standard library provides std::mdspan. */
+#ifdef __cpp_lib_mdspan
+
+#include <algorithm>
+#include <array>
+#include <format>
+#include <stdexcept>
+#include <utility>
+
+#include "ndarray-core.hpp"
+#include "ndarray-fixed.hpp"
+#include "ndarray-slice.hpp"
+
+namespace ndarray {
+
+namespace util {
+
+template <std::size_t Dim>
+using mdspan_extents_t = std::dextents<index_t, Dim>;
+
+template <std::size_t Dim>
+mdspan_extents_t<Dim> to_mdspan_extents(const Shape<Dim> &shape) {
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+        return mdspan_extents_t<Dim>(shape[I]...);
+    }(std::make_index_sequence<Dim>{});
+}
+
+template <std::size_t Dim>
+using mdspan_stride_mapping_t = std::layout_stride::mapping<mdspan_extents_t<Dim>>;
+
+/* std::layout_stride requires positive strides. The stride of an axis of length 1, or of any axis of an empty array,
+ * is never used and is replaced by 1; a zero or negative stride along a longer axis of a non-empty array, as in a
+ * reversed or broadcast view, cannot be described. */
+template <std::size_t Dim>
+mdspan_stride_mapping_t<Dim> to_mdspan_mapping(const Shape<Dim> &shape, std::array<index_t, Dim> strides) {
+    for (std::size_t i = 0; i < Dim; ++i) {
+        if (shape[i] <= 1 || shape.size() == 0) {
+            strides[i] = std::max<index_t>(strides[i], 1);
+        } else if (strides[i] <= 0) {
+            throw std::invalid_argument(
+                std::format("Cannot export an array with stride {} along axis {} as std::mdspan", strides[i], i));
+        }
+    }
+    return mdspan_stride_mapping_t<Dim>(to_mdspan_extents(shape), strides);
+}
+
+}  // namespace util
+
+/* Export *************************************************************************************************************/
+
+/* The returned mdspans refer to the elements of the array without copying them and are valid as long as the array.
+ * The memory order of an NdArray is only known at run time, so it is exported as std::layout_stride, with the strides
+ * of either order. */
+
+template <typename T, std::size_t Dim>
+std::mdspan<T, util::mdspan_extents_t<Dim>, std::layout_stride> to_mdspan(NdArray<T, Dim> &arr) {
+    return {arr.data(), util::to_mdspan_mapping(arr.shape(), arr.strides())};
+}
+
+template <typename T, std::size_t Dim>
+std::mdspan<const T, util::mdspan_extents_t<Dim>, std::layout_stride> to_mdspan(const NdArray<T, Dim> &arr) {
+    return {arr.data(), util::to_mdspan_mapping(arr.shape(), arr.strides())};
+}
+
+template <typename T, index_t... Extents>
+std::mdspan<T, std::extents<index_t, Extents...>, std::layout_right> to_mdspan(FixedNdArray<T, Extents...> &arr) {
+    return std::mdspan<T, std::extents<index_t, Extents...>, std::layout_right>(arr.data());
+}
+
+template <typename T, index_t... Extents>
+std::mdspan<const T, std::extents<index_t, Extents...>, std::layout_right> to_mdspan(
+    const FixedNdArray<T, Extents...> &arr) {
+    return std::mdspan<const T, std::extents<index_t, Extents...>, std::layout_right>(arr.data());
+}
+
+/* Slices with a negative or zero step along an axis of length larger than 1 cannot be exported. */
+template <typename T, std::size_t Dim, typename Operand>
+auto to_mdspan(const NdArraySlice<T, Dim, Operand> &slice) {
+    using element_type = std::remove_pointer_t<typename NdArraySlice<T, Dim, Operand>::pointer>;
+    return std::mdspan<element_type, util::mdspan_extents_t<Dim>, std::layout_stride>(
+        slice.data(), util::to_mdspan_mapping(slice.shape(), slice.strides()));
+}
+
+/* Import *************************************************************************************************************/
+
+/* Wraps an mdspan with a strided layout as a view, without copying its elements, so that every operation on arrays can
+ * run on it. The view is valid as long as the memory viewed by the mdspan. */
+template <typename ElementType, typename Extents, typename Layout, typename Accessor>
+auto from_mdspan(const std::mdspan<ElementType, Extents, Layout, Accessor> &span)
+    requires(Extents::rank() > 0 &&
+             std::is_same_v<typename Accessor::data_handle_type, std::add_pointer_t<ElementType>>)
+{
+    constexpr std::size_t Dim = Extents::rank();
+    using T = std::remove_const_t<ElementType>;
+    using Operand = std::conditional_t<std::is_const_v<ElementType>, const NdArray<T, Dim>, NdArray<T, Dim>>;
+
+    if (!span.is_strided()) {
+        throw std::invalid_argument("Cannot view an mdspan whose layout is not strided");
+    }
+
+    std::array<index_t, Dim> shape;
+    std::array<index_t, Dim> strides;
+    for (std::size_t i = 0; i < Dim; ++i) {
+        shape[i] = static_cast<index_t>(span.extent(i));
+        strides[i] = static_cast<index_t>(span.stride(i));
+    }
+
+    return NdArraySlice<T, Dim, Operand>(span.data_handle(), Shape<Dim>(shape), strides);
+}
+
+}  // namespace ndarray
+
+#endif
+
+#endif
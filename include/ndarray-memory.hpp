@@ -0,0 +1,269 @@
+#ifndef NDARRAY_MEMORY_HPP
+#define NDARRAY_MEMORY_HPP
+
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "ndarray-base.hpp"
+#include "ndarray-definition.hpp"
+#include "ndarray-parallel.hpp"
+#include "ndarray-util.hpp"
+
+namespace ndarray {
+
+/* Placement of the pages of large arrays across NUMA nodes.
+ *
+ * - none: pages are placed by the default policy of the process, usually on the node of the thread first writing them.
+ * - local: pages are placed on the node of the allocating thread.
+ * - interleave: pages are spread round-robin over all allowed nodes.
+ * - first_touch: pages are zeroed right after allocation by parallel_for() threads over the elements, so that the
+ *   buffer is spread over the nodes those threads run on. The threads are not pinned and most element-wise kernels
+ *   run on the calling thread, so this spreads bandwidth rather than matching pages to the threads that use them. */
+enum class NumaPolicy { none, local, interleave, first_touch };
+
+/* Page size backing large arrays, to reduce TLB misses on random or strided access.
+ *
+ * - none: regular pages.
+ * - transparent: the buffer is aligned to 2 MB and the kernel is asked to back it with transparent huge pages.
+ * - hugetlb: the buffer is mapped from the reserved 2 MB huge page pool, falling back to transparent huge pages when
+ *   the pool is empty or not configured. */
+enum class HugePages { none, transparent, hugetlb };
+
+/* How NdArray allocates its buffers. Buffers of at least threshold bytes, of elements that are trivially copyable and
+ * default constructible, are mapped directly from the kernel with the policy applied; other buffers, and every buffer
+ * when mapping is not needed or fails, are allocated with new[]. The policy only applies on Linux. */
+class MemoryPolicy {
+public:
+    NumaPolicy numa = NumaPolicy::none;
+    std::size_t threshold = std::size_t(1) << 21;
+    HugePages huge_pages = HugePages::none;
+};
+
+namespace util {
+
+/* The global policy is read by every large allocation, possibly on several threads, so it is guarded by a mutex. */
+class MemoryPolicyStorage {
+public:
+    std::mutex mutex;
+    MemoryPolicy policy;
+};
+
+inline MemoryPolicyStorage &memory_policy_storage(void) {
+    static MemoryPolicyStorage storage;
+    return storage;
+}
+
+}  // namespace util
+
+/* Policy used by arrays allocated without an explicit one. */
+inline MemoryPolicy get_memory_policy(void) {
+    util::MemoryPolicyStorage &storage = util::memory_policy_storage();
+    const std::lock_guard<std::mutex> lock(storage.mutex);
+    return storage.policy;
+}
+
+inline void set_memory_policy(const MemoryPolicy &policy) {
+    util::MemoryPolicyStorage &storage = util::memory_policy_storage();
+    const std::lock_guard<std::mutex> lock(storage.mutex);
+    storage.policy = policy;
+}
+
+namespace util {
+
+/* Maximum number of NUMA nodes in a node mask. */
+constexpr std::size_t max_numa_nodes = 1024;
+
+constexpr std::size_t huge_page_size = std::size_t(1) << 21;
+
+template <typename T>
+constexpr bool is_mappable = std::is_trivially_default_constructible_v<T> && std::is_trivially_copyable_v<T>;
+
+#ifdef __linux__
+
+inline std::size_t page_size(void) {
+    static const std::size_t size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+using numa_mask_t = std::array<unsigned long, max_numa_nodes / (8 * sizeof(unsigned long))>;
+
+/* Nodes the process is allowed to allocate on. */
+inline numa_mask_t allowed_numa_nodes(void) {
+    numa_mask_t mask{};
+    int mode = 0;
+    if (syscall(SYS_get_mempolicy, &mode, mask.data(), max_numa_nodes, nullptr, MPOL_F_MEMS_ALLOWED) != 0) {
+        mask.fill(0);
+        mask[0] = 1;
+    }
+    return mask;
+}
+
+/* Applies the memory policy mode to the whole pages of [data, data + bytes). */
+inline long bind_pages(void *data, std::size_t bytes, int mode, const numa_mask_t *mask, unsigned flags) {
+    const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(data) & ~(page_size() - 1);
+    const std::uintptr_t end = reinterpret_cast<std::uintptr_t>(data) + bytes;
+    return syscall(SYS_mbind, begin, end - begin, mode, mask != nullptr ? mask->data() : nullptr,
+                   mask != nullptr ? max_numa_nodes + 1 : 0, flags);
+}
+
+/* Maps length bytes at an address aligned to align, a multiple of the page size, by over-mapping and unmapping the
+ * excess on both sides. Returns nullptr on failure. */
+inline void *map_aligned(std::size_t length, std::size_t align) {
+    const std::size_t padded = length + align - page_size();
+    void *raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return nullptr;
+    }
+
+    const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(raw);
+    const std::uintptr_t aligned = (begin + align - 1) & ~(align - 1);
+    const std::size_t head = aligned - begin;
+    if (head > 0) {
+        munmap(raw, head);
+    }
+    if (padded - head > length) {
+        munmap(reinterpret_cast<void *>(aligned + length), padded - head - length);
+    }
+    return reinterpret_cast<void *>(aligned);
+}
+
+/* Maps a buffer of count elements of elem_size bytes and applies policy to it. Returns nullptr when the buffer should
+ * be allocated with new[] instead; otherwise the returned pointer owns the mapping and unmaps it when released. */
+inline std::shared_ptr<void> map_pages(std::size_t count, std::size_t elem_size, const MemoryPolicy &policy) {
+    const std::size_t bytes = count * elem_size;
+    if ((policy.numa == NumaPolicy::none && policy.huge_pages == HugePages::none) || bytes < policy.threshold ||
+        bytes == 0) {
+        return nullptr;
+    }
+
+    /* Huge page mappings are rounded up to whole huge pages, so that the last one can be huge as well. */
+    const bool huge = policy.huge_pages != HugePages::none;
+    const std::size_t length = huge ? (bytes + huge_page_size - 1) & ~(huge_page_size - 1) : bytes;
+    void *data = nullptr;
+    if (policy.huge_pages == HugePages::hugetlb) {
+        data = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+        if (data == MAP_FAILED) {
+            data = nullptr;
+        }
+    }
+    if (data == nullptr) {
+        data = huge ? map_aligned(length, huge_page_size)
+                    : mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == nullptr || data == MAP_FAILED) {
+            return nullptr;
+        }
+        if (huge) {
+            madvise(data, length, MADV_HUGEPAGE);
+        }
+    }
+    std::shared_ptr<void> pages(data, [length](void *ptr) { munmap(ptr, length); });
+
+    /* Placement is a hint: if the kernel rejects it, the buffer is still usable. */
+    switch (policy.numa) {
+        case NumaPolicy::local:
+            bind_pages(data, bytes, MPOL_LOCAL, nullptr, 0);
+            break;
+        case NumaPolicy::interleave: {
+            const numa_mask_t mask = allowed_numa_nodes();
+            bind_pages(data, bytes, MPOL_INTERLEAVE, &mask, 0);
+            break;
+        }
+        case NumaPolicy::first_touch:
+            parallel_for(0, static_cast<index_t>(count), parallel_grain_size, [&](index_t first, index_t last) {
+                std::memset(static_cast<char *>(data) + first * elem_size, 0, (last - first) * elem_size);
+            });
+            break;
+        default:
+            break;
+    }
+    return pages;
+}
+
+#else
+
+inline std::shared_ptr<void> map_pages(std::size_t, std::size_t, const MemoryPolicy &) {
+    return nullptr;
+}
+
+#endif
+
+}  // namespace util
+
+/* NUMA queries *******************************************************************************************************/
+
+/* Number of NUMA nodes the process may allocate on. */
+inline std::size_t numa_num_nodes(void) {
+#ifdef __linux__
+    std::size_t count = 0;
+    for (unsigned long word : util::allowed_numa_nodes()) {
+        count += std::popcount(word);
+    }
+    return count;
+#else
+    return 1;
+#endif
+}
+
+/* Returns the NUMA node of each page of the buffer of a contiguous array, in address order. Pages that have not been
+ * written yet have no node and are reported as -ENOENT. */
+template <typename T, std::size_t Dim, typename Derived>
+    requires util::is_contiguous<Derived>
+std::vector<int> numa_nodes(const NdArrayBase<T, Dim, Derived> &arr) {
+#ifdef __linux__
+    const std::size_t page = util::page_size();
+    const std::uintptr_t data = reinterpret_cast<std::uintptr_t>(static_cast<const Derived &>(arr).data());
+    const std::uintptr_t begin = data & ~(page - 1);
+    const std::uintptr_t end = data + arr.nbytes();
+
+    std::vector<void *> pages;
+    for (std::uintptr_t addr = begin; addr < end; addr += page) {
+        pages.push_back(reinterpret_cast<void *>(addr));
+    }
+    std::vector<int> status(pages.size());
+    if (!pages.empty() && syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) != 0) {
+        throw std::system_error(errno, std::generic_category(), "move_pages failed");
+    }
+    return status;
+#else
+    return std::vector<int>(arr.nbytes() > 0 ? 1 : 0, 0);
+#endif
+}
+
+/* Binds the pages of the buffer of a contiguous array to a NUMA node and migrates those already placed elsewhere.
+ * Whole pages are bound, so arrays sharing a page with the buffer are affected too; buffers allocated under a
+ * MemoryPolicy are page-aligned. */
+template <typename T, std::size_t Dim, typename Derived>
+    requires util::is_contiguous<Derived>
+void numa_bind(NdArrayBase<T, Dim, Derived> &arr, int node) {
+    if (node < 0 || static_cast<std::size_t>(node) >= util::max_numa_nodes) {
+        throw std::out_of_range(std::format("NUMA node {} is out of range", node));
+    }
+#ifdef __linux__
+    util::numa_mask_t mask{};
+    mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+    if (arr.nbytes() > 0 && util::bind_pages(static_cast<Derived &>(arr).data(), arr.nbytes(), MPOL_BIND, &mask,
+                                             MPOL_MF_MOVE | MPOL_MF_STRICT) != 0) {
+        throw std::system_error(errno, std::generic_category(), std::format("Cannot bind array to node {}", node));
+    }
+#endif
+}
+
+}  // namespace ndarray
+
+#endif
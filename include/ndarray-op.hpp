@@ -2,792 +2,872 @@
 #define NDARRAY_OP_HPP
 
 #include <cmath>
+#include <memory>
 
 #include "ndarray-base.hpp"
 #include "ndarray-core.hpp"
+#include "ndarray-iter.hpp"
+#include "ndarray-mask.hpp"
 
 namespace ndarray {
 
-/* Unary operators ****************************************************************************************************/
+namespace util {
 
+/* Memory order of an array; only NdArray can be stored in Fortran order. */
 template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator+(const NdArrayBase<T, Dim, Derived> &arr) {
-    NdArray<T, Dim> result(arr.shape());
-    std::size_t size = arr.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = +arr.item(i);
+Order layout_order(const NdArrayBase<T, Dim, Derived> &arr) {
+    if constexpr (requires(const Derived &d) {
+                      { d.order() } -> std::same_as<Order>;
+                  }) {
+        return static_cast<const Derived &>(arr).order();
+    } else {
+        return Order::C;
     }
-    return result;
 }
 
+/* Order in which an element-wise kernel traverses its operands and lays out its result: Fortran order when every
+ * operand is stored in Fortran order, so that all of them are read straight from memory, and C order otherwise. */
+template <typename... Arrays>
+Order traversal_order(const Arrays &...arrs) {
+    return ((layout_order(arrs) == Order::F) && ...) ? Order::F : Order::C;
+}
+
+/* Returns a callable reading the i-th element of an array in the given order. Contiguous arrays are read straight from
+ * their buffer, so the element-wise kernels below compile down to plain loops the compiler can vectorize; a contiguous
+ * array stored in the other order, or a strided view, is first copied once into that order with a strided copy. */
 template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator-(const NdArrayBase<T, Dim, Derived> &arr) {
-    NdArray<T, Dim> result(arr.shape());
-    std::size_t size = arr.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = -arr.item(i);
+auto element_reader(const NdArrayBase<T, Dim, Derived> &arr, Order order) {
+    if constexpr (is_strided<Derived>) {
+        const Derived &derived = static_cast<const Derived &>(arr);
+        const T *data = derived.data();
+        std::shared_ptr<T[]> buffer;
+        if (!is_contiguous<Derived> || layout_order(arr) != order) {
+            buffer.reset(new T[arr.size()]);
+            strided_copy(buffer.get(), order_strides(arr.shape(), order), data, strides_of(derived), arr.shape());
+            data = buffer.get();
+        }
+        return [data, buffer](index_t i) -> const T & { return data[i]; };
+    } else {
+        const bool fortran = order == Order::F;
+        return [&arr, fortran](index_t i) -> const T & {
+            if (fortran) {
+                std::array<index_t, Dim> indices;
+                index_t index = 0;
+                for (std::size_t k = 0; k < Dim; ++k) {
+                    indices[k] = i % arr.shape()[k];
+                    i /= arr.shape()[k];
+                }
+                for (std::size_t k = 0; k < Dim; ++k) {
+                    index = index * arr.shape()[k] + indices[k];
+                }
+                i = index;
+            }
+            return arr.item(i);
+        };
+    }
+}
+
+/* Returns a callable writing the i-th element of an array in its own memory order (see layout_order()). */
+template <typename T, std::size_t Dim, typename Derived>
+auto element_writer(NdArrayBase<T, Dim, Derived> &arr) {
+    if constexpr (is_contiguous<Derived>) {
+        return [data = static_cast<Derived &>(arr).data()](index_t i) -> T & { return data[i]; };
+    } else {
+        return [&arr](index_t i) -> T & { return arr.item(i); };
+    }
+}
+
+/* Copies any array into a C-contiguous NdArray. */
+template <typename T, std::size_t Dim, typename Derived>
+NdArray<T, Dim> materialize(const NdArrayBase<T, Dim, Derived> &arr) {
+    if constexpr (is_strided<Derived>) {
+        NdArray<T, Dim> result(arr.shape());
+        const Derived &derived = static_cast<const Derived &>(arr);
+        strided_copy(result.data(), contiguous_strides(arr.shape()), static_cast<const T *>(derived.data()),
+                     strides_of(derived), arr.shape());
+        return result;
+    } else {
+        return unary_op<T>(arr, [](const T &val) { return val; });
+    }
+}
+
+/* Array type an element-wise operation returns for array operands of the given types, and the type a comparison
+ * returns. Arrays with compile-time extents specialize them to keep their results on the stack. */
+template <typename R, std::size_t Dim, typename... Deriveds>
+class ResultArray {
+public:
+    using type = NdArray<R, Dim>;
+};
+
+template <std::size_t Dim, typename... Deriveds>
+class ResultMask {
+public:
+    using type = NdArrayMask<Dim>;
+};
+
+template <typename R, std::size_t Dim, typename... Deriveds>
+using result_array_t = typename ResultArray<R, Dim, std::remove_cv_t<Deriveds>...>::type;
+
+template <std::size_t Dim, typename... Deriveds>
+using result_mask_t = typename ResultMask<Dim, std::remove_cv_t<Deriveds>...>::type;
+
+/* Results whose size is a compile-time constant. Their operands have the same compile-time extents, so the kernels
+ * below skip the shape check and run a loop of fixed trip count over the operand buffers. */
+template <typename Result>
+concept is_fixed_size = requires { Result::fixed_size; };
+
+/* Element-wise kernels. Operands are converted to the computation type C on the fly, so mixed-type operations never
+ * materialize a converted copy of an operand. Results are laid out in the traversal order of the operands. Strided
+ * operands, including slices and arrays stored in different orders, are traversed together by nditer(), which hands
+ * the loops below runs as long as their layouts allow; other arrays are read element by element. */
+
+template <typename R, typename C = R, typename T, std::size_t Dim, typename Derived, typename Op>
+    requires is_fixed_size<result_array_t<R, Dim, Derived>>
+result_array_t<R, Dim, Derived> unary_op(const NdArrayBase<T, Dim, Derived> &arr, Op op) {
+    using Result = result_array_t<R, Dim, Derived>;
+    Result result;
+    R *out = result.data();
+    const T *in = static_cast<const Derived &>(arr).data();
+    for (index_t i = 0; i < Result::fixed_size; ++i) {
+        out[i] = static_cast<R>(op(convert<C>(in[i])));
+    }
+    return result;
+}
+
+template <typename R, typename C = R, typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2,
+          typename Op>
+    requires is_fixed_size<result_array_t<R, Dim, Derived1, Derived2>>
+result_array_t<R, Dim, Derived1, Derived2> binary_op(const NdArrayBase<T1, Dim, Derived1> &lhs,
+                                                     const NdArrayBase<T2, Dim, Derived2> &rhs, Op op) {
+    using Result = result_array_t<R, Dim, Derived1, Derived2>;
+    Result result;
+    R *out = result.data();
+    const T1 *in1 = static_cast<const Derived1 &>(lhs).data();
+    const T2 *in2 = static_cast<const Derived2 &>(rhs).data();
+    for (index_t i = 0; i < Result::fixed_size; ++i) {
+        out[i] = static_cast<R>(op(convert<C>(in1[i]), convert<C>(in2[i])));
+    }
+    return result;
+}
+
+template <typename R, typename C = R, typename T, std::size_t Dim, typename Derived, typename Op>
+result_array_t<R, Dim, Derived> unary_op(const NdArrayBase<T, Dim, Derived> &arr, Op op) {
+    const Order order = traversal_order(arr);
+    NdArray<R, Dim> result(arr.shape(), order);
+    if constexpr (is_strided<Derived>) {
+        nditer(
+            [&op](index_t length, const std::array<index_t, 2> &strides, R *out, const T *in) {
+                for_each_in_run(
+                    length, strides, [&op](R &o, const T &val) { o = static_cast<R>(op(convert<C>(val))); }, out, in);
+            },
+            result, static_cast<const Derived &>(arr));
+    } else {
+        R *out = result.data();
+        auto in = element_reader(arr, order);
+        const index_t size = arr.size();
+        for (index_t i = 0; i < size; ++i) {
+            out[i] = static_cast<R>(op(convert<C>(in(i))));
+        }
     }
     return result;
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<bool, Dim> operator!(const NdArrayBase<T, Dim, Derived> &arr) {
-    NdArray<bool, Dim> result(arr.shape());
-    std::size_t size = arr.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = !arr.item(i);
+template <typename R, typename C = R, typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2,
+          typename Op>
+result_array_t<R, Dim, Derived1, Derived2> binary_op(const NdArrayBase<T1, Dim, Derived1> &lhs,
+                                                     const NdArrayBase<T2, Dim, Derived2> &rhs, Op op) {
+    validate_shape_binary_op(lhs.shape(), rhs.shape());
+
+    const Order order = traversal_order(lhs, rhs);
+    NdArray<R, Dim> result(lhs.shape(), order);
+    if constexpr (is_strided<Derived1> && is_strided<Derived2>) {
+        nditer(
+            [&op](index_t length, const std::array<index_t, 3> &strides, R *out, const T1 *in1, const T2 *in2) {
+                for_each_in_run(
+                    length, strides,
+                    [&op](R &o, const T1 &val1, const T2 &val2) {
+                        o = static_cast<R>(op(convert<C>(val1), convert<C>(val2)));
+                    },
+                    out, in1, in2);
+            },
+            result, static_cast<const Derived1 &>(lhs), static_cast<const Derived2 &>(rhs));
+    } else {
+        R *out = result.data();
+        auto in1 = element_reader(lhs, order);
+        auto in2 = element_reader(rhs, order);
+        const index_t size = lhs.size();
+        for (index_t i = 0; i < size; ++i) {
+            out[i] = static_cast<R>(op(convert<C>(in1(i)), convert<C>(in2(i))));
+        }
     }
     return result;
 }
 
-/* Comparison operators ***********************************************************************************************/
+template <typename R, typename C = R, typename S, typename T, std::size_t Dim, typename Derived, typename Op>
+result_array_t<R, Dim, Derived> binary_op_scalar_lhs(const S &lhs, const NdArrayBase<T, Dim, Derived> &rhs, Op op) {
+    const C &scalar = convert<C>(lhs);
+    return unary_op<R, C>(rhs, [&scalar, &op](const C &val) { return op(scalar, val); });
+}
+
+template <typename R, typename C = R, typename T, typename S, std::size_t Dim, typename Derived, typename Op>
+result_array_t<R, Dim, Derived> binary_op_scalar_rhs(const NdArrayBase<T, Dim, Derived> &lhs, const S &rhs, Op op) {
+    const C &scalar = convert<C>(rhs);
+    return unary_op<R, C>(lhs, [&scalar, &op](const C &val) { return op(val, scalar); });
+}
+
+/* Comparison kernels. Results are packed into a mask 64 elements at a time, or into a bool array for fixed-size
+ * operands. */
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-const NdArray<bool, Dim> operator==(const NdArrayBase<T, Dim, Derived1> &lhs,
-                                    const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
+template <typename C, typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2, typename Op>
+result_mask_t<Dim, Derived1, Derived2> compare_op(const NdArrayBase<T1, Dim, Derived1> &lhs,
+                                                  const NdArrayBase<T2, Dim, Derived2> &rhs, Op op) {
+    if constexpr (is_fixed_size<result_mask_t<Dim, Derived1, Derived2>>) {
+        return binary_op<bool, C>(lhs, rhs, op);
+    } else {
+        validate_shape_binary_op(lhs.shape(), rhs.shape());
 
-    NdArray<bool, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) == rhs.item(i);
+        auto in1 = element_reader(lhs);
+        auto in2 = element_reader(rhs);
+        return build_mask(lhs.shape(), [&](index_t i) { return op(convert<C>(in1(i)), convert<C>(in2(i))); });
     }
-    return result;
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<bool, Dim> operator==(const T &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
-    NdArray<bool, Dim> result(rhs.shape());
-    std::size_t size = rhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs == rhs.item(i);
+template <typename C, typename T, std::size_t Dim, typename Derived, typename Pred>
+result_mask_t<Dim, Derived> predicate_op(const NdArrayBase<T, Dim, Derived> &arr, Pred pred) {
+    if constexpr (is_fixed_size<result_mask_t<Dim, Derived>>) {
+        return unary_op<bool, C>(arr, pred);
+    } else {
+        auto in = element_reader(arr);
+        return build_mask(arr.shape(), [&](index_t i) { return pred(convert<C>(in(i))); });
     }
-    return result;
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<bool, Dim> operator==(const NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    NdArray<bool, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) == rhs;
-    }
-    return result;
+template <typename C, typename S, typename T, std::size_t Dim, typename Derived, typename Op>
+result_mask_t<Dim, Derived> compare_op_scalar_lhs(const S &lhs, const NdArrayBase<T, Dim, Derived> &rhs, Op op) {
+    const C &scalar = convert<C>(lhs);
+    return predicate_op<C>(rhs, [&scalar, &op](const C &val) { return op(scalar, val); });
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-const NdArray<bool, Dim> operator!=(const NdArrayBase<T, Dim, Derived1> &lhs,
-                                    const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
+template <typename C, typename T, typename S, std::size_t Dim, typename Derived, typename Op>
+result_mask_t<Dim, Derived> compare_op_scalar_rhs(const NdArrayBase<T, Dim, Derived> &lhs, const S &rhs, Op op) {
+    const C &scalar = convert<C>(rhs);
+    return predicate_op<C>(lhs, [&scalar, &op](const C &val) { return op(val, scalar); });
+}
 
-    NdArray<bool, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) != rhs.item(i);
+/* In-place kernels. Op updates its first argument; when the operand types differ, the update is done in the promoted
+ * type and cast back to the type of the left-hand side. A strided right-hand side that shares memory with the
+ * left-hand side, other than the very same elements, is copied first, so the result is as if it had been read before
+ * any update. */
+
+template <typename C, typename T, typename U, typename Op>
+void compound_update(T &out, const U &in, Op &op) {
+    if constexpr (std::is_same_v<C, T>) {
+        op(out, convert<C>(in));
+    } else {
+        C val = static_cast<C>(out);
+        op(val, convert<C>(in));
+        out = static_cast<T>(val);
     }
-    return result;
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<bool, Dim> operator!=(const T &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
-    NdArray<bool, Dim> result(rhs.shape());
-    std::size_t size = rhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs != rhs.item(i);
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2, typename Op>
+void compound_op(NdArrayBase<T1, Dim, Derived1> &lhs, const NdArrayBase<T2, Dim, Derived2> &rhs, Op op) {
+    validate_shape_binary_op(lhs.shape(), rhs.shape());
+
+    using C = promote_t<T1, T2>;
+    if constexpr (is_strided<Derived1> && is_strided<Derived2>) {
+        Derived1 &dst = static_cast<Derived1 &>(lhs);
+        const Derived2 &src = static_cast<const Derived2 &>(rhs);
+        const bool same_elements = static_cast<const void *>(dst.data()) == static_cast<const void *>(src.data()) &&
+                                   strides_of(dst) == strides_of(src);
+        if (!same_elements && may_overlap(static_cast<const T1 *>(dst.data()), strides_of(dst),
+                                          static_cast<const T2 *>(src.data()), strides_of(src), lhs.shape())) {
+            compound_op(lhs, materialize(rhs), op);
+            return;
+        }
+        nditer(
+            [&op](index_t length, const std::array<index_t, 2> &strides, T1 *out, const T2 *in) {
+                for_each_in_run(
+                    length, strides, [&op](T1 &o, const T2 &val) { compound_update<C>(o, val, op); }, out, in);
+            },
+            dst, src);
+    } else {
+        auto out = element_writer(lhs);
+        auto in = element_reader(rhs, layout_order(lhs));
+        const index_t size = lhs.size();
+        for (index_t i = 0; i < size; ++i) {
+            compound_update<C>(out(i), in(i), op);
+        }
     }
-    return result;
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<bool, Dim> operator!=(const NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    NdArray<bool, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) != rhs;
+template <typename T, typename S, std::size_t Dim, typename Derived, typename Op>
+void compound_op_scalar(NdArrayBase<T, Dim, Derived> &lhs, const S &rhs, Op op) {
+    using C = weak_promote_t<T, S>;
+    const C &scalar = convert<C>(rhs);
+    if constexpr (is_strided<Derived>) {
+        nditer(
+            [&op, &scalar](index_t length, const std::array<index_t, 1> &strides, T *out) {
+                for_each_in_run(length, strides, [&op, &scalar](T &o) { compound_update<C>(o, scalar, op); }, out);
+            },
+            static_cast<Derived &>(lhs));
+    } else {
+        auto out = element_writer(lhs);
+        const index_t size = lhs.size();
+        for (index_t i = 0; i < size; ++i) {
+            compound_update<C>(out(i), scalar, op);
+        }
     }
-    return result;
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-const NdArray<bool, Dim> operator<(const NdArrayBase<T, Dim, Derived1> &lhs, const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
+}  // namespace util
 
-    NdArray<bool, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) < rhs.item(i);
-    }
-    return result;
+/* Unary operators ****************************************************************************************************/
+
+template <typename T, std::size_t Dim, typename Derived>
+const util::result_array_t<T, Dim, Derived> operator+(const NdArrayBase<T, Dim, Derived> &arr) {
+    return util::unary_op<T>(arr, [](const T &val) { return +val; });
 }
 
 template <typename T, std::size_t Dim, typename Derived>
-const NdArray<bool, Dim> operator<(const T &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
-    NdArray<bool, Dim> result(rhs.shape());
-    std::size_t size = rhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs < rhs.item(i);
-    }
-    return result;
+const util::result_array_t<T, Dim, Derived> operator-(const NdArrayBase<T, Dim, Derived> &arr) {
+    return util::unary_op<T>(arr, [](const T &val) { return -val; });
 }
 
 template <typename T, std::size_t Dim, typename Derived>
-const NdArray<bool, Dim> operator<(const NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    NdArray<bool, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) < rhs;
-    }
-    return result;
+const util::result_mask_t<Dim, Derived> operator!(const NdArrayBase<T, Dim, Derived> &arr) {
+    return util::predicate_op<T>(arr, [](const T &val) { return !val; });
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-const NdArray<bool, Dim> operator>(const NdArrayBase<T, Dim, Derived1> &lhs, const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
+/* Comparison operators ***********************************************************************************************/
 
-    NdArray<bool, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) > rhs.item(i);
-    }
-    return result;
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+const util::result_mask_t<Dim, Derived1, Derived2> operator==(const NdArrayBase<T1, Dim, Derived1> &lhs,
+                                                              const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    using C = util::promote_t<T1, T2>;
+    return util::compare_op<C>(lhs, rhs, [](const C &a, const C &b) { return a == b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<bool, Dim> operator>(const T &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
-    NdArray<bool, Dim> result(rhs.shape());
-    std::size_t size = rhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs > rhs.item(i);
-    }
-    return result;
+template <typename S, typename T, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_mask_t<Dim, Derived> operator==(const S &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
+    using C = util::weak_promote_t<T, S>;
+    return util::compare_op_scalar_lhs<C>(lhs, rhs, [](const C &a, const C &b) { return a == b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<bool, Dim> operator>(const NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    NdArray<bool, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) > rhs;
-    }
-    return result;
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_mask_t<Dim, Derived> operator==(const NdArrayBase<T, Dim, Derived> &lhs, const S &rhs) {
+    using C = util::weak_promote_t<T, S>;
+    return util::compare_op_scalar_rhs<C>(lhs, rhs, [](const C &a, const C &b) { return a == b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-const NdArray<bool, Dim> operator<=(const NdArrayBase<T, Dim, Derived1> &lhs,
-                                    const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+const util::result_mask_t<Dim, Derived1, Derived2> operator!=(const NdArrayBase<T1, Dim, Derived1> &lhs,
+                                                              const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    using C = util::promote_t<T1, T2>;
+    return util::compare_op<C>(lhs, rhs, [](const C &a, const C &b) { return a != b; });
+}
 
-    NdArray<bool, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) <= rhs.item(i);
-    }
-    return result;
+template <typename S, typename T, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_mask_t<Dim, Derived> operator!=(const S &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
+    using C = util::weak_promote_t<T, S>;
+    return util::compare_op_scalar_lhs<C>(lhs, rhs, [](const C &a, const C &b) { return a != b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<bool, Dim> operator<=(const T &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
-    NdArray<bool, Dim> result(rhs.shape());
-    std::size_t size = rhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs <= rhs.item(i);
-    }
-    return result;
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_mask_t<Dim, Derived> operator!=(const NdArrayBase<T, Dim, Derived> &lhs, const S &rhs) {
+    using C = util::weak_promote_t<T, S>;
+    return util::compare_op_scalar_rhs<C>(lhs, rhs, [](const C &a, const C &b) { return a != b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<bool, Dim> operator<=(const NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    NdArray<bool, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) <= rhs;
-    }
-    return result;
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+const util::result_mask_t<Dim, Derived1, Derived2> operator<(const NdArrayBase<T1, Dim, Derived1> &lhs,
+                                                             const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    using C = util::promote_t<T1, T2>;
+    return util::compare_op<C>(lhs, rhs, [](const C &a, const C &b) { return a < b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-const NdArray<bool, Dim> operator>=(const NdArrayBase<T, Dim, Derived1> &lhs,
-                                    const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
+template <typename S, typename T, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_mask_t<Dim, Derived> operator<(const S &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
+    using C = util::weak_promote_t<T, S>;
+    return util::compare_op_scalar_lhs<C>(lhs, rhs, [](const C &a, const C &b) { return a < b; });
+}
 
-    NdArray<bool, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) >= rhs.item(i);
-    }
-    return result;
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_mask_t<Dim, Derived> operator<(const NdArrayBase<T, Dim, Derived> &lhs, const S &rhs) {
+    using C = util::weak_promote_t<T, S>;
+    return util::compare_op_scalar_rhs<C>(lhs, rhs, [](const C &a, const C &b) { return a < b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<bool, Dim> operator>=(const T &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
-    NdArray<bool, Dim> result(rhs.shape());
-    std::size_t size = rhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs >= rhs.item(i);
-    }
-    return result;
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+const util::result_mask_t<Dim, Derived1, Derived2> operator>(const NdArrayBase<T1, Dim, Derived1> &lhs,
+                                                             const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    using C = util::promote_t<T1, T2>;
+    return util::compare_op<C>(lhs, rhs, [](const C &a, const C &b) { return a > b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<bool, Dim> operator>=(const NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    NdArray<bool, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) >= rhs;
-    }
-    return result;
+template <typename S, typename T, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_mask_t<Dim, Derived> operator>(const S &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
+    using C = util::weak_promote_t<T, S>;
+    return util::compare_op_scalar_lhs<C>(lhs, rhs, [](const C &a, const C &b) { return a > b; });
 }
 
-/* Binary arithmetic operators ****************************************************************************************/
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_mask_t<Dim, Derived> operator>(const NdArrayBase<T, Dim, Derived> &lhs, const S &rhs) {
+    using C = util::weak_promote_t<T, S>;
+    return util::compare_op_scalar_rhs<C>(lhs, rhs, [](const C &a, const C &b) { return a > b; });
+}
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-const NdArray<T, Dim> operator+(const NdArrayBase<T, Dim, Derived1> &lhs, const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+const util::result_mask_t<Dim, Derived1, Derived2> operator<=(const NdArrayBase<T1, Dim, Derived1> &lhs,
+                                                              const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    using C = util::promote_t<T1, T2>;
+    return util::compare_op<C>(lhs, rhs, [](const C &a, const C &b) { return a <= b; });
+}
 
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) + rhs.item(i);
-    }
-    return result;
+template <typename S, typename T, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_mask_t<Dim, Derived> operator<=(const S &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
+    using C = util::weak_promote_t<T, S>;
+    return util::compare_op_scalar_lhs<C>(lhs, rhs, [](const C &a, const C &b) { return a <= b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator+(const T &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
-    NdArray<T, Dim> result(rhs.shape());
-    std::size_t size = rhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs + rhs.item(i);
-    }
-    return result;
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_mask_t<Dim, Derived> operator<=(const NdArrayBase<T, Dim, Derived> &lhs, const S &rhs) {
+    using C = util::weak_promote_t<T, S>;
+    return util::compare_op_scalar_rhs<C>(lhs, rhs, [](const C &a, const C &b) { return a <= b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator+(const NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) + rhs;
-    }
-    return result;
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+const util::result_mask_t<Dim, Derived1, Derived2> operator>=(const NdArrayBase<T1, Dim, Derived1> &lhs,
+                                                              const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    using C = util::promote_t<T1, T2>;
+    return util::compare_op<C>(lhs, rhs, [](const C &a, const C &b) { return a >= b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-const NdArray<T, Dim> operator-(const NdArrayBase<T, Dim, Derived1> &lhs, const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
+template <typename S, typename T, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_mask_t<Dim, Derived> operator>=(const S &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
+    using C = util::weak_promote_t<T, S>;
+    return util::compare_op_scalar_lhs<C>(lhs, rhs, [](const C &a, const C &b) { return a >= b; });
+}
 
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) - rhs.item(i);
-    }
-    return result;
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_mask_t<Dim, Derived> operator>=(const NdArrayBase<T, Dim, Derived> &lhs, const S &rhs) {
+    using C = util::weak_promote_t<T, S>;
+    return util::compare_op_scalar_rhs<C>(lhs, rhs, [](const C &a, const C &b) { return a >= b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator-(const T &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
-    NdArray<T, Dim> result(rhs.shape());
-    std::size_t size = rhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs - rhs.item(i);
-    }
-    return result;
+/* Binary arithmetic operators ****************************************************************************************/
+
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+const util::result_array_t<util::promote_t<T1, T2>, Dim, Derived1, Derived2> operator+(
+    const NdArrayBase<T1, Dim, Derived1> &lhs, const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    using R = util::promote_t<T1, T2>;
+    return util::binary_op<R>(lhs, rhs, [](const R &a, const R &b) { return a + b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator-(const NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) - rhs;
-    }
-    return result;
+template <typename S, typename T, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator+(
+    const S &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_lhs<R>(lhs, rhs, [](const R &a, const R &b) { return a + b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-const NdArray<T, Dim> operator*(const NdArrayBase<T, Dim, Derived1> &lhs, const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator+(const NdArrayBase<T, Dim, Derived> &lhs,
+                                                                               const S &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_rhs<R>(lhs, rhs, [](const R &a, const R &b) { return a + b; });
+}
 
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) * rhs.item(i);
-    }
-    return result;
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+const util::result_array_t<util::promote_t<T1, T2>, Dim, Derived1, Derived2> operator-(
+    const NdArrayBase<T1, Dim, Derived1> &lhs, const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    using R = util::promote_t<T1, T2>;
+    return util::binary_op<R>(lhs, rhs, [](const R &a, const R &b) { return a - b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator*(const T &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
-    NdArray<T, Dim> result(rhs.shape());
-    std::size_t size = rhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs * rhs.item(i);
-    }
-    return result;
+template <typename S, typename T, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator-(
+    const S &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_lhs<R>(lhs, rhs, [](const R &a, const R &b) { return a - b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator*(const NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) * rhs;
-    }
-    return result;
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator-(const NdArrayBase<T, Dim, Derived> &lhs,
+                                                                               const S &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_rhs<R>(lhs, rhs, [](const R &a, const R &b) { return a - b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-const NdArray<T, Dim> operator/(const NdArrayBase<T, Dim, Derived1> &lhs, const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+const util::result_array_t<util::promote_t<T1, T2>, Dim, Derived1, Derived2> operator*(
+    const NdArrayBase<T1, Dim, Derived1> &lhs, const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    using R = util::promote_t<T1, T2>;
+    return util::binary_op<R>(lhs, rhs, [](const R &a, const R &b) { return a * b; });
+}
 
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) / rhs.item(i);
-    }
-    return result;
+template <typename S, typename T, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator*(
+    const S &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_lhs<R>(lhs, rhs, [](const R &a, const R &b) { return a * b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator/(const T &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
-    NdArray<T, Dim> result(rhs.shape());
-    std::size_t size = rhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs / rhs.item(i);
-    }
-    return result;
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator*(const NdArrayBase<T, Dim, Derived> &lhs,
+                                                                               const S &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_rhs<R>(lhs, rhs, [](const R &a, const R &b) { return a * b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator/(const NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) / rhs;
-    }
-    return result;
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+const util::result_array_t<util::promote_t<T1, T2>, Dim, Derived1, Derived2> operator/(
+    const NdArrayBase<T1, Dim, Derived1> &lhs, const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    using R = util::promote_t<T1, T2>;
+    return util::binary_op<R>(lhs, rhs, [](const R &a, const R &b) { return a / b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-const NdArray<T, Dim> operator%(const NdArrayBase<T, Dim, Derived1> &lhs, const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
+template <typename S, typename T, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator/(
+    const S &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_lhs<R>(lhs, rhs, [](const R &a, const R &b) { return a / b; });
+}
+
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator/(const NdArrayBase<T, Dim, Derived> &lhs,
+                                                                               const S &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_rhs<R>(lhs, rhs, [](const R &a, const R &b) { return a / b; });
+}
 
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        if constexpr (std::is_floating_point_v<T>) {
-            result.item(i) = std::fmod(lhs.item(i), rhs.item(i));
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+const util::result_array_t<util::promote_t<T1, T2>, Dim, Derived1, Derived2> operator%(
+    const NdArrayBase<T1, Dim, Derived1> &lhs, const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    using R = util::promote_t<T1, T2>;
+    return util::binary_op<R>(lhs, rhs, [](const R &a, const R &b) {
+        if constexpr (std::is_floating_point_v<R>) {
+            return std::fmod(a, b);
         } else {
-            result.item(i) = lhs.item(i) % rhs.item(i);
+            return a % b;
         }
-    }
-    return result;
+    });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator%(const T &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
-    NdArray<T, Dim> result(rhs.shape());
-    std::size_t size = rhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        if constexpr (std::is_floating_point_v<T>) {
-            result.item(i) = std::fmod(lhs, rhs.item(i));
+template <typename S, typename T, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator%(
+    const S &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_lhs<R>(lhs, rhs, [](const R &a, const R &b) {
+        if constexpr (std::is_floating_point_v<R>) {
+            return std::fmod(a, b);
         } else {
-            result.item(i) = lhs % rhs.item(i);
+            return a % b;
         }
-    }
-    return result;
+    });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator%(const NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        if constexpr (std::is_floating_point_v<T>) {
-            result.item(i) = std::fmod(lhs.item(i), rhs);
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator%(const NdArrayBase<T, Dim, Derived> &lhs,
+                                                                               const S &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_rhs<R>(lhs, rhs, [](const R &a, const R &b) {
+        if constexpr (std::is_floating_point_v<R>) {
+            return std::fmod(a, b);
         } else {
-            result.item(i) = lhs.item(i) % rhs;
+            return a % b;
         }
-    }
-    return result;
+    });
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-const NdArray<T, Dim> operator<<(const NdArrayBase<T, Dim, Derived1> &lhs, const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
-
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) << rhs.item(i);
-    }
-    return result;
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+const util::result_array_t<util::promote_t<T1, T2>, Dim, Derived1, Derived2> operator<<(
+    const NdArrayBase<T1, Dim, Derived1> &lhs, const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    using R = util::promote_t<T1, T2>;
+    return util::binary_op<R>(lhs, rhs, [](const R &a, const R &b) { return a << b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator<<(const T &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
-    NdArray<T, Dim> result(rhs.shape());
-    std::size_t size = rhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs << rhs.item(i);
-    }
-    return result;
+template <typename S, typename T, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator<<(
+    const S &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_lhs<R>(lhs, rhs, [](const R &a, const R &b) { return a << b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator<<(const NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) << rhs;
-    }
-    return result;
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator<<(const NdArrayBase<T, Dim, Derived> &lhs,
+                                                                                const S &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_rhs<R>(lhs, rhs, [](const R &a, const R &b) { return a << b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-const NdArray<T, Dim> operator>>(const NdArrayBase<T, Dim, Derived1> &lhs, const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
-
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) >> rhs.item(i);
-    }
-    return result;
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+const util::result_array_t<util::promote_t<T1, T2>, Dim, Derived1, Derived2> operator>>(
+    const NdArrayBase<T1, Dim, Derived1> &lhs, const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    using R = util::promote_t<T1, T2>;
+    return util::binary_op<R>(lhs, rhs, [](const R &a, const R &b) { return a >> b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator>>(const T &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
-    NdArray<T, Dim> result(rhs.shape());
-    std::size_t size = rhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs >> rhs.item(i);
-    }
-    return result;
+template <typename S, typename T, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator>>(
+    const S &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_lhs<R>(lhs, rhs, [](const R &a, const R &b) { return a >> b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator>>(const NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) >> rhs;
-    }
-    return result;
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator>>(const NdArrayBase<T, Dim, Derived> &lhs,
+                                                                                const S &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_rhs<R>(lhs, rhs, [](const R &a, const R &b) { return a >> b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-const NdArray<T, Dim> operator&(const NdArrayBase<T, Dim, Derived1> &lhs, const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
-
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) & rhs.item(i);
-    }
-    return result;
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+const util::result_array_t<util::promote_t<T1, T2>, Dim, Derived1, Derived2> operator&(
+    const NdArrayBase<T1, Dim, Derived1> &lhs, const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    using R = util::promote_t<T1, T2>;
+    return util::binary_op<R>(lhs, rhs, [](const R &a, const R &b) { return a & b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator&(const T &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
-    NdArray<T, Dim> result(rhs.shape());
-    std::size_t size = rhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs & rhs.item(i);
-    }
-    return result;
+template <typename S, typename T, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator&(
+    const S &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_lhs<R>(lhs, rhs, [](const R &a, const R &b) { return a & b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator&(const NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) & rhs;
-    }
-    return result;
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator&(const NdArrayBase<T, Dim, Derived> &lhs,
+                                                                               const S &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_rhs<R>(lhs, rhs, [](const R &a, const R &b) { return a & b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-const NdArray<T, Dim> operator^(const NdArrayBase<T, Dim, Derived1> &lhs, const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
-
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) ^ rhs.item(i);
-    }
-    return result;
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+const util::result_array_t<util::promote_t<T1, T2>, Dim, Derived1, Derived2> operator^(
+    const NdArrayBase<T1, Dim, Derived1> &lhs, const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    using R = util::promote_t<T1, T2>;
+    return util::binary_op<R>(lhs, rhs, [](const R &a, const R &b) { return a ^ b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator^(const T &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
-    NdArray<T, Dim> result(rhs.shape());
-    std::size_t size = rhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs ^ rhs.item(i);
-    }
-    return result;
+template <typename S, typename T, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator^(
+    const S &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_lhs<R>(lhs, rhs, [](const R &a, const R &b) { return a ^ b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator^(const NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) ^ rhs;
-    }
-    return result;
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator^(const NdArrayBase<T, Dim, Derived> &lhs,
+                                                                               const S &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_rhs<R>(lhs, rhs, [](const R &a, const R &b) { return a ^ b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-const NdArray<T, Dim> operator|(const NdArrayBase<T, Dim, Derived1> &lhs, const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
-
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) | rhs.item(i);
-    }
-    return result;
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+const util::result_array_t<util::promote_t<T1, T2>, Dim, Derived1, Derived2> operator|(
+    const NdArrayBase<T1, Dim, Derived1> &lhs, const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    using R = util::promote_t<T1, T2>;
+    return util::binary_op<R>(lhs, rhs, [](const R &a, const R &b) { return a | b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator|(const T &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
-    NdArray<T, Dim> result(rhs.shape());
-    std::size_t size = rhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs | rhs.item(i);
-    }
-    return result;
+template <typename S, typename T, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator|(
+    const S &lhs, const NdArrayBase<T, Dim, Derived> &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_lhs<R>(lhs, rhs, [](const R &a, const R &b) { return a | b; });
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-const NdArray<T, Dim> operator|(const NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    NdArray<T, Dim> result(lhs.shape());
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        result.item(i) = lhs.item(i) | rhs;
-    }
-    return result;
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+const util::result_array_t<util::weak_promote_t<T, S>, Dim, Derived> operator|(const NdArrayBase<T, Dim, Derived> &lhs,
+                                                                               const S &rhs) {
+    using R = util::weak_promote_t<T, S>;
+    return util::binary_op_scalar_rhs<R>(lhs, rhs, [](const R &a, const R &b) { return a | b; });
 }
 
 /* Compound assignment operators **************************************************************************************/
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-NdArrayBase<T, Dim, Derived1> &operator+=(NdArrayBase<T, Dim, Derived1> &lhs,
-                                          const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
-
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        lhs.item(i) += rhs.item(i);
-    }
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+NdArrayBase<T1, Dim, Derived1> &operator+=(NdArrayBase<T1, Dim, Derived1> &lhs,
+                                            const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    util::compound_op(lhs, rhs, [](auto &a, const auto &b) { a += b; });
     return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-NdArrayBase<T, Dim, Derived> &operator+=(NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        lhs.item(i) += rhs;
-    }
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+NdArrayBase<T, Dim, Derived> &operator+=(NdArrayBase<T, Dim, Derived> &lhs, const S &rhs) {
+    util::compound_op_scalar(lhs, rhs, [](auto &a, const auto &b) { a += b; });
     return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-NdArrayBase<T, Dim, Derived1> &operator-=(NdArrayBase<T, Dim, Derived1> &lhs,
-                                          const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
-
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        lhs.item(i) -= rhs.item(i);
-    }
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+NdArrayBase<T1, Dim, Derived1> &operator-=(NdArrayBase<T1, Dim, Derived1> &lhs,
+                                            const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    util::compound_op(lhs, rhs, [](auto &a, const auto &b) { a -= b; });
     return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-NdArrayBase<T, Dim, Derived> &operator-=(NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        lhs.item(i) -= rhs;
-    }
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+NdArrayBase<T, Dim, Derived> &operator-=(NdArrayBase<T, Dim, Derived> &lhs, const S &rhs) {
+    util::compound_op_scalar(lhs, rhs, [](auto &a, const auto &b) { a -= b; });
     return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-NdArrayBase<T, Dim, Derived1> &operator*=(NdArrayBase<T, Dim, Derived1> &lhs,
-                                          const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
-
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        lhs.item(i) *= rhs.item(i);
-    }
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+NdArrayBase<T1, Dim, Derived1> &operator*=(NdArrayBase<T1, Dim, Derived1> &lhs,
+                                            const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    util::compound_op(lhs, rhs, [](auto &a, const auto &b) { a *= b; });
     return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-NdArrayBase<T, Dim, Derived> &operator*=(NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        lhs.item(i) *= rhs;
-    }
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+NdArrayBase<T, Dim, Derived> &operator*=(NdArrayBase<T, Dim, Derived> &lhs, const S &rhs) {
+    util::compound_op_scalar(lhs, rhs, [](auto &a, const auto &b) { a *= b; });
     return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-NdArrayBase<T, Dim, Derived1> &operator/=(NdArrayBase<T, Dim, Derived1> &lhs,
-                                          const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
-
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        lhs.item(i) /= rhs.item(i);
-    }
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+NdArrayBase<T1, Dim, Derived1> &operator/=(NdArrayBase<T1, Dim, Derived1> &lhs,
+                                            const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    util::compound_op(lhs, rhs, [](auto &a, const auto &b) { a /= b; });
     return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-NdArrayBase<T, Dim, Derived> &operator/=(NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        lhs.item(i) /= rhs;
-    }
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+NdArrayBase<T, Dim, Derived> &operator/=(NdArrayBase<T, Dim, Derived> &lhs, const S &rhs) {
+    util::compound_op_scalar(lhs, rhs, [](auto &a, const auto &b) { a /= b; });
     return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-NdArrayBase<T, Dim, Derived1> &operator%=(NdArrayBase<T, Dim, Derived1> &lhs,
-                                          const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
-
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        if constexpr (std::is_floating_point_v<T>) {
-            lhs.item(i) = std::fmod(lhs.item(i), rhs.item(i));
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+NdArrayBase<T1, Dim, Derived1> &operator%=(NdArrayBase<T1, Dim, Derived1> &lhs,
+                                            const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    util::compound_op(lhs, rhs, [](auto &a, const auto &b) {
+        if constexpr (std::is_floating_point_v<std::remove_cvref_t<decltype(a)>>) {
+            a = std::fmod(a, b);
         } else {
-            lhs.item(i) %= rhs.item(i);
+            a %= b;
         }
-    }
+    });
     return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-NdArrayBase<T, Dim, Derived> &operator%=(NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        if constexpr (std::is_floating_point_v<T>) {
-            lhs.item(i) = std::fmod(lhs.item(i), rhs);
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+NdArrayBase<T, Dim, Derived> &operator%=(NdArrayBase<T, Dim, Derived> &lhs, const S &rhs) {
+    util::compound_op_scalar(lhs, rhs, [](auto &a, const auto &b) {
+        if constexpr (std::is_floating_point_v<std::remove_cvref_t<decltype(a)>>) {
+            a = std::fmod(a, b);
         } else {
-            lhs.item(i) %= rhs;
+            a %= b;
         }
-    }
+    });
+    return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-NdArrayBase<T, Dim, Derived1> &operator<<=(NdArrayBase<T, Dim, Derived1> &lhs,
-                                           const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
-
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        lhs.item(i) <<= rhs.item(i);
-    }
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+NdArrayBase<T1, Dim, Derived1> &operator<<=(NdArrayBase<T1, Dim, Derived1> &lhs,
+                                             const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    util::compound_op(lhs, rhs, [](auto &a, const auto &b) { a <<= b; });
     return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-NdArrayBase<T, Dim, Derived> &operator<<=(NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        lhs.item(i) <<= rhs;
-    }
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+NdArrayBase<T, Dim, Derived> &operator<<=(NdArrayBase<T, Dim, Derived> &lhs, const S &rhs) {
+    util::compound_op_scalar(lhs, rhs, [](auto &a, const auto &b) { a <<= b; });
     return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-NdArrayBase<T, Dim, Derived1> &operator>>=(NdArrayBase<T, Dim, Derived1> &lhs,
-                                           const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
-
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        lhs.item(i) >>= rhs.item(i);
-    }
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+NdArrayBase<T1, Dim, Derived1> &operator>>=(NdArrayBase<T1, Dim, Derived1> &lhs,
+                                             const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    util::compound_op(lhs, rhs, [](auto &a, const auto &b) { a >>= b; });
     return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-NdArrayBase<T, Dim, Derived> &operator>>=(NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        lhs.item(i) >>= rhs;
-    }
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+NdArrayBase<T, Dim, Derived> &operator>>=(NdArrayBase<T, Dim, Derived> &lhs, const S &rhs) {
+    util::compound_op_scalar(lhs, rhs, [](auto &a, const auto &b) { a >>= b; });
     return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-NdArrayBase<T, Dim, Derived1> &operator&=(NdArrayBase<T, Dim, Derived1> &lhs,
-                                          const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
-
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        lhs.item(i) &= rhs.item(i);
-    }
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+NdArrayBase<T1, Dim, Derived1> &operator&=(NdArrayBase<T1, Dim, Derived1> &lhs,
+                                            const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    util::compound_op(lhs, rhs, [](auto &a, const auto &b) { a &= b; });
     return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-NdArrayBase<T, Dim, Derived> &operator&=(NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        lhs.item(i) &= rhs;
-    }
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+NdArrayBase<T, Dim, Derived> &operator&=(NdArrayBase<T, Dim, Derived> &lhs, const S &rhs) {
+    util::compound_op_scalar(lhs, rhs, [](auto &a, const auto &b) { a &= b; });
     return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-NdArrayBase<T, Dim, Derived1> &operator^=(NdArrayBase<T, Dim, Derived1> &lhs,
-                                          const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
-
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        lhs.item(i) ^= rhs.item(i);
-    }
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+NdArrayBase<T1, Dim, Derived1> &operator^=(NdArrayBase<T1, Dim, Derived1> &lhs,
+                                            const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    util::compound_op(lhs, rhs, [](auto &a, const auto &b) { a ^= b; });
     return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-NdArrayBase<T, Dim, Derived> &operator^=(NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        lhs.item(i) ^= rhs;
-    }
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+NdArrayBase<T, Dim, Derived> &operator^=(NdArrayBase<T, Dim, Derived> &lhs, const S &rhs) {
+    util::compound_op_scalar(lhs, rhs, [](auto &a, const auto &b) { a ^= b; });
     return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived1, typename Derived2>
-NdArrayBase<T, Dim, Derived1> &operator|=(NdArrayBase<T, Dim, Derived1> &lhs,
-                                          const NdArrayBase<T, Dim, Derived2> &rhs) {
-    util::validate_shape_binary_op(lhs.shape(), rhs.shape());
-
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        lhs.item(i) |= rhs.item(i);
-    }
+template <typename T1, typename T2, std::size_t Dim, typename Derived1, typename Derived2>
+NdArrayBase<T1, Dim, Derived1> &operator|=(NdArrayBase<T1, Dim, Derived1> &lhs,
+                                            const NdArrayBase<T2, Dim, Derived2> &rhs) {
+    util::compound_op(lhs, rhs, [](auto &a, const auto &b) { a |= b; });
     return lhs;
 }
 
-template <typename T, std::size_t Dim, typename Derived>
-NdArrayBase<T, Dim, Derived> &operator|=(NdArrayBase<T, Dim, Derived> &lhs, const T &rhs) {
-    std::size_t size = lhs.shape().size();
-    for (std::size_t i = 0; i < size; ++i) {
-        lhs.item(i) |= rhs;
-    }
+template <typename T, typename S, std::size_t Dim, typename Derived>
+    requires util::is_scalar_operand<S, T>
+NdArrayBase<T, Dim, Derived> &operator|=(NdArrayBase<T, Dim, Derived> &lhs, const S &rhs) {
+    util::compound_op_scalar(lhs, rhs, [](auto &a, const auto &b) { a |= b; });
     return lhs;
 }
 
@@ -0,0 +1,127 @@
+#ifndef NDARRAY_PARALLEL_HPP
+#define NDARRAY_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ndarray-definition.hpp"
+#include "ndarray-util.hpp"
+
+namespace ndarray {
+
+namespace util {
+
+/* Read by every parallel kernel, from any thread, so set_num_threads() may be called concurrently with them. */
+inline std::atomic<std::size_t> &num_threads_storage(void) {
+    static std::atomic<std::size_t> num_threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    return num_threads;
+}
+
+}  // namespace util
+
+/* Number of threads used by the parallel kernels. Defaults to the number of hardware threads. */
+inline std::size_t get_num_threads(void) {
+    return util::num_threads_storage().load(std::memory_order_relaxed);
+}
+
+inline void set_num_threads(std::size_t num_threads) {
+    util::num_threads_storage().store(std::max<std::size_t>(1, num_threads), std::memory_order_relaxed);
+}
+
+namespace util {
+
+/* Minimum number of elements handed to a thread; smaller ranges are processed serially. */
+constexpr index_t parallel_grain_size = 1 << 15;
+
+inline std::size_t num_blocks(index_t size, index_t grain_size) {
+    if (size <= 0) {
+        return 1;
+    }
+    const index_t max_blocks = std::max<index_t>(1, size / std::max<index_t>(1, grain_size));
+    return static_cast<std::size_t>(std::min<index_t>(static_cast<index_t>(get_num_threads()), max_blocks));
+}
+
+/* Bounds of the k-th of n contiguous blocks of [begin, end). The first (end - begin) % n blocks are one element
+ * longer. */
+inline std::pair<index_t, index_t> block_range(index_t begin, index_t end, std::size_t n, std::size_t k) {
+    const index_t size = end - begin;
+    const index_t base = size / static_cast<index_t>(n);
+    const index_t rem = size % static_cast<index_t>(n);
+    const index_t idx = static_cast<index_t>(k);
+    const index_t first = begin + idx * base + std::min(idx, rem);
+    return {first, first + base + (idx < rem ? 1 : 0)};
+}
+
+/* Runs f(block, block_begin, block_end) for each of num_blocks contiguous blocks of [begin, end), one block per
+ * thread. The partition only depends on the range and the block count, so results that are combined per block are
+ * deterministic for a fixed thread count. Exceptions thrown by f are rethrown in the calling thread. */
+template <typename F>
+void parallel_blocks(index_t begin, index_t end, std::size_t num_blocks, F f) {
+    if (num_blocks <= 1) {
+        f(std::size_t{0}, begin, end);
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(num_blocks);
+    const auto run_block = [&](std::size_t k) {
+        try {
+            auto [first, last] = block_range(begin, end, num_blocks, k);
+            f(k, first, last);
+        } catch (...) {
+            errors[k] = std::current_exception();
+        }
+    };
+
+    /* Blocks whose thread cannot be started run on the calling thread, so that the started threads are still joined
+     * and the partition, hence the result, stays the same. */
+    std::vector<std::thread> threads;
+    threads.reserve(num_blocks - 1);
+    std::size_t started = 1;
+    try {
+        for (; started < num_blocks; ++started) {
+            threads.emplace_back(run_block, started);
+        }
+    } catch (const std::system_error &) {
+    }
+
+    run_block(0);
+    for (std::size_t k = started; k < num_blocks; ++k) {
+        run_block(k);
+    }
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    for (const std::exception_ptr &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+/* Runs f(block_begin, block_end) over [begin, end) split across threads, keeping at least grain_size elements per
+ * thread. */
+template <typename F>
+void parallel_for(index_t begin, index_t end, index_t grain_size, F f) {
+    parallel_blocks(begin, end, num_blocks(end - begin, grain_size),
+                    [&f](std::size_t, index_t first, index_t last) { f(first, last); });
+}
+
+/* Runs f(block, first_line, last_line) over the lines of layout split across threads, giving each thread at least
+ * grain_size elements. */
+template <typename F>
+void parallel_lines(const AxisLayout &layout, F f) {
+    const index_t grain_lines = std::max<index_t>(1, parallel_grain_size / std::max<index_t>(1, layout.length));
+    parallel_blocks(0, layout.lines(), num_blocks(layout.lines(), grain_lines), f);
+}
+
+}  // namespace util
+
+}  // namespace ndarray
+
+#endif
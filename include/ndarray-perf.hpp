@@ -0,0 +1,214 @@
+#ifndef NDARRAY_PERF_HPP
+#define NDARRAY_PERF_HPP
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "ndarray-definition.hpp"
+#include "ndarray-parallel.hpp"
+
+namespace ndarray {
+
+/* Wall-clock time and hardware counters of one measured operation. Counters that the kernel or the hardware does not
+ * provide, as is common in virtual machines or with a restrictive perf_event_paranoid, are empty. */
+class PerfSample {
+public:
+    double seconds = 0;
+    /* Bytes the operation is expected to move to and from memory, as given to PerfCounters::measure(). */
+    std::size_t bytes = 0;
+
+    std::optional<std::uint64_t> cycles;
+    std::optional<std::uint64_t> instructions;
+    std::optional<std::uint64_t> llc_misses;
+    std::optional<std::uint64_t> dtlb_misses;
+    std::optional<std::uint64_t> branch_misses;
+
+    /* Instructions per cycle. */
+    std::optional<double> ipc(void) const {
+        if (!this->cycles || !this->instructions || *this->cycles == 0) {
+            return std::nullopt;
+        }
+        return static_cast<double>(*this->instructions) / static_cast<double>(*this->cycles);
+    }
+
+    /* Achieved bandwidth in bytes per second. */
+    double bandwidth(void) const {
+        return this->seconds > 0 ? static_cast<double>(this->bytes) / this->seconds : 0;
+    }
+
+    /* One-line summary. When a STREAM bandwidth is given, the achieved bandwidth is also shown as a fraction of it. */
+    std::string to_string(double stream_bandwidth = 0) const {
+        std::string str = std::format("time {:.3f} ms", this->seconds * 1e3);
+        if (this->bytes > 0) {
+            str += std::format(", {:.2f} GB/s", this->bandwidth() * 1e-9);
+            if (stream_bandwidth > 0) {
+                str += std::format(" ({:.0f}% of STREAM)", 100 * this->bandwidth() / stream_bandwidth);
+            }
+        }
+        if (std::optional<double> ipc = this->ipc()) {
+            str += std::format(", IPC {:.2f}", *ipc);
+        }
+        auto append = [&str](const char *name, const std::optional<std::uint64_t> &count) {
+            if (count) {
+                str += std::format(", {} {}", name, *count);
+            }
+        };
+        append("cycles", this->cycles);
+        append("instructions", this->instructions);
+        append("LLC misses", this->llc_misses);
+        append("dTLB misses", this->dtlb_misses);
+        append("branch misses", this->branch_misses);
+        return str;
+    }
+};
+
+inline std::ostream &operator<<(std::ostream &os, const PerfSample &sample) {
+    return os << sample.to_string();
+}
+
+/* Hardware counters around measured operations, read with perf_event_open on Linux. The counters follow the calling
+ * thread and the threads it creates while they are enabled, so the parallel kernels, whose worker threads are created
+ * and joined within each call, are counted in full. Only user-space events are counted. */
+class PerfCounters {
+public:
+    PerfCounters(void) {
+#ifdef __linux__
+        this->_fds = {open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES),
+                      open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS),
+                      open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES),
+                      open_event(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)),
+                      open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES)};
+#endif
+    }
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int fd : this->_fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    /* Whether at least one hardware counter could be opened. */
+    bool available(void) const {
+        return std::any_of(this->_fds.begin(), this->_fds.end(), [](int fd) { return fd >= 0; });
+    }
+
+    /* Runs f once and returns its time and counters. bytes is the memory traffic of f, used for its bandwidth. */
+    template <typename F>
+    PerfSample measure(F &&f, std::size_t bytes = 0) {
+        this->enable(true);
+        const auto begin = std::chrono::steady_clock::now();
+        f();
+        const auto end = std::chrono::steady_clock::now();
+        this->enable(false);
+
+        PerfSample sample;
+        sample.seconds = std::chrono::duration<double>(end - begin).count();
+        sample.bytes = bytes;
+        sample.cycles = this->read(0);
+        sample.instructions = this->read(1);
+        sample.llc_misses = this->read(2);
+        sample.dtlb_misses = this->read(3);
+        sample.branch_misses = this->read(4);
+        return sample;
+    }
+
+private:
+#ifdef __linux__
+    static int open_event(std::uint32_t type, std::uint64_t config) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+
+    /* Resets and starts the counters, or stops them. */
+    void enable([[maybe_unused]] bool on) {
+#ifdef __linux__
+        for (int fd : this->_fds) {
+            if (fd >= 0 && on) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            } else if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+#endif
+    }
+
+    /* Count of the i-th event, scaled up when the kernel had to multiplex the counters. */
+    std::optional<std::uint64_t> read([[maybe_unused]] std::size_t i) const {
+#ifdef __linux__
+        std::array<std::uint64_t, 3> values;
+        if (this->_fds[i] < 0 || ::read(this->_fds[i], values.data(), sizeof(values)) != sizeof(values)) {
+            return std::nullopt;
+        }
+        const auto [count, enabled, running] = values;
+        if (running == 0) {
+            return count == 0 && enabled == 0 ? std::optional<std::uint64_t>(0) : std::nullopt;
+        }
+        return running < enabled ? static_cast<std::uint64_t>(static_cast<double>(count) * enabled / running) : count;
+#else
+        return std::nullopt;
+#endif
+    }
+
+    std::array<int, 5> _fds = {-1, -1, -1, -1, -1};
+};
+
+/* Memory bandwidth in bytes per second of the STREAM triad a = b + s * c over arrays of the given number of doubles,
+ * run with the parallel kernels' threads; the best of repeats runs is kept. The arrays should be much larger than the
+ * last level cache for the result to be the sustainable memory bandwidth that bandwidth-bound kernels can reach. */
+inline double stream_bandwidth(index_t size = index_t(1) << 23, int repeats = 5) {
+    std::unique_ptr<double[]> a(new double[size]), b(new double[size]), c(new double[size]);
+    util::parallel_for(0, size, util::parallel_grain_size, [&](index_t first, index_t last) {
+        std::fill(a.get() + first, a.get() + last, 0.0);
+        std::fill(b.get() + first, b.get() + last, 1.0);
+        std::fill(c.get() + first, c.get() + last, 2.0);
+    });
+
+    double best = 0;
+    for (int r = 0; r < repeats; ++r) {
+        const auto begin = std::chrono::steady_clock::now();
+        util::parallel_for(0, size, util::parallel_grain_size, [&](index_t first, index_t last) {
+            for (index_t i = first; i < last; ++i) {
+                a[i] = b[i] + 3.0 * c[i];
+            }
+        });
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        best = std::max(best, static_cast<double>(3 * sizeof(double) * size) / seconds);
+    }
+    return best;
+}
+
+}  // namespace ndarray
+
+#endif
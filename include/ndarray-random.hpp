@@ -0,0 +1,223 @@
+#ifndef NDARRAY_RANDOM_HPP
+#define NDARRAY_RANDOM_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <format>
+#include <numbers>
+#include <stdexcept>
+
+#include "ndarray-core.hpp"
+#include "ndarray-definition.hpp"
+#include "ndarray-parallel.hpp"
+
+namespace ndarray {
+
+namespace util {
+
+using philox_counter_t = std::array<std::uint32_t, 4>;
+using philox_key_t = std::array<std::uint32_t, 2>;
+
+/* Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3"): a bijection of the counter, keyed by
+ * key, whose outputs for successive counters pass BigCrush. */
+constexpr philox_counter_t philox(philox_counter_t counter, philox_key_t key) {
+    constexpr std::uint64_t multiplier0 = 0xD2511F53;
+    constexpr std::uint64_t multiplier1 = 0xCD9E8D57;
+    constexpr std::uint32_t weyl0 = 0x9E3779B9;
+    constexpr std::uint32_t weyl1 = 0xBB67AE85;
+
+    for (int round = 0; round < 10; ++round) {
+        if (round > 0) {
+            key[0] += weyl0;
+            key[1] += weyl1;
+        }
+        const std::uint64_t product0 = multiplier0 * counter[0];
+        const std::uint64_t product1 = multiplier1 * counter[2];
+        counter = {static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+                   static_cast<std::uint32_t>(product1),
+                   static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+                   static_cast<std::uint32_t>(product0)};
+    }
+    return counter;
+}
+
+/* High 64 bits of the 128-bit product of a and b. */
+constexpr std::uint64_t mul_high(std::uint64_t a, std::uint64_t b) {
+    const std::uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+    const std::uint64_t b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+    const std::uint64_t lo_lo = a_lo * b_lo;
+    const std::uint64_t hi_lo = a_hi * b_lo;
+    const std::uint64_t lo_hi = a_lo * b_hi;
+    const std::uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+    return a_hi * b_hi + (hi_lo >> 32) + (cross >> 32);
+}
+
+/* Uniform double in [0, 1) with 53 random bits. */
+constexpr double to_unit(std::uint32_t hi, std::uint32_t lo) {
+    return static_cast<double>(((static_cast<std::uint64_t>(hi) << 32) | lo) >> 11) * 0x1p-53;
+}
+
+/* Uniform double in (0, 1] with 32 random bits. */
+constexpr double to_unit_open(std::uint32_t bits) {
+    return (static_cast<double>(bits) + 1.0) * 0x1p-32;
+}
+
+}  // namespace util
+
+namespace random {
+
+/* Counter-based random number generator. The i-th element of an array drawn from a generator only depends on the seed,
+ * on i and on how many values have been drawn before, so the results are the same for any number of threads. Each draw
+ * advances the counter past the values it used, so consecutive draws are independent. A Generator must not be used by
+ * several threads at once; give each thread its own seed instead. */
+class Generator {
+public:
+    explicit Generator(std::uint64_t seed = 0) : _key(make_key(seed)), _counter(0) {}
+
+    /* Restarts the generator from the given seed. */
+    void seed(std::uint64_t seed) {
+        this->_key = make_key(seed);
+        this->_counter = 0;
+    }
+
+    /* Number of Philox blocks of four 32-bit values consumed so far. */
+    std::uint64_t counter(void) const {
+        return this->_counter;
+    }
+
+    /* Values drawn uniformly from [low, high). */
+    template <std::floating_point T = double, std::size_t Dim>
+    NdArray<T, Dim> uniform(const Shape<Dim> &shape, T low = 0, T high = 1) {
+        if (!(low <= high)) {
+            throw std::invalid_argument(std::format("uniform() low {} is greater than high {}", low, high));
+        }
+        const T scale = high - low;
+        if constexpr (sizeof(T) <= sizeof(std::uint32_t)) {
+            return this->generate<4, T>(shape, [low, scale](const util::philox_counter_t &bits, T *out) {
+                for (std::size_t i = 0; i < 4; ++i) {
+                    out[i] = low + scale * static_cast<T>(static_cast<float>(bits[i] >> 8) * 0x1p-24f);
+                }
+            });
+        } else {
+            return this->generate<2, T>(shape, [low, scale](const util::philox_counter_t &bits, T *out) {
+                out[0] = low + scale * static_cast<T>(util::to_unit(bits[0], bits[1]));
+                out[1] = low + scale * static_cast<T>(util::to_unit(bits[2], bits[3]));
+            });
+        }
+    }
+
+    /* Values drawn from the normal distribution with the given mean and standard deviation, by the Box-Muller
+     * transform. */
+    template <std::floating_point T = double, std::size_t Dim>
+    NdArray<T, Dim> normal(const Shape<Dim> &shape, T mean = 0, T stddev = 1) {
+        if (!(stddev >= 0)) {
+            throw std::invalid_argument(std::format("normal() stddev {} is negative", stddev));
+        }
+        if constexpr (sizeof(T) <= sizeof(std::uint32_t)) {
+            /* Single precision outputs use 32-bit uniforms, transformed in double precision to keep the tails. */
+            return this->generate<4, T>(shape, [mean, stddev](const util::philox_counter_t &bits, T *out) {
+                for (std::size_t i = 0; i < 4; i += 2) {
+                    const double radius = std::sqrt(-2.0 * std::log(util::to_unit_open(bits[i])));
+                    const double angle = 2.0 * std::numbers::pi * util::to_unit_open(bits[i + 1]);
+                    out[i] = mean + stddev * static_cast<T>(radius * std::cos(angle));
+                    out[i + 1] = mean + stddev * static_cast<T>(radius * std::sin(angle));
+                }
+            });
+        } else {
+            return this->generate<2, T>(shape, [mean, stddev](const util::philox_counter_t &bits, T *out) {
+                const T radius = std::sqrt(T(-2) * std::log(T(1) - static_cast<T>(util::to_unit(bits[0], bits[1]))));
+                const T angle = T(2) * std::numbers::pi_v<T> * static_cast<T>(util::to_unit(bits[2], bits[3]));
+                out[0] = mean + stddev * radius * std::cos(angle);
+                out[1] = mean + stddev * radius * std::sin(angle);
+            });
+        }
+    }
+
+    /* Integers drawn uniformly from [low, high). Each value is the high part of a 64-bit random number multiplied by
+     * the range, so the bias is below range / 2^64. */
+    template <std::integral T, std::size_t Dim>
+        requires(!std::same_as<T, bool>)
+    NdArray<T, Dim> integers(const Shape<Dim> &shape, T low, T high) {
+        if (!(low < high)) {
+            throw std::invalid_argument(std::format("integers() low {} is not less than high {}", low, high));
+        }
+        const std::uint64_t range = static_cast<std::uint64_t>(high) - static_cast<std::uint64_t>(low);
+        return this->generate<2, T>(shape, [low, range](const util::philox_counter_t &bits, T *out) {
+            for (std::size_t i = 0; i < 2; ++i) {
+                const std::uint64_t value = (static_cast<std::uint64_t>(bits[2 * i]) << 32) | bits[2 * i + 1];
+                out[i] = static_cast<T>(static_cast<std::uint64_t>(low) + util::mul_high(value, range));
+            }
+        });
+    }
+
+private:
+    static util::philox_key_t make_key(std::uint64_t seed) {
+        return {static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)};
+    }
+
+    /* Fills a new array in parallel, each Philox block giving PerBlock consecutive elements through transform. */
+    template <std::size_t PerBlock, typename T, std::size_t Dim, typename Transform>
+    NdArray<T, Dim> generate(const Shape<Dim> &shape, Transform transform) {
+        NdArray<T, Dim> result(shape);
+        const index_t size = result.size();
+        const index_t num_blocks = (size + static_cast<index_t>(PerBlock) - 1) / static_cast<index_t>(PerBlock);
+        const std::uint64_t base = this->_counter;
+        const util::philox_key_t key = this->_key;
+        T *data = result.data();
+
+        util::parallel_for(0, num_blocks, util::parallel_grain_size / PerBlock, [&](index_t first, index_t last) {
+            std::array<T, PerBlock> values;
+            for (index_t block = first; block < last; ++block) {
+                const std::uint64_t counter = base + static_cast<std::uint64_t>(block);
+                transform(util::philox({static_cast<std::uint32_t>(counter), static_cast<std::uint32_t>(counter >> 32),
+                                        0, 0},
+                                       key),
+                          values.data());
+                const index_t offset = block * static_cast<index_t>(PerBlock);
+                std::copy_n(values.data(), std::min<index_t>(PerBlock, size - offset), data + offset);
+            }
+        });
+
+        this->_counter += static_cast<std::uint64_t>(num_blocks);
+        return result;
+    }
+
+    util::philox_key_t _key;
+    std::uint64_t _counter;
+};
+
+/* Generator used by the free functions. */
+inline Generator &default_generator(void) {
+    static Generator generator;
+    return generator;
+}
+
+/* Restarts the default generator from the given seed. */
+inline void seed(std::uint64_t seed) {
+    default_generator().seed(seed);
+}
+
+template <std::floating_point T = double, std::size_t Dim>
+NdArray<T, Dim> uniform(const Shape<Dim> &shape, T low = 0, T high = 1) {
+    return default_generator().uniform<T>(shape, low, high);
+}
+
+template <std::floating_point T = double, std::size_t Dim>
+NdArray<T, Dim> normal(const Shape<Dim> &shape, T mean = 0, T stddev = 1) {
+    return default_generator().normal<T>(shape, mean, stddev);
+}
+
+template <std::integral T, std::size_t Dim>
+    requires(!std::same_as<T, bool>)
+NdArray<T, Dim> integers(const Shape<Dim> &shape, T low, T high) {
+    return default_generator().integers<T>(shape, low, high);
+}
+
+}  // namespace random
+
+}  // namespace ndarray
+
+#endif
@@ -0,0 +1,322 @@
+#ifndef NDARRAY_SCAN_HPP
+#define NDARRAY_SCAN_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <format>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "ndarray-base.hpp"
+#include "ndarray-core.hpp"
+#include "ndarray-op.hpp"
+#include "ndarray-parallel.hpp"
+
+namespace ndarray {
+
+namespace util {
+
+template <typename T>
+class scan_min {
+public:
+    T operator()(const T &a, const T &b) const {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (std::isnan(a) || std::isnan(b)) {
+                return std::isnan(a) ? a : b;
+            }
+        }
+        return b < a ? b : a;
+    }
+};
+
+template <typename T>
+class scan_max {
+public:
+    T operator()(const T &a, const T &b) const {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (std::isnan(a) || std::isnan(b)) {
+                return std::isnan(a) ? a : b;
+            }
+        }
+        return a < b ? b : a;
+    }
+};
+
+/* Scans rows [row_begin, row_end) of the outer-th slab in place, for positions [col_begin, col_end) of each row. A row
+ * is the run of inner contiguous elements at one position along the axis, so the innermost loop is a contiguous
+ * element-wise operation between two rows that the compiler can vectorize. Row row_begin is left as is. */
+template <typename T, typename Op>
+void scan_rows(T *data, const AxisLayout &layout, index_t outer, index_t row_begin, index_t row_end, index_t col_begin,
+               index_t col_end, Op op) {
+    T *slab = data + outer * layout.length * layout.inner;
+    for (index_t j = row_begin + 1; j < row_end; ++j) {
+        T *row = slab + j * layout.inner;
+        const T *prev = row - layout.inner;
+        for (index_t i = col_begin; i < col_end; ++i) {
+            row[i] = op(prev[i], row[i]);
+        }
+    }
+}
+
+/* Inclusive scan of data in place along the axis of layout.
+ *
+ * When there are enough independent lines, the lines are split across threads and each is scanned serially. Otherwise
+ * the axis itself is split into one block per thread and scanned in two passes: each block is scanned locally, the
+ * block totals are combined serially, and each block but the first is offset by the combined total of the blocks
+ * before it. The block boundaries only depend on the array shape and the thread count, so floating point results are
+ * reproducible for a fixed thread count. */
+template <typename T, typename Op>
+void inclusive_scan(T *data, const AxisLayout &layout, Op op) {
+    const index_t lines = layout.lines();
+    const std::size_t axis_blocks = num_blocks(layout.length * lines, parallel_grain_size);
+    if (lines == 0 || layout.length == 0) {
+        return;
+    }
+
+    if (axis_blocks <= 1 || lines >= static_cast<index_t>(get_num_threads()) ||
+        layout.length < 2 * static_cast<index_t>(axis_blocks)) {
+        parallel_lines(layout, [&](std::size_t, index_t first, index_t last) {
+            for (index_t outer = first / layout.inner; outer * layout.inner < last; ++outer) {
+                const index_t col_begin = std::max(first - outer * layout.inner, index_t{0});
+                const index_t col_end = std::min(last - outer * layout.inner, layout.inner);
+                scan_rows(data, layout, outer, 0, layout.length, col_begin, col_end, op);
+            }
+        });
+        return;
+    }
+
+    parallel_blocks(0, layout.length, axis_blocks, [&](std::size_t, index_t first, index_t last) {
+        for (index_t outer = 0; outer < layout.outer; ++outer) {
+            scan_rows(data, layout, outer, first, last, 0, layout.inner, op);
+        }
+    });
+
+    /* carries[k] holds, for every line, the combined total of blocks 0, ..., k - 1. */
+    std::vector<std::vector<T>> carries(axis_blocks);
+    for (std::size_t k = 1; k < axis_blocks; ++k) {
+        const index_t last_row = block_range(0, layout.length, axis_blocks, k - 1).second - 1;
+        carries[k].resize(lines);
+        for (index_t line = 0; line < lines; ++line) {
+            const T &total = data[layout.offset(line) + last_row * layout.inner];
+            carries[k][line] = k == 1 ? total : op(carries[k - 1][line], total);
+        }
+    }
+
+    parallel_blocks(0, layout.length, axis_blocks, [&](std::size_t k, index_t first, index_t last) {
+        if (k == 0) {
+            return;
+        }
+        const T *carry = carries[k].data();
+        for (index_t outer = 0; outer < layout.outer; ++outer) {
+            T *slab = data + outer * layout.length * layout.inner;
+            const T *slab_carry = carry + outer * layout.inner;
+            for (index_t j = first; j < last; ++j) {
+                T *row = slab + j * layout.inner;
+                for (index_t i = 0; i < layout.inner; ++i) {
+                    row[i] = op(slab_carry[i], row[i]);
+                }
+            }
+        }
+    });
+}
+
+template <typename T, std::size_t Dim, typename Derived, typename Op>
+NdArray<T, Dim> scan(const NdArrayBase<T, Dim, Derived> &arr, index_t axis, Op op) {
+    NdArray<T, Dim> result = materialize(arr);
+    inclusive_scan(result.data(), AxisLayout(result.shape(), normalize_axis(axis, Dim)), op);
+    return result;
+}
+
+/* Reduces rows [row_begin, row_end) of the outer-th slab into out, for positions [col_begin, col_end) of each row, in
+ * row order. As in scan_rows(), the innermost loop is a contiguous element-wise operation between two rows. */
+template <typename T, typename Op>
+void reduce_rows(const T *data, const AxisLayout &layout, index_t outer, index_t row_begin, index_t row_end,
+                 index_t col_begin, index_t col_end, T *out, Op op) {
+    const T *slab = data + outer * layout.length * layout.inner;
+    const T *first = slab + row_begin * layout.inner;
+    std::copy(first + col_begin, first + col_end, out + col_begin);
+    for (index_t j = row_begin + 1; j < row_end; ++j) {
+        const T *row = slab + j * layout.inner;
+        for (index_t i = col_begin; i < col_end; ++i) {
+            out[i] = op(out[i], row[i]);
+        }
+    }
+}
+
+/* Reduces data along the axis of layout into out, which holds one element per line.
+ *
+ * As in inclusive_scan(), many lines are split across threads and each is reduced serially, while a few long lines are
+ * split into one block of the axis per thread. Each block then reduces into its own partial results, which are combined
+ * pairwise in block order, as a tree. Elements are always combined in their order along the axis, so op only needs to
+ * be associative, and the results are reproducible for a fixed thread count. */
+template <typename T, typename Op>
+void reduce_axis(const T *data, const AxisLayout &layout, T *out, Op op) {
+    const index_t lines = layout.lines();
+    if (lines == 0) {
+        return;
+    }
+    if (layout.length == 0) {
+        throw std::invalid_argument("Cannot reduce over an axis of length 0");
+    }
+
+    const std::size_t axis_blocks = num_blocks(layout.length * lines, parallel_grain_size);
+    if (axis_blocks <= 1 || lines >= static_cast<index_t>(get_num_threads()) ||
+        layout.length < 2 * static_cast<index_t>(axis_blocks)) {
+        parallel_lines(layout, [&](std::size_t, index_t first, index_t last) {
+            for (index_t outer = first / layout.inner; outer * layout.inner < last; ++outer) {
+                const index_t col_begin = std::max(first - outer * layout.inner, index_t{0});
+                const index_t col_end = std::min(last - outer * layout.inner, layout.inner);
+                reduce_rows(data, layout, outer, 0, layout.length, col_begin, col_end, out + outer * layout.inner, op);
+            }
+        });
+        return;
+    }
+
+    std::vector<std::vector<T>> partials(axis_blocks, std::vector<T>(lines));
+    parallel_blocks(0, layout.length, axis_blocks, [&](std::size_t k, index_t first, index_t last) {
+        for (index_t outer = 0; outer < layout.outer; ++outer) {
+            reduce_rows(data, layout, outer, first, last, 0, layout.inner, partials[k].data() + outer * layout.inner,
+                        op);
+        }
+    });
+    for (std::size_t width = 1; width < axis_blocks; width *= 2) {
+        for (std::size_t k = 0; k + width < axis_blocks; k += 2 * width) {
+            T *lhs = partials[k].data();
+            const T *rhs = partials[k + width].data();
+            for (index_t line = 0; line < lines; ++line) {
+                lhs[line] = op(lhs[line], rhs[line]);
+            }
+        }
+    }
+    std::copy(partials[0].begin(), partials[0].end(), out);
+}
+
+/* Elements of arr in C order: its own buffer when it is stored so, and otherwise a copy made in buffer. */
+template <typename T, std::size_t Dim, typename Derived>
+const T *c_order_data(const NdArrayBase<T, Dim, Derived> &arr, std::optional<NdArray<T, Dim>> &buffer) {
+    if constexpr (is_contiguous<Derived>) {
+        if (layout_order(arr) == Order::C) {
+            return static_cast<const Derived &>(arr).data();
+        }
+    }
+    return buffer.emplace(materialize(arr)).data();
+}
+
+template <std::size_t Dim>
+Shape<Dim - 1> remove_axis(const Shape<Dim> &shape, std::size_t axis) {
+    std::array<index_t, Dim - 1> extents;
+    for (std::size_t i = 0, j = 0; i < Dim; ++i) {
+        if (i != axis) {
+            extents[j++] = shape[i];
+        }
+    }
+    return Shape<Dim - 1>(extents);
+}
+
+}  // namespace util
+
+/* Cumulative operations **********************************************************************************************/
+
+template <typename T, std::size_t Dim, typename Derived>
+NdArray<T, Dim> cumsum(const NdArrayBase<T, Dim, Derived> &arr, index_t axis = -1) {
+    return util::scan(arr, axis, std::plus<T>());
+}
+
+template <typename T, std::size_t Dim, typename Derived>
+NdArray<T, Dim> cumprod(const NdArrayBase<T, Dim, Derived> &arr, index_t axis = -1) {
+    return util::scan(arr, axis, std::multiplies<T>());
+}
+
+/* cummin() and cummax() propagate NaNs, as in NumPy. */
+
+template <typename T, std::size_t Dim, typename Derived>
+NdArray<T, Dim> cummin(const NdArrayBase<T, Dim, Derived> &arr, index_t axis = -1) {
+    return util::scan(arr, axis, util::scan_min<T>());
+}
+
+template <typename T, std::size_t Dim, typename Derived>
+NdArray<T, Dim> cummax(const NdArrayBase<T, Dim, Derived> &arr, index_t axis = -1) {
+    return util::scan(arr, axis, util::scan_max<T>());
+}
+
+/* Running results of op along axis, for any associative binary operator such as std::plus<T>(). */
+template <typename Op, typename T, std::size_t Dim, typename Derived>
+NdArray<T, Dim> accumulate(Op op, const NdArrayBase<T, Dim, Derived> &arr, index_t axis = -1) {
+    return util::scan(arr, axis, [&op](const T &a, const T &b) { return static_cast<T>(op(a, b)); });
+}
+
+/* Reductions *********************************************************************************************************/
+
+/* Combines the elements along axis with op, which only needs to be associative: elements are combined in their order
+ * along the axis, in parallel blocks whose results are then combined pairwise. Results are the same for a given
+ * number of threads. Reducing over an axis of length 0 throws, as op has no identity. */
+template <typename Op, typename T, std::size_t Dim, typename Derived>
+    requires(Dim > 1)
+NdArray<T, Dim - 1> reduce(Op op, const NdArrayBase<T, Dim, Derived> &arr, index_t axis) {
+    const std::size_t ax = util::normalize_axis(axis, Dim);
+    NdArray<T, Dim - 1> result(util::remove_axis(arr.shape(), ax));
+    std::optional<NdArray<T, Dim>> buffer;
+    util::reduce_axis(util::c_order_data(arr, buffer), util::AxisLayout(arr.shape(), ax), result.data(),
+                      [&op](const T &a, const T &b) { return static_cast<T>(op(a, b)); });
+    return result;
+}
+
+/* Combines all the elements in C order with op. */
+template <typename Op, typename T, std::size_t Dim, typename Derived>
+T reduce(Op op, const NdArrayBase<T, Dim, Derived> &arr) {
+    T result;
+    std::optional<NdArray<T, Dim>> buffer;
+    util::reduce_axis(util::c_order_data(arr, buffer), util::AxisLayout(Shape<1>({arr.size()}), 0), &result,
+                      [&op](const T &a, const T &b) { return static_cast<T>(op(a, b)); });
+    return result;
+}
+
+/* Reductions over segments of axis, as in NumPy: the i-th element along axis of the result reduces the elements from
+ * indices[i] up to indices[i + 1], or to the end for the last index, and is the element at indices[i] when
+ * indices[i + 1] is not greater. Segments are reduced independently across threads, each one serially, so the results
+ * do not depend on the number of threads. */
+template <typename Op, typename T, std::size_t Dim, typename Derived, std::integral I, typename IndexDerived>
+NdArray<T, Dim> reduceat(Op op, const NdArrayBase<T, Dim, Derived> &arr, const NdArrayBase<I, 1, IndexDerived> &indices,
+                         index_t axis = -1) {
+    const std::size_t ax = util::normalize_axis(axis, Dim);
+    const util::AxisLayout layout(arr.shape(), ax);
+    const NdArray<I, 1> starts = util::materialize(indices);
+    const index_t segments = starts.size();
+    for (index_t k = 0; k < segments; ++k) {
+        if (starts[k] < 0 || starts[k] >= layout.length) {
+            throw std::out_of_range(std::format("reduceat() index {} is out of bounds for axis {} with size {}",
+                                                starts[k], ax, layout.length));
+        }
+    }
+
+    std::array<index_t, Dim> extents;
+    for (std::size_t i = 0; i < Dim; ++i) {
+        extents[i] = i == ax ? segments : arr.shape()[i];
+    }
+    const Shape<Dim> shape(extents);
+    NdArray<T, Dim> result(shape);
+    std::optional<NdArray<T, Dim>> buffer;
+    const T *data = util::c_order_data(arr, buffer);
+    T *out = result.data();
+    const auto combine = [&op](const T &a, const T &b) { return static_cast<T>(op(a, b)); };
+
+    const index_t grain = std::max<index_t>(1, util::parallel_grain_size * segments / std::max<index_t>(1, arr.size()));
+    util::parallel_for(0, segments, grain, [&](index_t first, index_t last) {
+        for (index_t outer = 0; outer < layout.outer; ++outer) {
+            for (index_t k = first; k < last; ++k) {
+                const index_t begin = static_cast<index_t>(starts[k]);
+                const index_t end = k + 1 < segments ? std::max<index_t>(starts[k + 1], begin + 1) : layout.length;
+                T *segment_out = out + (outer * segments + k) * layout.inner;
+                util::reduce_rows(data, layout, outer, begin, end, 0, layout.inner, segment_out, combine);
+            }
+        }
+    });
+    return result;
+}
+
+}  // namespace ndarray
+
+#endif
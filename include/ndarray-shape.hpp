@@ -29,35 +29,35 @@ public:
     Shape &operator=(Shape &&) = default;
     ~Shape() = default;
 
-    Shape(void) {
+    constexpr Shape(void) {
         std::fill(this->_shape.begin(), this->_shape.end(), 1);
         this->init_partial();
     }
 
-    Shape(const index_t *shape) {
+    constexpr Shape(const index_t *shape) {
         std::copy(shape, shape + Dim, this->_shape.begin());
         this->init_partial();
     }
 
-    Shape(const std::array<index_t, Dim> &shape) {
+    constexpr Shape(const std::array<index_t, Dim> &shape) {
         std::copy(shape.begin(), shape.end(), this->_shape.begin());
         this->init_partial();
     }
 
-    Shape(const std::initializer_list<index_t> &shape) {
+    constexpr Shape(const std::initializer_list<index_t> &shape) {
         if (shape.size() != Dim)
             throw std::invalid_argument("Invalid length of initializer list");
         std::copy(shape.begin(), shape.end(), this->_shape.begin());
         this->init_partial();
     }
 
-    Shape(index_t shape_first, const Shape<Dim - 1> &shape_rest) {
+    constexpr Shape(index_t shape_first, const Shape<Dim - 1> &shape_rest) {
         this->_shape[0] = shape_first;
         std::copy(shape_rest._shape.begin(), shape_rest._shape.end(), this->_shape.begin() + 1);
         this->init_partial();
     }
 
-    index_t operator[](index_t i) const {
+    constexpr index_t operator[](index_t i) const {
         if (i < -static_cast<index_t>(Dim) || i >= static_cast<index_t>(Dim))
             throw std::out_of_range("Shape index out of range");
         if (i < 0)
@@ -65,11 +65,11 @@ public:
         return this->_shape[i];
     }
 
-    bool operator==(const Shape<Dim> &other) const {
+    constexpr bool operator==(const Shape<Dim> &other) const {
         return std::equal(this->_shape.begin(), this->_shape.end(), other._shape.begin());
     }
 
-    bool operator!=(const Shape<Dim> &other) const {
+    constexpr bool operator!=(const Shape<Dim> &other) const {
         return !(*this == other);
     }
 
@@ -88,8 +88,8 @@ public:
         return this->to_string();
     }
 
-    index_t size(void) const {
-        return std::accumulate(this->_shape.begin(), this->_shape.end(), 1, std::multiplies<index_t>());
+    constexpr index_t size(void) const {
+        return std::accumulate(this->_shape.begin(), this->_shape.end(), index_t{1}, std::multiplies<index_t>());
     }
 
 private:
@@ -99,7 +99,10 @@ private:
     template <std::size_t>
     friend class Shape;
 
-    void init_partial(void) {
+    template <std::size_t>
+    friend class NdArrayMask;
+
+    constexpr void init_partial(void) {
         this->partial[Dim - 1] = 1;
         for (std::size_t i = Dim - 1; i > 0; --i) {
             this->partial[i - 1] = this->partial[i] * this->_shape[i];
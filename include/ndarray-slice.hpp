@@ -5,8 +5,10 @@
 #include <array>
 #include <iostream>
 #include <limits>
+#include <memory>
 
 #include "ndarray-definition.hpp"
+#include "ndarray-iter.hpp"
 #include "ndarray-shape.hpp"
 
 namespace ndarray {
@@ -14,6 +16,9 @@ namespace ndarray {
 template <typename T, std::size_t Dim, typename Operand>
 class NdArraySlice;
 
+template <std::size_t Dim>
+class NdArrayMask;
+
 class Slice {
 public:
     static constexpr index_t none = std::numeric_limits<index_t>::max();
@@ -140,22 +145,45 @@ public:
     index_t step;
 };
 
+/* View of a strided subset of the elements of an array, stored as a pointer to its first element, a shape and the
+ * element strides along each axis. Views are cheap to copy and can be stored, returned and passed to other threads;
+ * they do not keep the viewed array alive unless they are created from a std::shared_ptr with view(). Operand is the
+ * type of the viewed array and only determines whether the elements are const.
+ *
+ * Assigning to a view always assigns the elements of the right-hand side, whatever its type. Copying a view makes
+ * another view of the same elements, and rebind() makes a view refer to the elements of another one; SliceHandle
+ * wraps a view so that assigning it rebinds it, for containers and standard algorithms. */
 template <typename T, std::size_t Dim, typename Operand>
 class NdArraySlice : public NdArrayBase<T, Dim, NdArraySlice<T, Dim, Operand>> {
 public:
+    using pointer = std::conditional_t<std::is_const_v<Operand>, const T, T> *;
+
     NdArraySlice(Operand &operand, const std::array<bool, Operand::dim> &is_slice_axis,
                  const std::array<index_t, Operand::dim - Dim> &indices, const std::array<Slice, Dim> &slices)
-        : NdArrayBase<T, Dim, NdArraySlice<T, Dim, Operand>>(util::slices_to_shape(slices)),
-          _operand(operand),
-          _is_slice_axis(is_slice_axis),
-          _indices(indices),
-          _slices(slices),
-          _slice_axes(util::pick_slice_axes<Operand::dim, Dim>(is_slice_axis)) {}
-
-    NdArraySlice(const NdArraySlice &other) = delete;
-    NdArraySlice(NdArraySlice &&other) = delete;
-    NdArraySlice &operator=(const NdArraySlice &other) = delete;
-    NdArraySlice &operator=(NdArraySlice &&other) = delete;
+        : NdArrayBase<T, Dim, NdArraySlice<T, Dim, Operand>>(util::slices_to_shape(slices)), _data(operand.data()) {
+        const std::array<index_t, Operand::dim> operand_strides = util::strides_of(operand);
+
+        for (std::size_t i = 0, j = 0, k = 0; i < Operand::dim; ++i) {
+            if (is_slice_axis[i]) {
+                this->_data += slices[j].start * operand_strides[i];
+                this->_strides[j] = slices[j].step * operand_strides[i];
+                ++j;
+            } else {
+                this->_data += indices[k] * operand_strides[i];
+                ++k;
+            }
+        }
+    }
+
+    NdArraySlice(pointer data, const Shape<Dim> &shape, const std::array<index_t, Dim> &strides,
+                 std::shared_ptr<const void> owner = nullptr)
+        : NdArrayBase<T, Dim, NdArraySlice<T, Dim, Operand>>(shape),
+          _data(data),
+          _strides(strides),
+          _owner(std::move(owner)) {}
+
+    NdArraySlice(const NdArraySlice &other) = default;
+    NdArraySlice(NdArraySlice &&other) = default;
 
     /* Indexing *******************************************************************************************************/
 
@@ -174,37 +202,15 @@ public:
     }
 
     T &operator[](const std::array<index_t, Dim> &indices) {
-        std::array<index_t, Dim> normalized_indices = util::normalize_indices(this->_shape, indices);
-
-        std::array<index_t, Operand::dim> operand_indices;
-        for (std::size_t i = 0, j = 0, k = 0; i < Operand::dim; ++i) {
-            if (this->_is_slice_axis[i]) {
-                operand_indices[i] = this->_slices[j] * normalized_indices[j];
-                ++j;
-            } else {
-                operand_indices[i] = this->_indices[k];
-                ++k;
-            }
-        }
-
-        return this->_operand.operator[](operand_indices);
+        return this->_data[this->offset(util::normalize_indices(this->_shape, indices))];
     }
 
     const T &operator[](const std::array<index_t, Dim> &indices) const {
-        std::array<index_t, Dim> normalized_indices = util::normalize_indices(this->_shape, indices);
-
-        std::array<index_t, Operand::dim> operand_indices;
-        for (std::size_t i = 0, j = 0, k = 0; i < Operand::dim; ++i) {
-            if (this->_is_slice_axis[i]) {
-                operand_indices[i] = this->_slices[j] * normalized_indices[j];
-                ++j;
-            } else {
-                operand_indices[i] = this->_indices[k];
-                ++k;
-            }
-        }
+        return this->_data[this->offset(util::normalize_indices(this->_shape, indices))];
+    }
 
-        return this->_operand.operator[](operand_indices);
+    NdArray<T, 1> operator[](const NdArrayMask<Dim> &mask) const {
+        return masked_select(*this, mask);
     }
 
     /* Slicing ********************************************************************************************************/
@@ -230,34 +236,7 @@ public:
 
         util::normalize_indices_slices<NIndices, NSlices>(this->_shape, is_slice_axis, indices, slices);
 
-        /* Merge with the current indices and slices. */
-        std::array<bool, Operand::dim> is_slice_axis_new;
-        std::array<index_t, Operand::dim - NSlices> indices_new;
-        std::array<Slice, NSlices> slices_new;
-
-        for (std::size_t i = 0, j = 0, k = 0, l = 0, m = 0, n = 0; i < Operand::dim; ++i) {
-            if (this->_is_slice_axis[i]) {
-                if (is_slice_axis[j]) {
-                    is_slice_axis_new[i] = true;
-                    slices_new[l] = this->_slices[j] * slices[l];
-                    ++j;
-                    ++l;
-                } else {
-                    is_slice_axis_new[i] = false;
-                    indices_new[n] = this->_slices[j] * indices[m];
-                    ++j;
-                    ++m;
-                    ++n;
-                }
-            } else {
-                is_slice_axis_new[i] = false;
-                indices_new[n] = this->_indices[k];
-                ++k;
-                ++n;
-            }
-        }
-
-        return {this->_operand, is_slice_axis_new, indices_new, slices_new};
+        return this->subview<NSlices>(is_slice_axis, indices, slices);
     }
 
     template <typename... Args>
@@ -282,60 +261,53 @@ public:
 
         util::normalize_indices_slices<NIndices, NSlices>(this->_shape, is_slice_axis, indices, slices);
 
-        /* Merge with the current indices and slices. */
-        std::array<bool, Operand::dim> is_slice_axis_new;
-        std::array<index_t, Operand::dim - NSlices> indices_new;
-        std::array<Slice, NSlices> slices_new;
-
-        for (std::size_t i = 0, j = 0, k = 0, l = 0, m = 0, n = 0; i < Operand::dim; ++i) {
-            if (this->_is_slice_axis[i]) {
-                if (is_slice_axis[j]) {
-                    is_slice_axis_new[i] = true;
-                    slices_new[l] = this->_slices[j] * slices[l];
-                    ++j;
-                    ++l;
-                } else {
-                    is_slice_axis_new[i] = false;
-                    indices_new[n] = this->_slices[j] * indices[m];
-                    ++j;
-                    ++m;
-                    ++n;
-                }
-            } else {
-                is_slice_axis_new[i] = false;
-                indices_new[n] = this->_indices[k];
-                ++k;
-                ++n;
-            }
-        }
-
-        return {static_cast<const Operand &>(this->_operand), is_slice_axis_new, indices_new, slices_new};
+        const NdArraySlice<T, Dim, const Operand> as_const(this->_data, this->_shape, this->_strides, this->_owner);
+        return as_const.template subview<NSlices>(is_slice_axis, indices, slices);
     }
 
     /* Assignment *****************************************************************************************************/
 
-    NdArraySlice<T, Dim, Operand> &operator=(const NdArray<T, Dim> &other) {
-        if (this->_shape != other._shape) {
-            throw std::invalid_argument(std::format("Cannot assign an array of _shape {} to {}", this->_shape.to_string(),
-                                                    other._shape.to_string()));
-        }
+    template <typename U, typename OtherDerived>
+    NdArraySlice<T, Dim, Operand> &operator=(const NdArrayBase<U, Dim, OtherDerived> &other) {
+        return this->assign(other);
+    }
 
-        std::array<index_t, Operand::dim> operand_indices;
-        for (std::size_t i = 0, j = 0; i < Operand::dim; ++i) {
-            if (!this->_is_slice_axis[i]) {
-                operand_indices[i] = this->_indices[j];
-                ++j;
-            }
-        }
+    NdArraySlice<T, Dim, Operand> &operator=(const NdArraySlice &other) {
+        return this->assign(other);
+    }
+
+    NdArraySlice<T, Dim, Operand> &operator=(NdArraySlice &&other) {
+        return this->assign(other);
+    }
 
-        std::array<index_t, Dim> indices;
-        const index_t size = this->size();
-        for (index_t i = 0; i < size; ++i) {
-            util::unravel_index<Dim>(i, this->_shape, indices);
-            for (std::size_t j = 0; j < Dim; ++j) {
-                operand_indices[this->_slice_axes[j]] = this->_slices[j] * indices[j];
+    /* Assigns the elements of other, which may be any array of the same shape, including a slice of the same array.
+     * Between strided arrays, elements are copied directly in contiguous runs where possible; the result is as if other
+     * had been copied to a temporary first. */
+    template <typename U, typename OtherDerived>
+    NdArraySlice<T, Dim, Operand> &assign(const NdArrayBase<U, Dim, OtherDerived> &other) {
+        if (this->_shape != other.shape()) {
+            throw std::invalid_argument(std::format("Cannot assign an array of _shape {} to {}",
+                                                    other.shape().to_string(), this->_shape.to_string()));
+        }
+
+        if constexpr (std::is_same_v<U, T> && util::is_strided<OtherDerived>) {
+            const OtherDerived &src = static_cast<const OtherDerived &>(other);
+            util::strided_copy(this->data(), this->strides(), src.data(), util::strides_of(src), this->_shape);
+        } else if constexpr (util::is_strided<OtherDerived>) {
+            /* Arrays of different element types cannot share memory. */
+            nditer(
+                [](index_t length, const std::array<index_t, 2> &strides, T *out, const U *in) {
+                    util::for_each_in_run(
+                        length, strides, [](T &o, const U &val) { o = static_cast<T>(val); }, out, in);
+                },
+                *this, static_cast<const OtherDerived &>(other));
+        } else {
+            NdArray<T, Dim> converted(this->_shape);
+            T *out = converted.data();
+            for (index_t i = 0; i < this->size(); ++i) {
+                out[i] = static_cast<T>(other.item(i));
             }
-            this->_operand[operand_indices] = other[indices];
+            *this = converted;
         }
 
         return *this;
@@ -363,63 +335,52 @@ public:
     /* Method *********************************************************************************************************/
 
     bool all(void) const {
-        std::array<index_t, Dim> indices;
-        const index_t size = this->size();
-        for (index_t i = 0; i < size; ++i) {
-            util::unravel_index<Dim>(i, this->_shape, indices);
-            if (!this->operator[](indices)) {
-                return false;
-            }
-        }
-
-        return true;
+        bool result = true;
+        nditer(
+            [&result](index_t length, const std::array<index_t, 1> &strides, const T *in) {
+                for (index_t i = 0; i < length && result; ++i) {
+                    result = static_cast<bool>(in[i * strides[0]]);
+                }
+                return result;
+            },
+            *this);
+        return result;
     }
 
     bool any(void) const {
-        std::array<index_t, Dim> indices;
-        const index_t size = this->size();
-        for (index_t i = 0; i < size; ++i) {
-            util::unravel_index<Dim>(i, this->_shape, indices);
-            if (this->operator[](indices)) {
-                return true;
-            }
-        }
-
-        return false;
+        bool result = false;
+        nditer(
+            [&result](index_t length, const std::array<index_t, 1> &strides, const T *in) {
+                for (index_t i = 0; i < length && !result; ++i) {
+                    result = static_cast<bool>(in[i * strides[0]]);
+                }
+                return !result;
+            },
+            *this);
+        return result;
     }
 
     template <typename U>
     NdArray<U, Dim> as_type(void) const {
         NdArray<U, Dim> result(this->_shape);
-
-        std::array<index_t, Dim> indices;
-        const index_t size = this->size();
-        for (index_t i = 0; i < size; ++i) {
-            util::unravel_index<Dim>(i, this->_shape, indices);
-            result[indices] = static_cast<U>(this->operator[](indices));
-        }
-
+        nditer(
+            [](index_t length, const std::array<index_t, 2> &strides, U *out, const T *in) {
+                util::for_each_in_run(length, strides, [](U &o, const T &val) { o = static_cast<U>(val); }, out, in);
+            },
+            result, *this);
         return result;
     }
 
-    void fill(const T &val) {
-        std::array<index_t, Operand::dim> operand_indices;
-        for (std::size_t i = 0, j = 0; i < Operand::dim; ++i) {
-            if (!this->_is_slice_axis[i]) {
-                operand_indices[i] = this->_indices[j];
-                ++j;
-            }
-        }
+    pointer data(void) const {
+        return this->_data;
+    }
 
-        std::array<index_t, Dim> indices;
-        const index_t size = this->size();
-        for (index_t i = 0; i < size; ++i) {
-            util::unravel_index<Dim>(i, this->_shape, indices);
-            for (std::size_t j = 0; j < Dim; ++j) {
-                operand_indices[this->_slice_axes[j]] = this->_slices[j] * indices[j];
-            }
-            this->_operand[operand_indices] = val;
-        }
+    void fill(const T &val) {
+        nditer(
+            [&val](index_t length, const std::array<index_t, 1> &strides, T *out) {
+                util::for_each_in_run(length, strides, [&val](T &o) { o = val; }, out);
+            },
+            *this);
     }
 
     T &item(index_t index) {
@@ -433,10 +394,7 @@ public:
             index += size;
         }
 
-        std::array<index_t, Dim> indices;
-        util::unravel_index<Dim>(index, this->_shape, indices);
-
-        return this->operator[](indices);
+        return this->_data[this->offset(index)];
     }
 
     const T &item(index_t index) const {
@@ -450,10 +408,7 @@ public:
             index += size;
         }
 
-        std::array<index_t, Dim> indices;
-        util::unravel_index<Dim>(index, this->_shape, indices);
-
-        return this->operator[](indices);
+        return this->_data[this->offset(index)];
     }
 
     template <std::size_t NewDim>
@@ -464,23 +419,120 @@ public:
         }
 
         NdArray<T, NewDim> result(new_shape);
-        for (index_t i = 0; i < this->size(); ++i) {
-            result._data[i] = this->item(i);
-        }
+        util::strided_copy(result._data, util::contiguous_strides(this->_shape), static_cast<const T *>(this->_data),
+                           this->_strides, this->_shape);
         return result;
     }
 
+    /* Makes this view refer to the elements of other, of any shape, without touching the elements of either. */
+    NdArraySlice<T, Dim, Operand> &rebind(const NdArraySlice &other) {
+        this->_shape = other._shape;
+        this->_data = other._data;
+        this->_strides = other._strides;
+        this->_owner = other._owner;
+        return *this;
+    }
+
+    /* Object kept alive by the view, if any. */
+    const std::shared_ptr<const void> &owner(void) const {
+        return this->_owner;
+    }
+
+    /* Distance in elements between consecutive elements of the view along each axis. */
+    const std::array<index_t, Dim> &strides(void) const {
+        return this->_strides;
+    }
+
 private:
     template <typename, std::size_t>
     friend class NdArray;
     template <typename, std::size_t, typename>
     friend class NdArraySlice;
 
-    Operand &_operand;
-    const std::array<bool, Operand::dim> _is_slice_axis;
-    const std::array<index_t, Operand::dim - Dim> _indices;
-    const std::array<Slice, Dim> _slices;
-    const std::array<index_t, Dim> _slice_axes;
+    /* Offset of the element at the given normalized indices from the first element. */
+    index_t offset(const std::array<index_t, Dim> &indices) const {
+        index_t offset = 0;
+        for (std::size_t i = 0; i < Dim; ++i) {
+            offset += indices[i] * this->_strides[i];
+        }
+        return offset;
+    }
+
+    /* Offset of the index-th element in C order from the first element. */
+    index_t offset(index_t index) const {
+        index_t offset = 0;
+        for (std::size_t i = Dim; i > 0; --i) {
+            offset += (index % this->_shape[i - 1]) * this->_strides[i - 1];
+            index /= this->_shape[i - 1];
+        }
+        return offset;
+    }
+
+    /* View of the given normalized indices and slices of this view, sharing its owner. */
+    template <std::size_t NSlices>
+    NdArraySlice<T, NSlices, Operand> subview(const std::array<bool, Dim> &is_slice_axis,
+                                              const std::array<index_t, Dim - NSlices> &indices,
+                                              const std::array<Slice, NSlices> &slices) const {
+        pointer data = this->_data;
+        std::array<index_t, NSlices> strides;
+        for (std::size_t i = 0, j = 0, k = 0; i < Dim; ++i) {
+            if (is_slice_axis[i]) {
+                data += slices[j].start * this->_strides[i];
+                strides[j] = slices[j].step * this->_strides[i];
+                ++j;
+            } else {
+                data += indices[k] * this->_strides[i];
+                ++k;
+            }
+        }
+
+        return {data, util::slices_to_shape(slices), strides, this->_owner};
+    }
+
+    pointer _data;
+    std::array<index_t, Dim> _strides;
+    std::shared_ptr<const void> _owner;
+};
+
+/* A view with value semantics: copying or assigning a handle rebinds it and never touches the viewed elements, so
+ * handles can be stored in containers and reordered by erase, insert or std::sort. The view itself is reached with *
+ * and ->, where assignment assigns elements as usual. */
+template <typename T, std::size_t Dim, typename Operand>
+class SliceHandle {
+public:
+    SliceHandle(const NdArraySlice<T, Dim, Operand> &slice) : _slice(slice) {}
+
+    SliceHandle(const SliceHandle &other) = default;
+    SliceHandle(SliceHandle &&other) = default;
+
+    SliceHandle &operator=(const SliceHandle &other) {
+        this->_slice.rebind(other._slice);
+        return *this;
+    }
+
+    SliceHandle &operator=(SliceHandle &&other) {
+        this->_slice.rebind(other._slice);
+        return *this;
+    }
+
+    NdArraySlice<T, Dim, Operand> &operator*(void) {
+        return this->_slice;
+    }
+
+    const NdArraySlice<T, Dim, Operand> &operator*(void) const {
+        return this->_slice;
+    }
+
+    NdArraySlice<T, Dim, Operand> *operator->(void) {
+        return &this->_slice;
+    }
+
+    const NdArraySlice<T, Dim, Operand> *operator->(void) const {
+        return &this->_slice;
+    }
+
+private:
+    NdArraySlice<T, Dim, Operand> _slice;
 };
 
 std::ostream &operator<<(std::ostream &os, const Slice &slice) {
@@ -0,0 +1,460 @@
+#ifndef NDARRAY_SORT_HPP
+#define NDARRAY_SORT_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "ndarray-base.hpp"
+#include "ndarray-core.hpp"
+#include "ndarray-op.hpp"
+#include "ndarray-parallel.hpp"
+
+namespace ndarray {
+
+namespace util {
+
+/* Ordering used by all sorting functions. NaNs compare larger than every other value so that they are sorted last, as
+ * in NumPy. */
+template <typename T>
+bool sort_less(const T &a, const T &b) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return a < b || (std::isnan(b) && !std::isnan(a));
+    } else {
+        return a < b;
+    }
+}
+
+/* Radix sort ********************************************************************************************************/
+
+template <typename T>
+constexpr bool is_radix_sortable = std::is_arithmetic_v<T> && sizeof(T) <= sizeof(std::uint64_t);
+
+/* Lines shorter than this are sorted with comparison sorts. */
+constexpr index_t radix_sort_threshold = 256;
+
+template <typename T>
+using radix_key_t =
+    std::conditional_t<sizeof(T) == 1, std::uint8_t,
+                       std::conditional_t<sizeof(T) == 2, std::uint16_t,
+                                          std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>>>;
+
+/* Maps a value to an unsigned key with the same ordering as sort_less. */
+template <typename T>
+radix_key_t<T> to_radix_key(T val) {
+    using K = radix_key_t<T>;
+    constexpr K sign = K(1) << (8 * sizeof(T) - 1);
+
+    if constexpr (std::is_floating_point_v<T>) {
+        if (std::isnan(val)) {
+            return static_cast<K>(~K(0));
+        }
+        const K bits = std::bit_cast<K>(val);
+        return (bits & sign) ? static_cast<K>(~bits) : static_cast<K>(bits | sign);
+    } else if constexpr (std::is_signed_v<T>) {
+        return static_cast<K>(static_cast<K>(val) ^ sign);
+    } else {
+        return static_cast<K>(val);
+    }
+}
+
+template <typename T>
+T from_radix_key(radix_key_t<T> key) {
+    using K = radix_key_t<T>;
+    constexpr K sign = K(1) << (8 * sizeof(T) - 1);
+
+    if constexpr (std::is_floating_point_v<T>) {
+        return std::bit_cast<T>((key & sign) ? static_cast<K>(key & ~sign) : static_cast<K>(~key));
+    } else if constexpr (std::is_signed_v<T>) {
+        return static_cast<T>(static_cast<K>(key ^ sign));
+    } else {
+        return static_cast<T>(key);
+    }
+}
+
+/* Stable LSD radix sort of keys, one byte per pass, carrying an optional payload along. Bytes that are equal in all
+ * keys are skipped. The histograms of all bytes are built in a single pass over the keys. */
+template <typename K, bool WithPayload>
+void radix_sort(K *keys, index_t *payload, index_t n, K *key_buf, index_t *payload_buf) {
+    constexpr std::size_t num_bytes = sizeof(K);
+
+    std::array<std::array<index_t, 256>, num_bytes> counts = {};
+    for (index_t i = 0; i < n; ++i) {
+        for (std::size_t b = 0; b < num_bytes; ++b) {
+            ++counts[b][(keys[i] >> (8 * b)) & 0xff];
+        }
+    }
+
+    K *src_keys = keys, *dst_keys = key_buf;
+    index_t *src_payload = payload, *dst_payload = payload_buf;
+    for (std::size_t b = 0; b < num_bytes; ++b) {
+        std::array<index_t, 256> &count = counts[b];
+        if (count[(src_keys[0] >> (8 * b)) & 0xff] == n) {
+            continue;
+        }
+
+        index_t offset = 0;
+        for (index_t &c : count) {
+            const index_t tmp = c;
+            c = offset;
+            offset += tmp;
+        }
+
+        for (index_t i = 0; i < n; ++i) {
+            const index_t pos = count[(src_keys[i] >> (8 * b)) & 0xff]++;
+            dst_keys[pos] = src_keys[i];
+            if constexpr (WithPayload) {
+                dst_payload[pos] = src_payload[i];
+            }
+        }
+
+        std::swap(src_keys, dst_keys);
+        if constexpr (WithPayload) {
+            std::swap(src_payload, dst_payload);
+        }
+    }
+
+    if (src_keys != keys) {
+        std::copy(src_keys, src_keys + n, keys);
+        if constexpr (WithPayload) {
+            std::copy(src_payload, src_payload + n, payload);
+        }
+    }
+}
+
+/* Per-thread buffers reused across the lines sorted by one thread. */
+template <typename T>
+class SortScratch {
+public:
+    using key_type = std::conditional_t<is_radix_sortable<T>, radix_key_t<T>, unsigned char>;
+
+    std::vector<T> values;
+    std::vector<index_t> indices;
+    std::vector<index_t> index_buf;
+    std::vector<key_type> keys;
+    std::vector<key_type> key_buf;
+};
+
+/* Sorts n contiguous values. */
+template <typename T>
+void sort_values(T *data, index_t n, SortScratch<T> &scratch) {
+    if constexpr (is_radix_sortable<T>) {
+        if (n >= radix_sort_threshold) {
+            scratch.keys.resize(n);
+            scratch.key_buf.resize(n);
+            std::transform(data, data + n, scratch.keys.begin(), to_radix_key<T>);
+            radix_sort<radix_key_t<T>, false>(scratch.keys.data(), nullptr, n, scratch.key_buf.data(), nullptr);
+            std::transform(scratch.keys.begin(), scratch.keys.end(), data, from_radix_key<T>);
+            return;
+        }
+    }
+
+    std::sort(data, data + n, sort_less<T>);
+}
+
+/* Writes base, ..., base + n - 1 to indices in the stable sorted order of the n contiguous values. */
+template <typename T>
+void argsort_values(const T *values, index_t *indices, index_t n, index_t base, SortScratch<T> &scratch) {
+    std::iota(indices, indices + n, base);
+
+    if constexpr (is_radix_sortable<T>) {
+        if (n >= radix_sort_threshold) {
+            scratch.keys.resize(n);
+            scratch.key_buf.resize(n);
+            scratch.index_buf.resize(n);
+            std::transform(values, values + n, scratch.keys.begin(), to_radix_key<T>);
+            radix_sort<radix_key_t<T>, true>(scratch.keys.data(), indices, n, scratch.key_buf.data(),
+                                             scratch.index_buf.data());
+            return;
+        }
+    }
+
+    std::stable_sort(indices, indices + n,
+                     [values, base](index_t a, index_t b) { return sort_less(values[a - base], values[b - base]); });
+}
+
+/* Parallel merge sort ***********************************************************************************************/
+
+/* Number of elements taken from a among the first k elements of the stable merge of a and b. */
+template <typename E, typename Comp>
+index_t co_rank(index_t k, const E *a, index_t na, const E *b, index_t nb, Comp comp) {
+    index_t lo = std::max<index_t>(0, k - nb);
+    index_t hi = std::min(k, na);
+    while (lo < hi) {
+        const index_t i = lo + (hi - lo) / 2;
+        const index_t j = k - i;
+        if (i < na && j > 0 && !comp(b[j - 1], a[i])) {
+            lo = i + 1;
+        } else {
+            hi = i;
+        }
+    }
+    return lo;
+}
+
+/* Stable merge of a and b into out. Each thread merges its own part of the output, whose sources are found by binary
+ * search along the merge path. */
+template <typename E, typename Comp>
+void parallel_merge(const E *a, index_t na, const E *b, index_t nb, E *out, Comp comp) {
+    parallel_for(0, na + nb, parallel_grain_size, [&](index_t first, index_t last) {
+        const index_t i0 = co_rank(first, a, na, b, nb, comp);
+        const index_t i1 = co_rank(last, a, na, b, nb, comp);
+        std::merge(a + i0, a + i1, b + (first - i0), b + (last - i1), out + first, comp);
+    });
+}
+
+/* Sorts n contiguous elements by sorting one block per thread with sort_block(block_data, block_begin, block_size)
+ * and merging the sorted blocks pairwise with parallel merges. */
+template <typename E, typename SortBlock, typename Comp>
+void parallel_merge_sort(E *data, index_t n, SortBlock sort_block, Comp comp) {
+    const std::size_t blocks = num_blocks(n, parallel_grain_size);
+    if (blocks <= 1) {
+        sort_block(data, 0, n);
+        return;
+    }
+
+    std::vector<std::pair<index_t, index_t>> runs(blocks);
+    parallel_blocks(0, n, blocks, [&](std::size_t k, index_t first, index_t last) {
+        sort_block(data + first, first, last - first);
+        runs[k] = {first, last};
+    });
+
+    std::vector<E> buffer(n);
+    E *src = data;
+    E *dst = buffer.data();
+    while (runs.size() > 1) {
+        std::vector<std::pair<index_t, index_t>> merged;
+        for (std::size_t r = 0; r + 1 < runs.size(); r += 2) {
+            auto [first1, last1] = runs[r];
+            auto [first2, last2] = runs[r + 1];
+            parallel_merge(src + first1, last1 - first1, src + first2, last2 - first2, dst + first1, comp);
+            merged.push_back({first1, last2});
+        }
+        if (runs.size() % 2 == 1) {
+            auto [first, last] = runs.back();
+            std::copy(src + first, src + last, dst + first);
+            merged.push_back(runs.back());
+        }
+        runs = std::move(merged);
+        std::swap(src, dst);
+    }
+
+    if (src != data) {
+        parallel_for(0, n, parallel_grain_size,
+                     [&](index_t first, index_t last) { std::copy(src + first, src + last, data + first); });
+    }
+}
+
+/* Line helpers ******************************************************************************************************/
+
+template <typename T>
+const T *gather_line(const T *data, const AxisLayout &layout, index_t line, std::vector<T> &buffer) {
+    const T *src = data + layout.offset(line);
+    if (layout.stride() == 1) {
+        return src;
+    }
+
+    buffer.resize(layout.length);
+    for (index_t i = 0; i < layout.length; ++i) {
+        buffer[i] = src[i * layout.stride()];
+    }
+    return buffer.data();
+}
+
+template <typename T>
+void scatter_line(const T *line_data, index_t n, T *data, const AxisLayout &layout, index_t line) {
+    T *dst = data + layout.offset(line);
+    if (layout.stride() == 1 && dst == line_data) {
+        return;
+    }
+    for (index_t i = 0; i < n; ++i) {
+        dst[i * layout.stride()] = line_data[i];
+    }
+}
+
+inline index_t normalize_kth(index_t kth, index_t length) {
+    if (kth < -length || kth >= length) {
+        throw std::out_of_range(std::format("kth = {} is out of range for axis with size {}", kth, length));
+    }
+    return kth >= 0 ? kth : kth + length;
+}
+
+inline bool use_parallel_merge_sort(const AxisLayout &layout) {
+    return layout.lines() == 1 && layout.length >= 2 * parallel_grain_size && get_num_threads() > 1;
+}
+
+}  // namespace util
+
+/* Sorting ************************************************************************************************************/
+
+/* Returns a copy of arr sorted along axis. Integer and floating point values are sorted with a radix sort; a single
+ * long line is sorted with a parallel merge sort, and otherwise the lines are sorted independently across threads. */
+template <typename T, std::size_t Dim, typename Derived>
+NdArray<T, Dim> sort(const NdArrayBase<T, Dim, Derived> &arr, index_t axis = -1) {
+    NdArray<T, Dim> result = util::materialize(arr);
+    const util::AxisLayout layout(result.shape(), util::normalize_axis(axis, Dim));
+    T *data = result.data();
+
+    if (util::use_parallel_merge_sort(layout)) {
+        util::parallel_merge_sort(
+            data, layout.length,
+            [](T *block, index_t, index_t n) {
+                util::SortScratch<T> scratch;
+                util::sort_values(block, n, scratch);
+            },
+            util::sort_less<T>);
+        return result;
+    }
+
+    util::parallel_lines(layout, [&](std::size_t, index_t first, index_t last) {
+        util::SortScratch<T> scratch;
+        for (index_t line = first; line < last; ++line) {
+            T *line_data = const_cast<T *>(util::gather_line(data, layout, line, scratch.values));
+            util::sort_values(line_data, layout.length, scratch);
+            util::scatter_line(line_data, layout.length, data, layout, line);
+        }
+    });
+    return result;
+}
+
+/* Returns the indices that sort arr along axis. The sort is stable. */
+template <typename T, std::size_t Dim, typename Derived>
+NdArray<index_t, Dim> argsort(const NdArrayBase<T, Dim, Derived> &arr, index_t axis = -1) {
+    const NdArray<T, Dim> values = util::materialize(arr);
+    const util::AxisLayout layout(values.shape(), util::normalize_axis(axis, Dim));
+    NdArray<index_t, Dim> result(values.shape());
+    const T *data = values.data();
+    index_t *out = result.data();
+
+    if (util::use_parallel_merge_sort(layout)) {
+        util::parallel_merge_sort(
+            out, layout.length,
+            [data](index_t *block, index_t base, index_t n) {
+                util::SortScratch<T> scratch;
+                util::argsort_values(data + base, block, n, base, scratch);
+            },
+            [data](index_t a, index_t b) {
+                return util::sort_less(data[a], data[b]) || (!util::sort_less(data[b], data[a]) && a < b);
+            });
+        return result;
+    }
+
+    util::parallel_lines(layout, [&](std::size_t, index_t first, index_t last) {
+        util::SortScratch<T> scratch;
+        std::vector<index_t> indices(layout.length);
+        for (index_t line = first; line < last; ++line) {
+            const T *line_data = util::gather_line(data, layout, line, scratch.values);
+            util::argsort_values(line_data, indices.data(), layout.length, 0, scratch);
+            util::scatter_line(indices.data(), layout.length, out, layout, line);
+        }
+    });
+    return result;
+}
+
+/* Partitioning *******************************************************************************************************/
+
+/* Returns a copy of arr in which the kth element of each line along axis is in its sorted position, with no larger
+ * element before it and no smaller element after it. */
+template <typename T, std::size_t Dim, typename Derived>
+NdArray<T, Dim> partition(const NdArrayBase<T, Dim, Derived> &arr, index_t kth, index_t axis = -1) {
+    NdArray<T, Dim> result = util::materialize(arr);
+    const util::AxisLayout layout(result.shape(), util::normalize_axis(axis, Dim));
+    const index_t k = util::normalize_kth(kth, layout.length);
+    T *data = result.data();
+
+    util::parallel_lines(layout, [&](std::size_t, index_t first, index_t last) {
+        std::vector<T> buffer;
+        for (index_t line = first; line < last; ++line) {
+            T *line_data = const_cast<T *>(util::gather_line(data, layout, line, buffer));
+            std::nth_element(line_data, line_data + k, line_data + layout.length, util::sort_less<T>);
+            util::scatter_line(line_data, layout.length, data, layout, line);
+        }
+    });
+    return result;
+}
+
+/* Returns the indices that would partition arr as partition() does. */
+template <typename T, std::size_t Dim, typename Derived>
+NdArray<index_t, Dim> argpartition(const NdArrayBase<T, Dim, Derived> &arr, index_t kth, index_t axis = -1) {
+    const NdArray<T, Dim> values = util::materialize(arr);
+    const util::AxisLayout layout(values.shape(), util::normalize_axis(axis, Dim));
+    const index_t k = util::normalize_kth(kth, layout.length);
+    NdArray<index_t, Dim> result(values.shape());
+    const T *data = values.data();
+    index_t *out = result.data();
+
+    util::parallel_lines(layout, [&](std::size_t, index_t first, index_t last) {
+        std::vector<T> buffer;
+        std::vector<index_t> indices(layout.length);
+        for (index_t line = first; line < last; ++line) {
+            const T *line_data = util::gather_line(data, layout, line, buffer);
+            std::iota(indices.begin(), indices.end(), 0);
+            std::nth_element(indices.begin(), indices.begin() + k, indices.end(), [line_data](index_t a, index_t b) {
+                return util::sort_less(line_data[a], line_data[b]) ||
+                       (!util::sort_less(line_data[b], line_data[a]) && a < b);
+            });
+            util::scatter_line(indices.data(), layout.length, out, layout, line);
+        }
+    });
+    return result;
+}
+
+/* Returns the k largest (or smallest) elements of each line along axis and their indices, in sorted order. Ties are
+ * broken by the smaller index. */
+template <typename T, std::size_t Dim, typename Derived>
+std::pair<NdArray<T, Dim>, NdArray<index_t, Dim>> topk(const NdArrayBase<T, Dim, Derived> &arr, index_t k,
+                                                        index_t axis = -1, bool largest = true) {
+    const NdArray<T, Dim> values = util::materialize(arr);
+    const std::size_t ax = util::normalize_axis(axis, Dim);
+    const util::AxisLayout layout(values.shape(), ax);
+    if (k < 0 || k > layout.length) {
+        throw std::out_of_range(std::format("k = {} is out of range for axis {} with size {}", k, ax, layout.length));
+    }
+
+    std::array<index_t, Dim> out_shape;
+    for (std::size_t i = 0; i < Dim; ++i) {
+        out_shape[i] = i == ax ? k : values.shape()[i];
+    }
+    NdArray<T, Dim> top_values{Shape<Dim>(out_shape)};
+    NdArray<index_t, Dim> top_indices{Shape<Dim>(out_shape)};
+    const util::AxisLayout out_layout(top_values.shape(), ax);
+    const T *data = values.data();
+
+    util::parallel_lines(layout, [&](std::size_t, index_t first, index_t last) {
+        std::vector<T> buffer;
+        std::vector<T> line_values(k);
+        std::vector<index_t> indices(layout.length);
+        for (index_t line = first; line < last; ++line) {
+            const T *line_data = util::gather_line(data, layout, line, buffer);
+            const auto comp = [line_data, largest](index_t a, index_t b) {
+                const bool before = largest ? util::sort_less(line_data[b], line_data[a])
+                                            : util::sort_less(line_data[a], line_data[b]);
+                const bool after = largest ? util::sort_less(line_data[a], line_data[b])
+                                           : util::sort_less(line_data[b], line_data[a]);
+                return before || (!after && a < b);
+            };
+
+            std::iota(indices.begin(), indices.end(), 0);
+            if (k < layout.length) {
+                std::nth_element(indices.begin(), indices.begin() + k, indices.end(), comp);
+            }
+            std::sort(indices.begin(), indices.begin() + k, comp);
+
+            for (index_t i = 0; i < k; ++i) {
+                line_values[i] = line_data[indices[i]];
+            }
+            util::scatter_line(line_values.data(), k, top_values.data(), out_layout, line);
+            util::scatter_line(indices.data(), k, top_indices.data(), out_layout, line);
+        }
+    });
+    return {std::move(top_values), std::move(top_indices)};
+}
+
+}  // namespace ndarray
+
+#endif
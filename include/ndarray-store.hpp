@@ -0,0 +1,432 @@
+#ifndef NDARRAY_STORE_HPP
+#define NDARRAY_STORE_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ndarray-core.hpp"
+#include "ndarray-definition.hpp"
+#include "ndarray-io.hpp"
+#include "ndarray-op.hpp"
+#include "ndarray-parallel.hpp"
+#include "ndarray-shape.hpp"
+#include "ndarray-slice.hpp"
+#include "ndarray-util.hpp"
+
+namespace ndarray {
+
+namespace util {
+
+/* Dimension of the array selected by indices and slices args on an array of dimension Dim. */
+template <std::size_t Dim, typename... Args>
+constexpr std::size_t selection_dim = (std::size_t{0} + ... + is_slice_type<Args>) + Dim - sizeof...(Args);
+
+/* Normalized selection of indices and slices on an array, with indexed axes turned into slices of length 1. */
+template <std::size_t Dim>
+class Selection {
+public:
+    std::array<Slice, Dim> slices;
+    std::array<bool, Dim> is_slice_axis;
+
+    /* Shape of the selected array, made of the lengths of the axes that were not indexed. */
+    template <std::size_t N>
+    Shape<N> shape(void) const {
+        std::array<index_t, N> shape;
+        for (std::size_t i = 0, j = 0; i < Dim; ++i) {
+            if (this->is_slice_axis[i]) {
+                shape[j++] = this->slices[i].len();
+            }
+        }
+        return Shape<N>(shape);
+    }
+};
+
+template <std::size_t Dim, typename... Args>
+Selection<Dim> make_selection(const Shape<Dim> &shape, Args... args) {
+    constexpr std::size_t NSlices = selection_dim<Dim, Args...>;
+    constexpr std::size_t NIndices = Dim - NSlices;
+
+    std::array<bool, Dim> is_slice_axis;
+    is_slice_axis.fill(true);
+    std::array<index_t, NIndices> indices;
+    std::array<Slice, NSlices> slices;
+    if constexpr (sizeof...(Args) > 0) {
+        index_t i = 0;
+        ((is_slice_axis[i++] = is_slice_type<Args>), ...);
+        separate_index_slice<NIndices, NSlices, Args...>(indices.begin(), slices.begin(), args...);
+    }
+    normalize_indices_slices<NIndices, NSlices>(shape, is_slice_axis, indices, slices);
+
+    Selection<Dim> selection;
+    selection.is_slice_axis = is_slice_axis;
+    for (std::size_t i = 0, j = 0, k = 0; i < Dim; ++i) {
+        if (is_slice_axis[i]) {
+            selection.slices[i] = slices[j++];
+        } else {
+            selection.slices[i] = Slice(indices[k], indices[k] + 1);
+            ++k;
+        }
+    }
+    return selection;
+}
+
+/* Elements of one axis of a selection that fall into one chunk: the chunk index along the axis, and for each element
+ * its position in the selection and in the chunk. */
+class AxisChunk {
+public:
+    index_t chunk;
+    std::vector<std::pair<index_t, index_t>> elements;
+};
+
+/* Groups the elements selected by slice along an axis by the chunk of length chunk_size they fall into. */
+inline std::vector<AxisChunk> axis_chunks(const Slice &slice, index_t chunk_size) {
+    std::vector<AxisChunk> chunks;
+    for (index_t m = 0; m < slice.len(); ++m) {
+        const index_t pos = slice * m;
+        const index_t chunk = pos / chunk_size;
+        if (chunks.empty() || chunks.back().chunk != chunk) {
+            chunks.push_back(AxisChunk{chunk, {}});
+        }
+        chunks.back().elements.emplace_back(m, pos - chunk * chunk_size);
+    }
+    return chunks;
+}
+
+}  // namespace util
+
+/* Array stored on disk as a directory of independently compressed chunks, in the spirit of Zarr. Reading a selection
+ * only reads and decodes the chunks it touches, and writing one only rewrites those chunks, in parallel in both cases.
+ * Chunks that have never been written read as zeros. Each chunk is written to a temporary file that then replaces it,
+ * so readers never see a partially written chunk; writing the same chunk from several processes at once is not
+ * supported. */
+template <typename T, std::size_t Dim>
+    requires std::is_trivially_copyable_v<T>
+class ChunkedStore {
+public:
+    /* Creates an empty store at path, which must not hold a store already. */
+    static ChunkedStore<T, Dim> create(const std::filesystem::path &path, const Shape<Dim> &shape,
+                                       const Shape<Dim> &chunk_shape, const Compression &compression = Compression()) {
+        for (std::size_t i = 0; i < Dim; ++i) {
+            if (shape[i] < 0 || chunk_shape[i] <= 0) {
+                throw std::invalid_argument(
+                    std::format("Invalid shape {} or chunk shape {}", shape.to_string(), chunk_shape.to_string()));
+            }
+        }
+        if (std::filesystem::exists(path / metadata_name)) {
+            throw std::runtime_error(std::format("A store already exists at {}", path.string()));
+        }
+        std::filesystem::create_directories(path);
+
+        ChunkedStore<T, Dim> store(path, shape, chunk_shape, util::compression_filters(compression, sizeof(T)));
+        store.write_metadata();
+        return store;
+    }
+
+    /* Opens the store at path. Throws std::runtime_error if it does not hold elements of type T and dimension Dim. */
+    static ChunkedStore<T, Dim> open(const std::filesystem::path &path) {
+        std::ifstream is(path / metadata_name);
+        if (!is) {
+            throw std::runtime_error(std::format("No store at {}", path.string()));
+        }
+
+        auto expect = [&is](const std::string &key) {
+            std::string token;
+            if (!(is >> token) || token != key) {
+                throw std::runtime_error(std::format("Corrupt store metadata: expected {}", key));
+            }
+        };
+        auto read_number = [&is]() {
+            long long value;
+            if (!(is >> value)) {
+                throw std::runtime_error("Corrupt store metadata: expected a number");
+            }
+            return value;
+        };
+
+        expect(metadata_magic);
+        const long long version = read_number();
+        expect("kind");
+        const long long kind = read_number();
+        expect("elem_size");
+        const long long elem_size = read_number();
+        expect("big_endian");
+        const long long big_endian = read_number();
+        expect("dim");
+        const long long dim = read_number();
+        if (version != util::container_version || kind != util::dtype_kind<T> || elem_size != sizeof(T) ||
+            big_endian != (std::endian::native == std::endian::big) || dim != Dim) {
+            throw std::runtime_error(std::format("Store at {} holds {}-dimensional elements of {} bytes", path.string(),
+                                                 dim, elem_size));
+        }
+        expect("filters");
+        const long long filters = read_number();
+        std::array<index_t, Dim> shape, chunk_shape;
+        expect("shape");
+        for (std::size_t i = 0; i < Dim; ++i) {
+            shape[i] = read_number();
+        }
+        expect("chunks");
+        for (std::size_t i = 0; i < Dim; ++i) {
+            chunk_shape[i] = read_number();
+            if (shape[i] < 0 || chunk_shape[i] <= 0) {
+                throw std::runtime_error("Corrupt store metadata: invalid shape");
+            }
+        }
+        if ((filters & ~(util::filter_delta | util::filter_shuffle)) != 0) {
+            throw std::runtime_error("Corrupt store metadata: unknown filters");
+        }
+
+        return ChunkedStore<T, Dim>(path, Shape<Dim>(shape), Shape<Dim>(chunk_shape),
+                                    static_cast<std::uint8_t>(filters));
+    }
+
+    /* Reading ********************************************************************************************************/
+
+    /* Reads the elements selected by indices and slices, as by operator[] on an array. */
+    template <typename... Args>
+        requires(sizeof...(Args) <= Dim && (util::is_index_slice_type<Args> && ...) &&
+                 util::selection_dim<Dim, Args...> > 0)
+    NdArray<T, util::selection_dim<Dim, Args...>> read(Args... args) const {
+        constexpr std::size_t N = util::selection_dim<Dim, Args...>;
+        const util::Selection<Dim> selection = util::make_selection(this->_shape, args...);
+        NdArray<T, N> result(selection.template shape<N>());
+        T *data = result.data();
+
+        this->for_each_chunk(selection, [&](const std::array<index_t, Dim> &chunk,
+                                            const std::array<const util::AxisChunk *, Dim> &axes,
+                                            const std::array<index_t, Dim> &result_strides) {
+            const std::vector<T> buffer = this->read_chunk(chunk);
+            const std::array<index_t, Dim> chunk_strides = util::contiguous_strides(this->chunk_extents(chunk));
+            for_each_element(axes, [&](index_t result_offset, const std::array<index_t, Dim> &local) {
+                data[result_offset] = buffer[offset_of(local, chunk_strides)];
+            }, result_strides);
+        });
+        return result;
+    }
+
+    /* Writing ********************************************************************************************************/
+
+    /* Writes values to the elements selected by indices and slices. values must have the shape of the selection. */
+    template <std::size_t N, typename Derived, typename... Args>
+        requires(sizeof...(Args) <= Dim && (util::is_index_slice_type<Args> && ...) &&
+                 N == util::selection_dim<Dim, Args...>)
+    void write(const NdArrayBase<T, N, Derived> &values, Args... args) {
+        const util::Selection<Dim> selection = util::make_selection(this->_shape, args...);
+        if (values.shape() != selection.template shape<N>()) {
+            throw std::invalid_argument(std::format("Cannot write an array of shape {} to a selection of shape {}",
+                                                    values.shape().to_string(),
+                                                    selection.template shape<N>().to_string()));
+        }
+
+        if constexpr (util::is_contiguous<Derived>) {
+            if (util::layout_order(values) == Order::C) {
+                this->write_selection(selection, static_cast<const Derived &>(values).data());
+                return;
+            }
+        }
+        const NdArray<T, N> materialized = util::materialize(values);
+        this->write_selection(selection, materialized.data());
+    }
+
+    /* Properties *****************************************************************************************************/
+
+    const std::filesystem::path &path(void) const {
+        return this->_path;
+    }
+
+    const Shape<Dim> &shape(void) const {
+        return this->_shape;
+    }
+
+    const Shape<Dim> &chunk_shape(void) const {
+        return this->_chunk_shape;
+    }
+
+    /* Path of the file holding the chunk at the given chunk indices, which may not exist yet. */
+    std::filesystem::path chunk_path(const std::array<index_t, Dim> &chunk) const {
+        std::string name;
+        for (std::size_t i = 0; i < Dim; ++i) {
+            name += (i > 0 ? "." : "") + std::to_string(chunk[i]);
+        }
+        return this->_path / name;
+    }
+
+private:
+    static constexpr const char *metadata_name = "store.meta";
+    static constexpr const char *metadata_magic = "ndarray-chunked-store";
+
+    ChunkedStore(const std::filesystem::path &path, const Shape<Dim> &shape, const Shape<Dim> &chunk_shape,
+                 std::uint8_t filters)
+        : _path(path), _shape(shape), _chunk_shape(chunk_shape), _filters(filters) {}
+
+    /* Writes the C-contiguous elements of source to the selection. */
+    void write_selection(const util::Selection<Dim> &selection, const T *source) const {
+        this->for_each_chunk(selection, [&](const std::array<index_t, Dim> &chunk,
+                                            const std::array<const util::AxisChunk *, Dim> &axes,
+                                            const std::array<index_t, Dim> &source_strides) {
+            const Shape<Dim> extents = this->chunk_extents(chunk);
+            bool covered = true;
+            for (std::size_t i = 0; i < Dim; ++i) {
+                covered = covered && static_cast<index_t>(axes[i]->elements.size()) == extents[i];
+            }
+
+            /* Chunks that are only partly written are merged with their current contents. */
+            std::vector<T> buffer = covered ? std::vector<T>(extents.size()) : this->read_chunk(chunk);
+            const std::array<index_t, Dim> chunk_strides = util::contiguous_strides(extents);
+            for_each_element(axes, [&](index_t source_offset, const std::array<index_t, Dim> &local) {
+                buffer[offset_of(local, chunk_strides)] = source[source_offset];
+            }, source_strides);
+            this->write_chunk(chunk, buffer);
+        });
+    }
+
+    void write_metadata(void) const {
+        std::ofstream os(this->_path / metadata_name);
+        os << metadata_magic << ' ' << static_cast<int>(util::container_version) << '\n';
+        os << "kind " << static_cast<int>(util::dtype_kind<T>) << '\n';
+        os << "elem_size " << sizeof(T) << '\n';
+        os << "big_endian " << (std::endian::native == std::endian::big) << '\n';
+        os << "dim " << Dim << '\n';
+        os << "filters " << static_cast<int>(this->_filters) << '\n';
+        os << "shape";
+        for (std::size_t i = 0; i < Dim; ++i) {
+            os << ' ' << this->_shape[i];
+        }
+        os << "\nchunks";
+        for (std::size_t i = 0; i < Dim; ++i) {
+            os << ' ' << this->_chunk_shape[i];
+        }
+        os << '\n';
+        if (!os) {
+            throw std::runtime_error(std::format("Failed to write store metadata at {}", this->_path.string()));
+        }
+    }
+
+    /* Extents of the chunk at the given chunk indices; chunks at the end of an axis may be shorter. */
+    Shape<Dim> chunk_extents(const std::array<index_t, Dim> &chunk) const {
+        std::array<index_t, Dim> extents;
+        for (std::size_t i = 0; i < Dim; ++i) {
+            extents[i] = std::min(this->_chunk_shape[i], this->_shape[i] - chunk[i] * this->_chunk_shape[i]);
+        }
+        return Shape<Dim>(extents);
+    }
+
+    std::vector<T> read_chunk(const std::array<index_t, Dim> &chunk) const {
+        const Shape<Dim> extents = this->chunk_extents(chunk);
+        std::vector<T> buffer(extents.size());
+        std::ifstream is(this->chunk_path(chunk), std::ios::binary | std::ios::ate);
+        if (!is) {
+            return buffer;
+        }
+
+        std::vector<std::uint8_t> stored(static_cast<std::size_t>(is.tellg()));
+        is.seekg(0);
+        if (!is.read(reinterpret_cast<char *>(stored.data()), static_cast<std::streamsize>(stored.size())) ||
+            stored.size() > buffer.size() * sizeof(T)) {
+            throw std::runtime_error(std::format("Corrupt chunk {}", this->chunk_path(chunk).string()));
+        }
+        util::decode_chunk(stored.data(), stored.size(), reinterpret_cast<std::uint8_t *>(buffer.data()),
+                           buffer.size(), sizeof(T), this->_filters);
+        return buffer;
+    }
+
+    void write_chunk(const std::array<index_t, Dim> &chunk, const std::vector<T> &buffer) const {
+        std::vector<std::uint8_t> encoded;
+        util::encode_chunk(reinterpret_cast<const std::uint8_t *>(buffer.data()), buffer.size(), sizeof(T),
+                           this->_filters, encoded);
+
+        const std::filesystem::path path = this->chunk_path(chunk);
+        std::filesystem::path temporary = path;
+        temporary += ".tmp";
+        {
+            std::ofstream os(temporary, std::ios::binary | std::ios::trunc);
+            os.write(reinterpret_cast<const char *>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+            if (!os) {
+                throw std::runtime_error(std::format("Failed to write chunk {}", path.string()));
+            }
+        }
+        std::filesystem::rename(temporary, path);
+    }
+
+    /* Calls f(chunk, axes, strides) in parallel for each chunk touched by selection, where axes lists the selected
+     * elements of the chunk along each axis and strides are the C strides of the selection. */
+    template <typename F>
+    void for_each_chunk(const util::Selection<Dim> &selection, F f) const {
+        std::array<std::vector<util::AxisChunk>, Dim> axes;
+        std::array<index_t, Dim> extents;
+        index_t num_chunks = 1;
+        for (std::size_t i = 0; i < Dim; ++i) {
+            axes[i] = util::axis_chunks(selection.slices[i], this->_chunk_shape[i]);
+            extents[i] = selection.slices[i].len();
+            num_chunks *= static_cast<index_t>(axes[i].size());
+        }
+        const std::array<index_t, Dim> strides = util::contiguous_strides(Shape<Dim>(extents));
+
+        util::parallel_for(0, num_chunks, 1, [&](index_t first, index_t last) {
+            for (index_t k = first; k < last; ++k) {
+                std::array<index_t, Dim> chunk;
+                std::array<const util::AxisChunk *, Dim> chunk_axes;
+                for (std::size_t i = Dim, rest = static_cast<std::size_t>(k); i > 0; --i) {
+                    chunk_axes[i - 1] = &axes[i - 1][rest % axes[i - 1].size()];
+                    chunk[i - 1] = chunk_axes[i - 1]->chunk;
+                    rest /= axes[i - 1].size();
+                }
+                f(chunk, chunk_axes, strides);
+            }
+        });
+    }
+
+    /* Calls f(selection_offset, local) for each selected element of a chunk, where selection_offset is its offset in
+     * the selection for the given strides and local its indices in the chunk. */
+    template <typename F>
+    static void for_each_element(const std::array<const util::AxisChunk *, Dim> &axes, F f,
+                                 const std::array<index_t, Dim> &strides) {
+        std::array<std::size_t, Dim> positions{};
+        std::array<index_t, Dim> local;
+        while (true) {
+            index_t offset = 0;
+            for (std::size_t i = 0; i < Dim; ++i) {
+                const auto &[m, l] = axes[i]->elements[positions[i]];
+                offset += m * strides[i];
+                local[i] = l;
+            }
+            f(offset, local);
+
+            std::size_t i = Dim;
+            while (i > 0 && ++positions[i - 1] == axes[i - 1]->elements.size()) {
+                positions[i - 1] = 0;
+                --i;
+            }
+            if (i == 0) {
+                return;
+            }
+        }
+    }
+
+    static index_t offset_of(const std::array<index_t, Dim> &indices, const std::array<index_t, Dim> &strides) {
+        index_t offset = 0;
+        for (std::size_t i = 0; i < Dim; ++i) {
+            offset += indices[i] * strides[i];
+        }
+        return offset;
+    }
+
+    std::filesystem::path _path;
+    Shape<Dim> _shape;
+    Shape<Dim> _chunk_shape;
+    std::uint8_t _filters;
+};
+
+}  // namespace ndarray
+
+#endif
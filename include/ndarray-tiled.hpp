@@ -0,0 +1,541 @@
+#ifndef NDARRAY_TILED_HPP
+#define NDARRAY_TILED_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <format>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "ndarray-base.hpp"
+#include "ndarray-core.hpp"
+#include "ndarray-op.hpp"
+#include "ndarray-parallel.hpp"
+#include "ndarray-shape.hpp"
+
+namespace ndarray {
+
+/* Order in which the tiles of a TiledNdArray are stored. */
+enum class TileOrder { row_major, morton };
+
+template <typename T, std::size_t Dim, typename Operand>
+class TiledNdArraySlice;
+
+namespace util {
+
+template <std::size_t Dim>
+constexpr index_t default_tile = Dim == 2 ? 32 : 8;
+
+/* Z-order code of the given coordinates, with the bits of the last coordinate least significant. Bits that would land
+ * beyond the 64 bits of the code are dropped. */
+template <std::size_t Dim>
+std::uint64_t morton_code(const std::array<index_t, Dim> &coords) {
+    std::uint64_t code = 0;
+    for (std::size_t bit = 0; bit * Dim < 64; ++bit) {
+        for (std::size_t i = 0; i < Dim; ++i) {
+            const std::size_t position = bit * Dim + Dim - 1 - i;
+            if (position < 64) {
+                code |= ((static_cast<std::uint64_t>(coords[i]) >> bit) & 1) << position;
+            }
+        }
+    }
+    return code;
+}
+
+}  // namespace util
+
+/* A 2-D or 3-D array stored as Tile x Tile (x Tile) blocks. Elements within a tile are in C order, and the tiles
+ * themselves in C order over the tile grid or in Morton order. Neighbors along every axis then usually share a tile, so
+ * stencil-like kernels touch far fewer cache lines and pages than on C-ordered data. Tiles at the upper edges are
+ * padded to the full tile size.
+ *
+ * Indexing, slicing and every operation on arrays work as for NdArray; element-wise operations return C-ordered
+ * NdArrays. tile_data() gives direct access to the storage of one tile for kernels that work tile by tile. */
+template <typename T, std::size_t Dim, index_t Tile = util::default_tile<Dim>>
+class TiledNdArray : public NdArrayBase<T, Dim, TiledNdArray<T, Dim, Tile>> {
+public:
+    static_assert(Dim == 2 || Dim == 3, "TiledNdArray must have 2 or 3 dimensions");
+    static_assert(Tile > 0 && (Tile & (Tile - 1)) == 0, "Tile size must be a power of two");
+    static_assert(!std::is_same_v<T, bool>, "TiledNdArray does not support bool elements");
+
+    static constexpr index_t tile = Tile;
+    /* Number of elements of a tile. */
+    static constexpr index_t tile_size = Dim == 2 ? Tile * Tile : Tile * Tile * Tile;
+
+    explicit TiledNdArray(const Shape<Dim> &shape, TileOrder order = TileOrder::row_major)
+        : NdArrayBase<T, Dim, TiledNdArray>(shape), _order(order) {
+        for (std::size_t i = 0; i < Dim; ++i) {
+            this->_grid[i] = (shape[i] + Tile - 1) / Tile;
+        }
+        this->_data.resize(this->num_tiles() * tile_size);
+        this->init_slots();
+    }
+
+    /* Converts any array to the tiled layout. */
+    template <typename Derived>
+    explicit TiledNdArray(const NdArrayBase<T, Dim, Derived> &arr, TileOrder order = TileOrder::row_major)
+        : TiledNdArray(arr.shape(), order) {
+        if constexpr (util::is_contiguous<Derived>) {
+            if (util::layout_order(arr) == Order::C) {
+                this->copy_from(static_cast<const Derived &>(arr).data());
+                return;
+            }
+        }
+        this->copy_from(util::materialize(arr).data());
+    }
+
+    /* Conversion *****************************************************************************************************/
+
+    operator NdArray<T, Dim>() const {
+        return this->to_array();
+    }
+
+    /* Converts the array back to C order. */
+    NdArray<T, Dim> to_array(void) const {
+        NdArray<T, Dim> result(this->shape());
+        T *out = result.data();
+        this->for_each_run_parallel([&](index_t storage, index_t offset, index_t length) {
+            std::copy(this->_data.data() + storage, this->_data.data() + storage + length, out + offset);
+            return true;
+        });
+        return result;
+    }
+
+    /* Indexing *******************************************************************************************************/
+
+    template <typename... Args>
+        requires(sizeof...(Args) == Dim && (util::is_index_type<Args> && ...))
+    T &operator[](Args... args) {
+        std::array<index_t, Dim> indices = {static_cast<index_t>(args)...};
+        return this->operator[](indices);
+    }
+
+    template <typename... Args>
+        requires(sizeof...(Args) == Dim && (util::is_index_type<Args> && ...))
+    const T &operator[](Args... args) const {
+        std::array<index_t, Dim> indices = {static_cast<index_t>(args)...};
+        return this->operator[](indices);
+    }
+
+    T &operator[](const std::array<index_t, Dim> &indices) {
+        return this->_data[this->offset(util::normalize_indices(this->shape(), indices))];
+    }
+
+    const T &operator[](const std::array<index_t, Dim> &indices) const {
+        return this->_data[this->offset(util::normalize_indices(this->shape(), indices))];
+    }
+
+    /* Slicing ********************************************************************************************************/
+
+    template <typename... Args>
+        requires(sizeof...(Args) <= Dim && (util::is_index_slice_type<Args> && ...) &&
+                 !(sizeof...(Args) == Dim && (util::is_index_type<Args> && ...)))
+    auto operator[](Args... args) {
+        return TiledNdArraySlice<T, Dim, TiledNdArray>(*this).operator[](args...);
+    }
+
+    template <typename... Args>
+        requires(sizeof...(Args) <= Dim && (util::is_index_slice_type<Args> && ...) &&
+                 !(sizeof...(Args) == Dim && (util::is_index_type<Args> && ...)))
+    auto operator[](Args... args) const {
+        return TiledNdArraySlice<T, Dim, const TiledNdArray>(*this).operator[](args...);
+    }
+
+    /* Assignment *****************************************************************************************************/
+
+    template <typename U, typename Derived>
+    TiledNdArray &operator=(const NdArrayBase<U, Dim, Derived> &other) {
+        util::validate_shape_binary_op(this->shape(), other.shape());
+        if constexpr (std::is_same_v<U, T> && util::is_contiguous<Derived>) {
+            if (util::layout_order(other) == Order::C) {
+                this->copy_from(static_cast<const Derived &>(other).data());
+                return *this;
+            }
+        }
+        if constexpr (std::is_same_v<U, T>) {
+            this->copy_from(util::materialize(other).data());
+        } else {
+            this->copy_from(util::materialize(other).template as_type<T>().data());
+        }
+        return *this;
+    }
+
+    TiledNdArray &operator=(const T &val) {
+        this->fill(val);
+        return *this;
+    }
+
+    /* Method *********************************************************************************************************/
+
+    bool all(void) const {
+        return this->for_each_run(0, this->num_tiles(), [&](index_t storage, index_t, index_t length) {
+            return std::all_of(this->_data.begin() + storage, this->_data.begin() + storage + length,
+                               [](const T &val) { return static_cast<bool>(val); });
+        });
+    }
+
+    bool any(void) const {
+        return !this->for_each_run(0, this->num_tiles(), [&](index_t storage, index_t, index_t length) {
+            return std::none_of(this->_data.begin() + storage, this->_data.begin() + storage + length,
+                                [](const T &val) { return static_cast<bool>(val); });
+        });
+    }
+
+    template <typename U>
+    NdArray<U, Dim> as_type(void) const {
+        return this->to_array().template as_type<U>();
+    }
+
+    /* Tiled storage, including the padding of edge tiles. */
+    T *data(void) {
+        return this->_data.data();
+    }
+
+    const T *data(void) const {
+        return this->_data.data();
+    }
+
+    void fill(const T &val) {
+        std::fill(this->_data.begin(), this->_data.end(), val);
+    }
+
+    NdArray<T, 1> flatten(void) const {
+        return this->to_array().flatten();
+    }
+
+    /* Number of tiles along each axis. */
+    const std::array<index_t, Dim> &grid(void) const {
+        return this->_grid;
+    }
+
+    T &item(index_t index) {
+        return this->_data[this->offset(this->unravel(index))];
+    }
+
+    const T &item(index_t index) const {
+        return this->_data[this->offset(this->unravel(index))];
+    }
+
+    index_t num_tiles(void) const {
+        index_t result = 1;
+        for (std::size_t i = 0; i < Dim; ++i) {
+            result *= this->_grid[i];
+        }
+        return result;
+    }
+
+    TileOrder order(void) const {
+        return this->_order;
+    }
+
+    template <std::size_t NewDim>
+    NdArray<T, NewDim> reshape(const Shape<NewDim> &new_shape) const {
+        return this->to_array().reshape(new_shape);
+    }
+
+    /* Storage of the tile at the given tile coordinates, in C order within the tile. */
+    T *tile_data(const std::array<index_t, Dim> &tile_indices) {
+        return this->_data.data() + this->slot(this->tile_id(tile_indices)) * tile_size;
+    }
+
+    const T *tile_data(const std::array<index_t, Dim> &tile_indices) const {
+        return this->_data.data() + this->slot(this->tile_id(tile_indices)) * tile_size;
+    }
+
+private:
+    template <typename, std::size_t, typename>
+    friend class TiledNdArraySlice;
+
+    static constexpr index_t shift = std::countr_zero(static_cast<std::uint64_t>(Tile));
+
+    /* Offset in the storage of the element at the given normalized indices. */
+    index_t offset(const std::array<index_t, Dim> &indices) const {
+        index_t id = 0;
+        index_t inner = 0;
+        for (std::size_t i = 0; i < Dim; ++i) {
+            id = id * this->_grid[i] + (indices[i] >> shift);
+            inner = inner * Tile + (indices[i] & (Tile - 1));
+        }
+        return this->slot(id) * tile_size + inner;
+    }
+
+    std::array<index_t, Dim> unravel(index_t index) const {
+        const index_t size = this->size();
+        if (index < -size || index >= size) {
+            throw std::out_of_range(std::format("Index {} is out of bounds for size {}", index, size));
+        }
+
+        std::array<index_t, Dim> indices;
+        util::unravel_index<Dim>(index < 0 ? index + size : index, this->shape(), indices);
+        return indices;
+    }
+
+    index_t tile_id(const std::array<index_t, Dim> &tile_indices) const {
+        index_t id = 0;
+        for (std::size_t i = 0; i < Dim; ++i) {
+            if (tile_indices[i] < 0 || tile_indices[i] >= this->_grid[i]) {
+                throw std::out_of_range(
+                    std::format("Tile index {} is out of bounds for axis {} with {} tiles", tile_indices[i], i,
+                                this->_grid[i]));
+            }
+            id = id * this->_grid[i] + tile_indices[i];
+        }
+        return id;
+    }
+
+    /* Position in the storage of the tile with the given C-order id. */
+    index_t slot(index_t id) const {
+        return this->_slots.empty() ? id : this->_slots[id];
+    }
+
+    /* For Morton order, ranks the tiles by their Z-order code so that grids of any size are stored without gaps. */
+    void init_slots(void) {
+        if (this->_order != TileOrder::morton) {
+            return;
+        }
+
+        const index_t n = this->num_tiles();
+        std::vector<std::uint64_t> codes(n);
+        for (index_t id = 0; id < n; ++id) {
+            std::array<index_t, Dim> coords;
+            util::unravel_index<Dim>(id, Shape<Dim>(this->_grid), coords);
+            codes[id] = util::morton_code<Dim>(coords);
+        }
+
+        std::vector<index_t> ids(n);
+        std::iota(ids.begin(), ids.end(), index_t{0});
+        std::sort(ids.begin(), ids.end(), [&](index_t a, index_t b) { return codes[a] < codes[b]; });
+
+        this->_slots.resize(n);
+        for (index_t rank = 0; rank < n; ++rank) {
+            this->_slots[ids[rank]] = rank;
+        }
+    }
+
+    /* Calls f(storage offset, C-order offset, length) for each run of elements that is contiguous in both layouts, ie
+     * each row of each tile with ids [first, last), clipped to the array. Stops early and returns false when f does. */
+    template <typename F>
+    bool for_each_run(index_t first, index_t last, F f) const {
+        const std::array<index_t, Dim> strides = util::contiguous_strides(this->shape());
+        const Shape<Dim> grid_shape(this->_grid);
+
+        std::array<index_t, Dim> base;
+        for (index_t id = first; id < last; ++id) {
+            util::unravel_index<Dim>(id, grid_shape, base);
+            for (std::size_t i = 0; i < Dim; ++i) {
+                base[i] *= Tile;
+            }
+
+            const index_t storage = this->slot(id) * tile_size;
+            const index_t length = std::min(Tile, this->shape()[Dim - 1] - base[Dim - 1]);
+            for (index_t row = 0; row < tile_size / Tile; ++row) {
+                index_t offset = base[Dim - 1];
+                bool inside = true;
+                for (index_t i = static_cast<index_t>(Dim) - 2, r = row; i >= 0; --i, r >>= shift) {
+                    const index_t index = base[i] + (r & (Tile - 1));
+                    inside = inside && index < this->shape()[i];
+                    offset += index * strides[i];
+                }
+
+                if (inside && !f(storage + row * Tile, offset, length)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    template <typename F>
+    void for_each_run_parallel(F f) const {
+        util::parallel_for(0, this->num_tiles(), std::max<index_t>(util::parallel_grain_size / tile_size, 1),
+                           [&](index_t first, index_t last) { this->for_each_run(first, last, f); });
+    }
+
+    /* Copies C-ordered elements into the tiles. */
+    void copy_from(const T *src) {
+        this->for_each_run_parallel([&](index_t storage, index_t offset, index_t length) {
+            std::copy(src + offset, src + offset + length, this->_data.data() + storage);
+            return true;
+        });
+    }
+
+    TileOrder _order;
+    std::array<index_t, Dim> _grid;
+    std::vector<index_t> _slots;
+    std::vector<T> _data;
+};
+
+/* View of a TiledNdArray selected by indices and slices. Each axis of the view maps to one axis of the array with a
+ * step; elements are accessed through the tiled layout of the array, which must outlive the view. */
+template <typename T, std::size_t Dim, typename Operand>
+class TiledNdArraySlice : public NdArrayBase<T, Dim, TiledNdArraySlice<T, Dim, Operand>> {
+public:
+    using reference = std::conditional_t<std::is_const_v<Operand>, const T, T> &;
+
+    /* View of the whole array. */
+    explicit TiledNdArraySlice(Operand &arr) : NdArrayBase<T, Dim, TiledNdArraySlice>(arr.shape()), _array(&arr) {
+        static_assert(Dim == Operand::dim, "A view of a whole array must have the dimension of the array");
+        this->_origin.fill(0);
+        for (std::size_t i = 0; i < Dim; ++i) {
+            this->_axes[i] = i;
+            this->_steps[i] = 1;
+        }
+    }
+
+    TiledNdArraySlice(Operand &arr, const Shape<Dim> &shape, const std::array<index_t, Operand::dim> &origin,
+                      const std::array<std::size_t, Dim> &axes, const std::array<index_t, Dim> &steps)
+        : NdArrayBase<T, Dim, TiledNdArraySlice>(shape), _array(&arr), _origin(origin), _axes(axes), _steps(steps) {}
+
+    TiledNdArraySlice(const TiledNdArraySlice &other) = default;
+
+    /* Indexing *******************************************************************************************************/
+
+    template <typename... Args>
+        requires(sizeof...(Args) == Dim && (util::is_index_type<Args> && ...))
+    reference operator[](Args... args) const {
+        std::array<index_t, Dim> indices = {static_cast<index_t>(args)...};
+        return this->operator[](indices);
+    }
+
+    reference operator[](const std::array<index_t, Dim> &indices) const {
+        return this->at(util::normalize_indices(this->shape(), indices));
+    }
+
+    /* Slicing ********************************************************************************************************/
+
+    template <typename... Args>
+        requires(sizeof...(Args) <= Dim && (util::is_index_slice_type<Args> && ...) &&
+                 !(sizeof...(Args) == Dim && (util::is_index_type<Args> && ...)))
+    TiledNdArraySlice<T, util::count_slice_type<Args...> + Dim - sizeof...(Args), Operand> operator[](
+        Args... args) const {
+        static constexpr std::size_t NIndices = sizeof...(Args) - util::count_slice_type<Args...>;
+        static constexpr std::size_t NSlices = util::count_slice_type<Args...> + Dim - sizeof...(Args);
+
+        std::array<bool, Dim> is_slice_axis;
+        std::array<index_t, NIndices> indices;
+        std::array<Slice, NSlices> slices;
+
+        index_t i = 0;
+        ((is_slice_axis[i++] = util::is_slice_type<Args>), ...);
+        for (std::size_t i = sizeof...(Args); i < Dim; ++i) {
+            is_slice_axis[i] = true;
+        }
+
+        util::separate_index_slice<NIndices, NSlices, Args...>(indices.begin(), slices.begin(), args...);
+
+        util::normalize_indices_slices<NIndices, NSlices>(this->shape(), is_slice_axis, indices, slices);
+
+        std::array<index_t, Operand::dim> origin = this->_origin;
+        std::array<std::size_t, NSlices> axes;
+        std::array<index_t, NSlices> steps;
+        for (std::size_t i = 0, j = 0, k = 0; i < Dim; ++i) {
+            if (is_slice_axis[i]) {
+                origin[this->_axes[i]] += slices[j].start * this->_steps[i];
+                axes[j] = this->_axes[i];
+                steps[j] = slices[j].step * this->_steps[i];
+                ++j;
+            } else {
+                origin[this->_axes[i]] += indices[k] * this->_steps[i];
+                ++k;
+            }
+        }
+
+        return {*this->_array, util::slices_to_shape(slices), origin, axes, steps};
+    }
+
+    /* Assignment *****************************************************************************************************/
+
+    /* Assigns the elements of other, which may be a view of the same array; other is read entirely first. */
+    template <typename U, typename OtherDerived>
+    TiledNdArraySlice &operator=(const NdArrayBase<U, Dim, OtherDerived> &other) {
+        util::validate_shape_binary_op(this->shape(), other.shape());
+
+        const NdArray<T, Dim> converted = util::unary_op<T>(other, [](const U &val) { return static_cast<T>(val); });
+        const T *in = converted.data();
+        for (index_t i = 0; i < this->size(); ++i) {
+            this->item(i) = in[i];
+        }
+        return *this;
+    }
+
+    TiledNdArraySlice &operator=(const TiledNdArraySlice &other) {
+        return this->operator= <T, TiledNdArraySlice>(other);
+    }
+
+    TiledNdArraySlice &operator=(const T &val) {
+        this->fill(val);
+        return *this;
+    }
+
+    /* Method *********************************************************************************************************/
+
+    bool all(void) const {
+        for (index_t i = 0; i < this->size(); ++i) {
+            if (!this->item(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool any(void) const {
+        for (index_t i = 0; i < this->size(); ++i) {
+            if (this->item(i)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename U>
+    NdArray<U, Dim> as_type(void) const {
+        return util::unary_op<U>(*this, [](const T &val) { return static_cast<U>(val); });
+    }
+
+    void fill(const T &val) {
+        for (index_t i = 0; i < this->size(); ++i) {
+            this->item(i) = val;
+        }
+    }
+
+    NdArray<T, 1> flatten(void) const {
+        return util::materialize(*this).flatten();
+    }
+
+    reference item(index_t index) const {
+        const index_t size = this->size();
+        if (index < -size || index >= size) {
+            throw std::out_of_range(std::format("Index {} is out of bounds for size {}", index, size));
+        }
+
+        std::array<index_t, Dim> indices;
+        util::unravel_index<Dim>(index < 0 ? index + size : index, this->shape(), indices);
+        return this->at(indices);
+    }
+
+    template <std::size_t NewDim>
+    NdArray<T, NewDim> reshape(const Shape<NewDim> &new_shape) const {
+        return util::materialize(*this).reshape(new_shape);
+    }
+
+private:
+    reference at(const std::array<index_t, Dim> &indices) const {
+        std::array<index_t, Operand::dim> array_indices = this->_origin;
+        for (std::size_t i = 0; i < Dim; ++i) {
+            array_indices[this->_axes[i]] += indices[i] * this->_steps[i];
+        }
+        return this->_array->_data[this->_array->offset(array_indices)];
+    }
+
+    Operand *_array;
+    std::array<index_t, Operand::dim> _origin;
+    std::array<std::size_t, Dim> _axes;
+    std::array<index_t, Dim> _steps;
+};
+
+}  // namespace ndarray
+
+#endif
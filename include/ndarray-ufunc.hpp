@@ -0,0 +1,293 @@
+#ifndef NDARRAY_UFUNC_HPP
+#define NDARRAY_UFUNC_HPP
+
+#include <algorithm>
+#include <array>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "ndarray-base.hpp"
+#include "ndarray-core.hpp"
+#include "ndarray-iter.hpp"
+#include "ndarray-op.hpp"
+#include "ndarray-slice.hpp"
+
+namespace ndarray {
+
+/* Broadcasting *******************************************************************************************************/
+
+/* Shape to which arrays of the given shapes broadcast: along each axis, the extents must be equal or 1, and the
+ * result takes the one that is not 1. */
+template <std::size_t Dim, typename... Shapes>
+    requires(std::is_same_v<Shapes, Shape<Dim>> && ...)
+Shape<Dim> broadcast_shape(const Shape<Dim> &first, const Shapes &...rest) {
+    std::array<index_t, Dim> extents;
+    for (std::size_t i = 0; i < Dim; ++i) {
+        extents[i] = first[i];
+        [[maybe_unused]] const auto combine = [&](index_t extent) {
+            if (extents[i] == 1) {
+                extents[i] = extent;
+            } else if (extent != 1 && extent != extents[i]) {
+                std::string shapes = first.to_string();
+                ((shapes += ", " + rest.to_string()), ...);
+                throw std::invalid_argument(std::format("Shapes {} could not be broadcast together", shapes));
+            }
+        };
+        (combine(rest[i]), ...);
+    }
+    return Shape<Dim>(extents);
+}
+
+namespace util {
+
+/* Strides of a view of shape from, with the given strides, broadcast to shape to. */
+template <std::size_t Dim>
+std::array<index_t, Dim> broadcast_strides(const Shape<Dim> &from, std::array<index_t, Dim> strides,
+                                           const Shape<Dim> &to) {
+    for (std::size_t i = 0; i < Dim; ++i) {
+        if (from[i] == to[i]) {
+            continue;
+        }
+        if (from[i] != 1) {
+            throw std::invalid_argument(
+                std::format("Cannot broadcast an array of shape {} to {}", from.to_string(), to.to_string()));
+        }
+        strides[i] = 0;
+    }
+    return strides;
+}
+
+}  // namespace util
+
+/* Read-only view of a strided array repeated along its axes of extent 1 to the given shape, as in NumPy: the repeated
+ * axes have stride 0. Like a slice, the view does not keep the array alive. */
+template <typename T, std::size_t Dim, typename Derived>
+    requires util::is_strided<Derived>
+NdArraySlice<T, Dim, const Derived> broadcast_to(const NdArrayBase<T, Dim, Derived> &arr, const Shape<Dim> &shape) {
+    const Derived &derived = static_cast<const Derived &>(arr);
+    return NdArraySlice<T, Dim, const Derived>(derived.data(), shape,
+                                               util::broadcast_strides(arr.shape(), util::strides_of(derived), shape));
+}
+
+namespace util {
+
+/* Number of elements gathered from strided runs into contiguous buffers for batch kernels. */
+constexpr index_t batch_size = 256;
+
+template <typename T>
+constexpr bool is_tuple = false;
+
+template <typename... Ts>
+constexpr bool is_tuple<std::tuple<Ts...>> = true;
+
+/* An input of apply(), read through a strided view: the array itself when it is strided, and otherwise, or when it
+ * shares memory with an output without being the very same elements, a C-contiguous copy of it. */
+template <typename T, std::size_t Dim>
+class ApplyInput {
+public:
+    template <typename Derived>
+    explicit ApplyInput(const NdArrayBase<T, Dim, Derived> &arr) : _shape(arr.shape()) {
+        if constexpr (is_strided<Derived>) {
+            const Derived &derived = static_cast<const Derived &>(arr);
+            this->_data = derived.data();
+            this->_strides = strides_of(derived);
+        } else {
+            this->_copy.emplace(materialize(arr));
+        }
+    }
+
+    /* The input broadcast to shape. */
+    NdArraySlice<T, Dim, const NdArray<T, Dim>> view(const Shape<Dim> &shape) const {
+        const T *data = this->_copy ? this->_copy->data() : this->_data;
+        const std::array<index_t, Dim> strides = this->_copy ? contiguous_strides(this->_shape) : this->_strides;
+        return NdArraySlice<T, Dim, const NdArray<T, Dim>>(data, shape,
+                                                           broadcast_strides(this->_shape, strides, shape));
+    }
+
+    template <typename Out>
+    void detach_from(const Out &out) {
+        const auto input = this->view(out.shape());
+        const bool same_elements =
+            static_cast<const void *>(input.data()) == static_cast<const void *>(out.data()) &&
+            input.strides() == strides_of(out);
+        if (!this->_copy && !same_elements &&
+            may_overlap(input.data(), input.strides(), static_cast<const typename Out::dtype *>(out.data()),
+                        strides_of(out), out.shape())) {
+            this->_copy.emplace(materialize(NdArraySlice<T, Dim, const NdArray<T, Dim>>(this->_data, this->_shape,
+                                                                                         this->_strides)));
+        }
+    }
+
+private:
+    Shape<Dim> _shape;
+    const T *_data = nullptr;
+    std::array<index_t, Dim> _strides{};
+    std::optional<NdArray<T, Dim>> _copy;
+};
+
+/* Applies f to a run of the outputs and the inputs of apply(), given in that order. Callables invocable as
+ * f(length, outputs..., inputs...) on pointers to contiguous elements are batch kernels: unit-stride runs are handed to
+ * them directly, and other runs are gathered into buffers of batch_size elements first. Other callables are called
+ * on each element and return the value of the output, or a tuple of the values of the outputs. */
+template <std::size_t NumOut, typename F, std::size_t N, typename... Pointers>
+void apply_run(F &f, index_t length, const std::array<index_t, N> &strides, Pointers... pointers) {
+    using Types = std::tuple<std::remove_const_t<std::remove_pointer_t<Pointers>>...>;
+    const std::tuple<Pointers...> ptrs{pointers...};
+
+    [&]<std::size_t... O, std::size_t... I>(std::index_sequence<O...>, std::index_sequence<I...>) {
+        if constexpr (std::is_invocable_v<F &, index_t, std::tuple_element_t<O, Types> *...,
+                                          const std::tuple_element_t<NumOut + I, Types> *...>) {
+            if (std::all_of(strides.begin(), strides.end(), [](index_t stride) { return stride == 1; })) {
+                f(length, pointers...);
+                return;
+            }
+            std::tuple<std::array<std::tuple_element_t<O, Types>, batch_size>...> outs;
+            std::tuple<std::array<std::tuple_element_t<NumOut + I, Types>, batch_size>...> ins;
+            for (index_t begin = 0; begin < length; begin += batch_size) {
+                const index_t n = std::min(batch_size, length - begin);
+                const auto gather = [n, begin](auto &buffer, const auto *src, index_t stride) {
+                    for (index_t i = 0; i < n; ++i) {
+                        buffer[i] = src[(begin + i) * stride];
+                    }
+                };
+                const auto scatter = [n, begin](const auto &buffer, auto *dst, index_t stride) {
+                    for (index_t i = 0; i < n; ++i) {
+                        dst[(begin + i) * stride] = buffer[i];
+                    }
+                };
+                (gather(std::get<I>(ins), std::get<NumOut + I>(ptrs), strides[NumOut + I]), ...);
+                f(n, std::get<O>(outs).data()..., static_cast<const std::tuple_element_t<NumOut + I, Types> *>(
+                                                      std::get<I>(ins).data())...);
+                (scatter(std::get<O>(outs), std::get<O>(ptrs), strides[O]), ...);
+            }
+        } else {
+            for_each_in_run(
+                length, strides,
+                [&f](auto &...elements) {
+                    const auto refs = std::forward_as_tuple(elements...);
+                    decltype(auto) value = f(std::get<NumOut + I>(refs)...);
+                    if constexpr (NumOut == 1) {
+                        std::get<0>(refs) = static_cast<std::tuple_element_t<0, Types>>(value);
+                    } else {
+                        ((std::get<O>(refs) = static_cast<std::tuple_element_t<O, Types>>(std::get<O>(value))), ...);
+                    }
+                },
+                pointers...);
+        }
+    }(std::make_index_sequence<NumOut>(), std::make_index_sequence<sizeof...(Pointers) - NumOut>());
+}
+
+template <typename F, typename... Outs, typename... Inputs>
+void apply_outputs(F &f, const std::tuple<Outs &...> &outs, const Inputs &...inputs) {
+    static_assert((is_strided<std::remove_const_t<Outs>> && ...), "apply() outputs must be strided arrays");
+    constexpr std::size_t Dim = std::tuple_element_t<0, std::tuple<std::remove_const_t<Outs>...>>::dim;
+
+    const Shape<Dim> shape = std::get<0>(outs).shape();
+    std::apply(
+        [&shape](const auto &...out) {
+            for (const Shape<Dim> &other : {out.shape()...}) {
+                if (other != shape) {
+                    throw std::invalid_argument(std::format("apply() outputs could not have different shapes {} and {}",
+                                                            shape.to_string(), other.to_string()));
+                }
+            }
+        },
+        outs);
+
+    std::tuple<ApplyInput<typename Inputs::dtype, Dim>...> held(inputs...);
+    const auto detach = [&outs](auto &in) {
+        std::apply([&in](const auto &...out) { (in.detach_from(out), ...); }, outs);
+    };
+    std::apply([&detach](auto &...in) { (detach(in), ...); }, held);
+    const auto views = std::apply([&shape](const auto &...in) { return std::tuple{in.view(shape)...}; }, held);
+
+    const auto body = [&f](index_t length, const auto &strides, auto... pointers) {
+        apply_run<sizeof...(Outs)>(f, length, strides, pointers...);
+    };
+    std::apply(
+        [&](auto &...out) {
+            std::apply([&](const auto &...in) { parallel_nditer(body, out..., in...); }, views);
+        },
+        outs);
+}
+
+}  // namespace util
+
+/* Universal functions ************************************************************************************************/
+
+/* Writes f applied element-wise to the inputs into out, which is any strided array such as a slice, or a tuple of them
+ * as made by std::tie() when f has several outputs. Inputs are broadcast to the shape of the outputs; an input may be
+ * an output itself for an in-place update, and inputs that otherwise share memory with an output are copied first.
+ *
+ * f is either called on each element, with one const reference per input, returning the output value or a tuple of
+ * them; or it is a batch kernel callable as f(length, outputs..., inputs...) on pointers to length contiguous elements,
+ * which can process them with SIMD instructions. Large arrays are split across threads, so f must be safe to call
+ * concurrently. */
+template <typename F, typename Out, typename... Inputs>
+    requires(sizeof...(Inputs) > 0)
+void apply(F &&f, Out &&out, const Inputs &...inputs) {
+    if constexpr (util::is_tuple<std::remove_cvref_t<Out>>) {
+        std::apply([&](auto &...outs) { util::apply_outputs(f, std::tie(outs...), inputs...); }, out);
+    } else {
+        util::apply_outputs(f, std::tie(out), inputs...);
+    }
+}
+
+/* Scalar callable lifted to arrays by vectorize(). R is the output type, or a tuple of output types; void deduces it
+ * from the result of f on the input elements. */
+template <typename F, typename R = void>
+class Vectorized {
+public:
+    explicit Vectorized(F f) : _f(std::move(f)) {}
+
+    /* f applied to the inputs broadcast together, as a new array, or a tuple of arrays for several outputs. */
+    template <typename... Inputs>
+        requires(sizeof...(Inputs) > 0)
+    auto operator()(const Inputs &...inputs) const {
+        constexpr std::size_t Dim = std::tuple_element_t<0, std::tuple<Inputs...>>::dim;
+        using Result = typename std::conditional_t<std::is_void_v<R>,
+                                          std::invoke_result<const F &, const typename Inputs::dtype &...>,
+                                          std::type_identity<R>>::type;
+
+        const Shape<Dim> shape = broadcast_shape(inputs.shape()...);
+        const Order order = util::traversal_order(inputs...);
+        if constexpr (util::is_tuple<std::remove_cvref_t<Result>>) {
+            return [&]<typename... Rs>(std::type_identity<std::tuple<Rs...>>) {
+                std::tuple<NdArray<std::remove_cvref_t<Rs>, Dim>...> result{
+                    NdArray<std::remove_cvref_t<Rs>, Dim>(shape, order)...};
+                ndarray::apply(this->_f, result, inputs...);
+                return result;
+            }(std::type_identity<std::remove_cvref_t<Result>>());
+        } else {
+            NdArray<std::remove_cvref_t<Result>, Dim> result(shape, order);
+            ndarray::apply(this->_f, result, inputs...);
+            return result;
+        }
+    }
+
+    /* Writes f applied to the inputs into out, as apply() does. */
+    template <typename Out, typename... Inputs>
+        requires(sizeof...(Inputs) > 0)
+    void apply(Out &&out, const Inputs &...inputs) const {
+        ndarray::apply(this->_f, std::forward<Out>(out), inputs...);
+    }
+
+private:
+    F _f;
+};
+
+/* Lifts a scalar callable, or a batch kernel (see apply()), to an element-wise function of arrays. Batch kernels
+ * cannot be called on elements, so their output type R must be given. */
+template <typename R = void, typename F>
+Vectorized<std::decay_t<F>, R> vectorize(F &&f) {
+    return Vectorized<std::decay_t<F>, R>(std::forward<F>(f));
+}
+
+}  // namespace ndarray
+
+#endif
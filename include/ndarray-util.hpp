@@ -3,13 +3,19 @@
 
 #include <array>
 #include <concepts>
+#include <cstdint>
+#include <cstring>
 #include <format>
+#include <memory>
 #include <type_traits>
 #include <typeinfo>
+#include <vector>
 #ifndef _MSC_VER
 #include <cxxabi.h>
 #endif
 
+#include "ndarray-definition.hpp"
+
 namespace ndarray {
 
 template <std::size_t Dim>
@@ -42,18 +48,6 @@ inline index_t to_index_t(const std::string &str) {
     return ret;
 }
 
-template <std::size_t OperandDim, std::size_t Dim>
-std::array<index_t, Dim> pick_slice_axes(const std::array<bool, OperandDim> &is_slice_axis) {
-    std::array<index_t, Dim> slice_axes;
-    for (std::size_t i = 0, j = 0; i < OperandDim; ++i) {
-        if (is_slice_axis[i]) {
-            slice_axes[j] = i;
-            ++j;
-        }
-    }
-    return slice_axes;
-}
-
 template <std::size_t NIndices, std::size_t NSlices, typename T, typename... Args>
 void separate_index_slice(typename std::array<index_t, NIndices>::iterator indices_it,
                           typename std::array<Slice, NSlices>::iterator slices_it, T arg, Args... args) {
@@ -114,6 +108,44 @@ void normalize_indices_slices(const Shape<NIndices + NSlices> &shape,
     }
 }
 
+inline std::size_t normalize_axis(index_t axis, std::size_t dim) {
+    if (axis < -static_cast<index_t>(dim) || axis >= static_cast<index_t>(dim)) {
+        throw std::out_of_range(std::format("Axis {} is out of range for array of dimension {}", axis, dim));
+    }
+    return static_cast<std::size_t>(axis >= 0 ? axis : axis + static_cast<index_t>(dim));
+}
+
+/* Layout of the lines of a C-contiguous array along an axis. Line l starts at offset(l) and its elements are stride
+ * apart. */
+class AxisLayout {
+public:
+    template <std::size_t Dim>
+    AxisLayout(const Shape<Dim> &shape, std::size_t axis) : outer(1), length(shape[axis]), inner(1) {
+        for (std::size_t i = 0; i < axis; ++i) {
+            this->outer *= shape[i];
+        }
+        for (std::size_t i = axis + 1; i < Dim; ++i) {
+            this->inner *= shape[i];
+        }
+    }
+
+    index_t lines(void) const {
+        return this->outer * this->inner;
+    }
+
+    index_t offset(index_t line) const {
+        return (line / this->inner) * this->length * this->inner + line % this->inner;
+    }
+
+    index_t stride(void) const {
+        return this->inner;
+    }
+
+    index_t outer;
+    index_t length;
+    index_t inner;
+};
+
 template <std::size_t Dim>
 void unravel_index(index_t index, const Shape<Dim> &shape, std::array<index_t, Dim> &indices) {
     for (index_t i = static_cast<index_t>(Dim) - 1; i >= 0; --i) {
@@ -145,6 +177,229 @@ void validate_shape_binary_op(const Shape<Dim> &shape1, const Shape<Dim> &shape2
     }
 }
 
+template <std::size_t Size>
+class SignedOfSize;
+
+template <>
+class SignedOfSize<2> {
+public:
+    using type = std::int16_t;
+};
+
+template <>
+class SignedOfSize<4> {
+public:
+    using type = std::int32_t;
+};
+
+template <>
+class SignedOfSize<8> {
+public:
+    using type = std::int64_t;
+};
+
+/* Result type of an operation between two arrays, following NumPy's promotion rules: bool < integer < floating point,
+ * the wider type wins within a kind, and mixing signed and unsigned integers widens to a signed type that can hold
+ * both. */
+template <typename T1, typename T2>
+auto promote_helper(void) {
+    if constexpr (std::is_same_v<T1, T2>) {
+        return std::type_identity<T1>{};
+    } else if constexpr (!std::is_arithmetic_v<T1> || !std::is_arithmetic_v<T2>) {
+        return std::type_identity<std::common_type_t<T1, T2>>{};
+    } else if constexpr (std::is_same_v<T1, bool>) {
+        return std::type_identity<T2>{};
+    } else if constexpr (std::is_same_v<T2, bool>) {
+        return std::type_identity<T1>{};
+    } else if constexpr (std::is_floating_point_v<T1> && std::is_floating_point_v<T2>) {
+        return std::type_identity<std::conditional_t<(sizeof(T1) >= sizeof(T2)), T1, T2>>{};
+    } else if constexpr (std::is_floating_point_v<T1> || std::is_floating_point_v<T2>) {
+        using F = std::conditional_t<std::is_floating_point_v<T1>, T1, T2>;
+        using I = std::conditional_t<std::is_floating_point_v<T1>, T2, T1>;
+        return std::type_identity<std::conditional_t<(sizeof(I) < sizeof(F)), F, std::common_type_t<F, double>>>{};
+    } else if constexpr (std::is_signed_v<T1> == std::is_signed_v<T2>) {
+        return std::type_identity<std::conditional_t<(sizeof(T1) >= sizeof(T2)), T1, T2>>{};
+    } else {
+        using S = std::conditional_t<std::is_signed_v<T1>, T1, T2>;
+        using U = std::conditional_t<std::is_signed_v<T1>, T2, T1>;
+        if constexpr (sizeof(S) > sizeof(U)) {
+            return std::type_identity<S>{};
+        } else if constexpr (sizeof(U) < sizeof(std::int64_t)) {
+            return std::type_identity<typename SignedOfSize<2 * sizeof(U)>::type>{};
+        } else {
+            return std::type_identity<double>{};
+        }
+    }
+}
+
+template <typename T1, typename T2>
+using promote_t = typename decltype(promote_helper<std::remove_cv_t<T1>, std::remove_cv_t<T2>>())::type;
+
+template <typename T>
+constexpr int type_kind = std::is_same_v<T, bool> ? 0 : std::is_integral_v<T> ? 1 : std::is_floating_point_v<T> ? 2 : 3;
+
+/* Result type of an operation between an array of T and a scalar of S. As in NumPy, a scalar only changes the result
+ * type when it is of a higher kind than the array, so float_array * 2 stays float. */
+template <typename T, typename S>
+using weak_promote_t = std::conditional_t<(type_kind<std::remove_cv_t<S>> <= type_kind<std::remove_cv_t<T>>),
+                                          std::remove_cv_t<T>, promote_t<T, S>>;
+
+template <typename S, typename T>
+concept is_scalar_operand =
+    std::is_same_v<std::remove_cv_t<S>, std::remove_cv_t<T>> || (std::is_arithmetic_v<S> && std::is_arithmetic_v<T>);
+
+template <typename To, typename From>
+decltype(auto) convert(const From &val) {
+    if constexpr (std::is_same_v<To, From>) {
+        return val;
+    } else {
+        return static_cast<To>(val);
+    }
+}
+
+/* Arrays whose elements are stored densely in data(), in C order unless order() returns Order::F. */
+template <typename Derived>
+constexpr bool is_contiguous = false;
+
+/* Arrays whose elements can be addressed as data()[sum of index * stride]: contiguous arrays and slices of them. */
+template <typename Derived>
+concept is_strided = is_contiguous<Derived> || requires(const Derived &arr) {
+    arr.data();
+    arr.strides();
+};
+
+template <std::size_t Dim>
+std::array<index_t, Dim> contiguous_strides(const Shape<Dim> &shape) {
+    std::array<index_t, Dim> strides;
+    index_t stride = 1;
+    for (std::size_t i = Dim; i > 0; --i) {
+        strides[i - 1] = stride;
+        stride *= shape[i - 1];
+    }
+    return strides;
+}
+
+template <std::size_t Dim>
+std::array<index_t, Dim> fortran_strides(const Shape<Dim> &shape) {
+    std::array<index_t, Dim> strides;
+    index_t stride = 1;
+    for (std::size_t i = 0; i < Dim; ++i) {
+        strides[i] = stride;
+        stride *= shape[i];
+    }
+    return strides;
+}
+
+template <std::size_t Dim>
+std::array<index_t, Dim> order_strides(const Shape<Dim> &shape, Order order) {
+    return order == Order::F ? fortran_strides(shape) : contiguous_strides(shape);
+}
+
+/* Element strides of a strided array. */
+template <typename Derived>
+std::array<index_t, Derived::dim> strides_of(const Derived &arr) {
+    if constexpr (requires { arr.strides(); }) {
+        return arr.strides();
+    } else {
+        return contiguous_strides(arr.shape());
+    }
+}
+
+/* Copies n elements between strided runs, front to back or back to front. Runs of trivially copyable elements that
+ * are contiguous on both sides are copied with memmove. */
+template <typename T>
+void copy_run(T *dst, index_t dst_stride, const T *src, index_t src_stride, index_t n, bool backward) {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        if (dst_stride == 1 && src_stride == 1) {
+            std::memmove(dst, src, n * sizeof(T));
+            return;
+        }
+    }
+
+    if (backward) {
+        for (index_t i = n - 1; i >= 0; --i) {
+            dst[i * dst_stride] = src[i * src_stride];
+        }
+    } else {
+        for (index_t i = 0; i < n; ++i) {
+            dst[i * dst_stride] = src[i * src_stride];
+        }
+    }
+}
+
+/* Copies the elements of the strided view (src, src_strides) of the given shape into (dst, dst_strides).
+ *
+ * Trailing axes along which both views are contiguous are merged into a single run, so that a copy between contiguous
+ * rows is one memmove per row. Views into the same buffer may overlap: when they have the same strides and these visit
+ * increasing addresses in C order, as for C-ordered arrays, the elements are copied in increasing or decreasing address
+ * order so that no source element is overwritten before it is read, and otherwise the source is first copied to a
+ * temporary buffer. */
+template <typename T, std::size_t Dim>
+void strided_copy(T *dst, const std::array<index_t, Dim> &dst_strides, const T *src,
+                  const std::array<index_t, Dim> &src_strides, const Shape<Dim> &shape) {
+    const index_t size = shape.size();
+    if (size == 0) {
+        return;
+    }
+
+    /* Address ranges covered by the two views. */
+    const T *dst_lo = dst, *dst_hi = dst, *src_lo = src, *src_hi = src;
+    for (std::size_t i = 0; i < Dim; ++i) {
+        const index_t dst_extent = (shape[i] - 1) * dst_strides[i];
+        const index_t src_extent = (shape[i] - 1) * src_strides[i];
+        (dst_extent < 0 ? dst_lo : dst_hi) += dst_extent;
+        (src_extent < 0 ? src_lo : src_hi) += src_extent;
+    }
+
+    /* C-order traversal visits increasing addresses when each stride exceeds the extent of the axes inside it. */
+    bool same_order = dst_strides == src_strides;
+    index_t inner_extent = 0;
+    for (std::size_t i = Dim; i > 0 && same_order; --i) {
+        if (shape[i - 1] != 1) {
+            same_order = src_strides[i - 1] > inner_extent;
+            inner_extent += (shape[i - 1] - 1) * src_strides[i - 1];
+        }
+    }
+
+    const auto addr = [](const T *ptr) { return reinterpret_cast<std::uintptr_t>(ptr); };
+    const bool overlap = addr(dst_lo) <= addr(src_hi) && addr(src_lo) <= addr(dst_hi);
+    if (overlap && !same_order) {
+        const std::unique_ptr<T[]> buffer(new T[size]);
+        strided_copy(buffer.get(), contiguous_strides(shape), src, src_strides, shape);
+        strided_copy(dst, dst_strides, static_cast<const T *>(buffer.get()), contiguous_strides(shape), shape);
+        return;
+    }
+    const bool backward = overlap && addr(dst) > addr(src);
+
+    /* Merge the trailing axes along which both views are contiguous. */
+    std::size_t outer_dims = Dim;
+    index_t run = 1;
+    while (outer_dims > 0 && dst_strides[outer_dims - 1] == run && src_strides[outer_dims - 1] == run) {
+        run *= shape[outer_dims - 1];
+        --outer_dims;
+    }
+    index_t dst_run_stride = 1, src_run_stride = 1;
+    if (outer_dims == Dim) {
+        --outer_dims;
+        run = shape[outer_dims];
+        dst_run_stride = dst_strides[outer_dims];
+        src_run_stride = src_strides[outer_dims];
+    }
+
+    const index_t runs = size / run;
+    for (index_t r = 0; r < runs; ++r) {
+        index_t index = backward ? runs - 1 - r : r;
+        index_t dst_offset = 0, src_offset = 0;
+        for (std::size_t i = outer_dims; i > 0; --i) {
+            const index_t idx = index % shape[i - 1];
+            index /= shape[i - 1];
+            dst_offset += idx * dst_strides[i - 1];
+            src_offset += idx * src_strides[i - 1];
+        }
+        copy_run(dst + dst_offset, dst_run_stride, src + src_offset, src_run_stride, run, backward);
+    }
+}
+
 template <typename T>
 std::string type_name(void) {
     using RemoveRefT = std::remove_reference_t<T>;
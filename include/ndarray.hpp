@@ -1,8 +1,25 @@
 #include "ndarray-base.hpp"
 #include "ndarray-core.hpp"
 #include "ndarray-definition.hpp"
+#include "ndarray-fixed.hpp"
 #include "ndarray-func.hpp"
+#include "ndarray-io.hpp"
+#include "ndarray-iter.hpp"
+#include "ndarray-join.hpp"
+#include "ndarray-lazy.hpp"
+#include "ndarray-logic.hpp"
+#include "ndarray-mask.hpp"
+#include "ndarray-memory.hpp"
+#include "ndarray-mdspan.hpp"
 #include "ndarray-op.hpp"
+#include "ndarray-parallel.hpp"
+#include "ndarray-perf.hpp"
+#include "ndarray-random.hpp"
+#include "ndarray-scan.hpp"
 #include "ndarray-shape.hpp"
 #include "ndarray-slice.hpp"
+#include "ndarray-sort.hpp"
+#include "ndarray-store.hpp"
+#include "ndarray-tiled.hpp"
+#include "ndarray-ufunc.hpp"
 #include "ndarray-util.hpp"
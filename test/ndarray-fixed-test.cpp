@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include "../include/ndarray.hpp"
+
+using namespace ndarray;
+
+TEST(FixedNdArrayTest, Constructor) {
+    const FixedNdArray<int, 2, 3> a = {{0, 1, 2}, {3, 4, 5}};
+    const NdArray<int, 2> b = {{0, 1, 2}, {3, 4, 5}};
+
+    static_assert(FixedNdArray<int, 2, 3>::fixed_size == 6);
+    static_assert(FixedNdArray<int, 2, 3>::fixed_shape == Shape<2>({2, 3}));
+    static_assert(FixedNdArray<int, 2, 3>::strides == std::array<index_t, 2>{3, 1});
+
+    ASSERT_EQ(a.shape(), b.shape());
+    ASSERT_TRUE((a == b).all());
+    ASSERT_TRUE((FixedNdArray<int, 2, 3>(b) == a).all());
+    ASSERT_EQ(a.to_string(), b.to_string());
+}
+
+TEST(FixedNdArrayTest, Indexing) {
+    FixedNdArray<float, 3, 3> a = {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}};
+
+    a[1, 1] = -1;
+
+    EXPECT_EQ((a[-1, 0]), 6);
+    EXPECT_EQ((a[1, 1]), -1);
+    EXPECT_EQ(a.item(-1), 8);
+    EXPECT_ANY_THROW((a[3, 0]));
+}
+
+TEST(FixedNdArrayTest, Slicing) {
+    FixedNdArray<int, 3, 3> a = {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}};
+    const NdArray<int, 2> b = {{4, 5}, {7, 8}};
+    const NdArray<int, 2> c = {{0, 1, 2}, {3, 0, 0}, {6, 0, 0}};
+
+    ASSERT_TRUE((a["1:", "1:"] == b).all());
+
+    a["1:", "1:"] = 0;
+
+    ASSERT_TRUE((a == c).all());
+}
+
+TEST(FixedNdArrayTest, Arithmetic) {
+    const FixedNdArray<float, 2, 2> a = {{1, 2}, {3, 4}};
+    const FixedNdArray<int, 2, 2> b = {{1, 1}, {2, 2}};
+    const NdArray<float, 2> c = {{1, 2}, {3, 4}};
+
+    const auto d = a * 2 + b;
+    const auto e = a + c;
+
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(d)>, FixedNdArray<double, 2, 2>>);
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(e)>, NdArray<float, 2>>);
+    ASSERT_TRUE((d == FixedNdArray<double, 2, 2>({{3, 5}, {8, 10}})).all());
+    ASSERT_TRUE((e == a * 2).all());
+}
+
+TEST(FixedNdArrayTest, Reshape) {
+    const FixedNdArray<int, 2, 3> a = {{0, 1, 2}, {3, 4, 5}};
+    const FixedNdArray<int, 3, 2> b = {{0, 1}, {2, 3}, {4, 5}};
+
+    ASSERT_TRUE((a.reshape<3, 2>() == b).all());
+    ASSERT_TRUE((a.reshape(Shape<2>({3, 2})) == b).all());
+}
+
+TEST(FixedNdArrayTest, Storage) {
+    const FixedNdArray<double, 3, 3> a = {{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+    const FixedNdArray<int, 3, 3> b = {{1, 0, 1}, {0, 1, 0}, {1, 0, 1}};
+
+    static_assert(sizeof(FixedNdArray<double, 3, 3>) == sizeof(std::array<double, 9>));
+    static_assert(FixedNdArray<double, 3, 3>::shape() == Shape<2>({3, 3}));
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(-a)>, FixedNdArray<double, 3, 3>>);
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(a == b)>, FixedNdArray<bool, 3, 3>>);
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(!b)>, FixedNdArray<bool, 3, 3>>);
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(a["1:", "1:"] * 2)>, NdArray<double, 2>>);
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(a < NdArray<double, 2>(a))>, NdArrayMask<2>>);
+
+    const NdArray<double, 2> c = a;
+    ASSERT_EQ(a.shape(), c.shape());
+    ASSERT_TRUE(((a * b + 1) == (c * b + 1)).all());
+    ASSERT_EQ(count_nonzero(a > 4), 5);
+    ASSERT_TRUE(((!b) == (b == 0)).all());
+    ASSERT_ANY_THROW((a + FixedNdArray<double, 9, 1>()));
+}
@@ -0,0 +1,467 @@
+#include <gtest/gtest.h>
+
+#include "../include/ndarray.hpp"
+
+using namespace ndarray;
+
+static NdArray<int, 1> iota(int start, int stop) {
+    NdArray<int, 1> result(Shape<1>({stop - start}));
+    std::iota(result.data(), result.data() + result.size(), start);
+    return result;
+}
+
+TEST(JoinTest, Concatenate) {
+    const NdArray<int, 2> a = {{0, 1}, {2, 3}};
+    const NdArray<int, 2> b = {{4, 5}};
+    const NdArray<int, 2> c = {{0, 1}, {2, 3}, {4, 5}};
+    const NdArray<int, 2> d = {{0, 1, 0, 1}, {2, 3, 2, 3}};
+
+    ASSERT_TRUE((concatenate(std::vector{a, b}) == c).all());
+    ASSERT_TRUE((concatenate(std::vector{std::cref(a), std::cref(a)}, -1) == d).all());
+    EXPECT_ANY_THROW(concatenate(std::vector{a, b}, 1));
+    EXPECT_ANY_THROW(concatenate(std::vector<NdArray<int, 2>>{}));
+}
+
+TEST(JoinTest, ConcatenateSlice) {
+    const NdArray<int, 2> a = {{0, 1, 2}, {3, 4, 5}};
+    const NdArray<int, 2> b = {{2, 1}, {5, 4}, {0, 1}, {3, 4}};
+
+    const auto c = concatenate(std::vector{a[":", "2:0:-1"], a[":", ":2"]});
+
+    ASSERT_TRUE((c == b).all());
+
+    /* Views are copied with strided copies; the result matches joining copies of them along every axis. */
+    const NdArray<int, 3> d = iota(0, 4 * 5 * 6).reshape(Shape<3>({4, 5, 6}));
+    const std::vector views = {d["3:0:-1", "1:4", "::2"], d["1:", "::2", "1:4"], d[":3", "2:", "::-2"]};
+    std::vector<NdArray<int, 3>> copies;
+    for (const auto &view : views) {
+        copies.emplace_back(view);
+    }
+    for (index_t axis = 0; axis < 3; ++axis) {
+        ASSERT_TRUE((stack(views, axis) == stack(copies, axis)).all());
+    }
+    ASSERT_TRUE((concatenate(std::vector{views[0], views[0]}, 2) == concatenate(std::vector{copies[0], copies[0]}, 2))
+                    .all());
+
+    const NdArray<int, 2> e = iota(0, 600 * 600).reshape(Shape<2>({600, 600}));
+    set_num_threads(4);
+    const auto f = concatenate(std::vector{e[":", "::2"], e[":", "1::2"]}, 1);
+    set_num_threads(std::thread::hardware_concurrency());
+    const std::vector<NdArray<int, 2>> halves = {NdArray<int, 2>(e[":", "::2"]), NdArray<int, 2>(e[":", "1::2"])};
+    ASSERT_TRUE((f == concatenate(halves, 1)).all());
+}
+
+TEST(JoinTest, ConcatenateParallel) {
+    const NdArray<int, 1> a = iota(0, 100000);
+    const NdArray<int, 1> b = iota(100000, 250000);
+
+    set_num_threads(4);
+    const auto c = concatenate(std::vector{std::cref(a), std::cref(b)});
+    set_num_threads(std::thread::hardware_concurrency());
+
+    ASSERT_TRUE((c == iota(0, 250000)).all());
+}
+
+TEST(JoinTest, Stack) {
+    const NdArray<int, 1> a = {0, 1, 2};
+    const NdArray<int, 1> b = {3, 4, 5};
+    const NdArray<int, 2> c = {{0, 1, 2}, {3, 4, 5}};
+    const NdArray<int, 2> d = {{0, 3}, {1, 4}, {2, 5}};
+    const NdArray<int, 1> e = {0, 1, 2, 3, 4, 5};
+
+    ASSERT_TRUE((stack(std::vector{a, b}) == c).all());
+    ASSERT_TRUE((stack(std::vector{a, b}, 1) == d).all());
+    ASSERT_TRUE((vstack(std::vector{a, b}) == c).all());
+    ASSERT_TRUE((hstack(std::vector{a, b}) == e).all());
+    ASSERT_TRUE((hstack(std::vector{d, d}) == NdArray<int, 2>({{0, 3, 0, 3}, {1, 4, 1, 4}, {2, 5, 2, 5}})).all());
+}
+
+TEST(SplitTest, Split) {
+    NdArray<int, 2> a = {{0, 1, 2, 3}, {4, 5, 6, 7}};
+
+    auto parts = split(a, 2, 1);
+    parts[1].fill(-1);
+
+    ASSERT_EQ(parts.size(), 2);
+    ASSERT_TRUE((parts[0] == NdArray<int, 2>({{0, 1}, {4, 5}})).all());
+    ASSERT_TRUE((a == NdArray<int, 2>({{0, 1, -1, -1}, {4, 5, -1, -1}})).all());
+    EXPECT_ANY_THROW(split(a, 3, 1));
+}
+
+TEST(SplitTest, ArraySplit) {
+    const NdArray<int, 1> a = iota(0, 7);
+
+    const auto parts = array_split(a, 3);
+    const auto parts2 = split(a, {2, 3});
+
+    ASSERT_EQ(parts.size(), 3);
+    ASSERT_TRUE((parts[0] == NdArray<int, 1>({0, 1, 2})).all());
+    ASSERT_TRUE((parts[2] == NdArray<int, 1>({5, 6})).all());
+    ASSERT_EQ(parts2.size(), 3);
+    ASSERT_TRUE((parts2[1] == NdArray<int, 1>({2})).all());
+    ASSERT_TRUE((parts2[2] == NdArray<int, 1>({3, 4, 5, 6})).all());
+}
+
+TEST(SortTest, Sort) {
+    const NdArray<int, 2> a = {{3, 1, 2}, {0, 5, -4}};
+
+    ASSERT_TRUE((sort(a) == NdArray<int, 2>({{1, 2, 3}, {-4, 0, 5}})).all());
+    ASSERT_TRUE((sort(a, 0) == NdArray<int, 2>({{0, 1, -4}, {3, 5, 2}})).all());
+    ASSERT_TRUE((sort(a[":", "::-1"]) == NdArray<int, 2>({{1, 2, 3}, {-4, 0, 5}})).all());
+    EXPECT_ANY_THROW(sort(a, 2));
+}
+
+TEST(SortTest, SortRadix) {
+    NdArray<double, 1> a(Shape<1>({1000}));
+    for (index_t i = 0; i < 1000; ++i) {
+        a[i] = (i * 7919 % 1000) - 500.5;
+    }
+    a[10] = std::nan("");
+    a[20] = -0.0;
+
+    const NdArray<double, 1> b = sort(a);
+
+    ASSERT_TRUE(std::isnan(b[999]));
+    ASSERT_TRUE(std::is_sorted(b.data(), b.data() + 999));
+    ASSERT_EQ(b[0], -500.5);
+}
+
+TEST(SortTest, Argsort) {
+    const NdArray<int, 1> a = {2, 0, 1, 0, 2};
+    const NdArray<int, 2> b = {{3, 1}, {2, 4}};
+
+    ASSERT_TRUE((argsort(a) == NdArray<index_t, 1>({1, 3, 2, 0, 4})).all());
+    ASSERT_TRUE((argsort(b, 0) == NdArray<index_t, 2>({{1, 0}, {0, 1}})).all());
+}
+
+TEST(SortTest, SortParallel) {
+    NdArray<int, 1> a(Shape<1>({200000}));
+    for (index_t i = 0; i < 200000; ++i) {
+        a[i] = static_cast<int>(i * 7919 % 200000 / 2);
+    }
+
+    set_num_threads(4);
+    const NdArray<int, 1> b = sort(a);
+    const NdArray<index_t, 1> c = argsort(a);
+    set_num_threads(std::thread::hardware_concurrency());
+
+    ASSERT_TRUE(std::is_sorted(b.data(), b.data() + b.size()));
+    for (index_t i = 1; i < 200000; ++i) {
+        ASSERT_TRUE(a[c[i - 1]] < a[c[i]] || (a[c[i - 1]] == a[c[i]] && c[i - 1] < c[i]));
+    }
+}
+
+TEST(SortTest, Partition) {
+    const NdArray<int, 1> a = {5, 3, 8, 1, 9, 2};
+
+    const NdArray<int, 1> b = partition(a, 2);
+    const NdArray<index_t, 1> c = argpartition(a, -1);
+
+    ASSERT_EQ(b[2], 3);
+    ASSERT_TRUE(b[0] <= 3 && b[1] <= 3 && b[3] >= 3 && b[4] >= 3 && b[5] >= 3);
+    ASSERT_EQ(c[5], 4);
+    EXPECT_ANY_THROW(partition(a, 6));
+}
+
+TEST(SortTest, Topk) {
+    const NdArray<int, 2> a = {{5, 3, 8, 1}, {9, 2, 9, 0}};
+
+    const auto [values, indices] = topk(a, 2);
+    const auto [min_values, min_indices] = topk(a, 1, 0, false);
+
+    ASSERT_TRUE((values == NdArray<int, 2>({{8, 5}, {9, 9}})).all());
+    ASSERT_TRUE((indices == NdArray<index_t, 2>({{2, 0}, {0, 2}})).all());
+    ASSERT_TRUE((min_values == NdArray<int, 2>({{5, 2, 8, 0}})).all());
+    ASSERT_TRUE((min_indices == NdArray<index_t, 2>({{0, 1, 0, 1}})).all());
+}
+
+TEST(ScanTest, Cumulative) {
+    const NdArray<int, 2> a = {{1, 2, 3}, {4, 5, 6}};
+
+    ASSERT_TRUE((cumsum(a) == NdArray<int, 2>({{1, 3, 6}, {4, 9, 15}})).all());
+    ASSERT_TRUE((cumsum(a, 0) == NdArray<int, 2>({{1, 2, 3}, {5, 7, 9}})).all());
+    ASSERT_TRUE((cumprod(a[":", "::-1"]) == NdArray<int, 2>({{3, 6, 6}, {6, 30, 120}})).all());
+    ASSERT_TRUE((cummax(NdArray<int, 1>({1, 3, 2, 5, 4})) == NdArray<int, 1>({1, 3, 3, 5, 5})).all());
+    ASSERT_TRUE((cummin(NdArray<int, 1>({4, 5, 2, 3, 1})) == NdArray<int, 1>({4, 4, 2, 2, 1})).all());
+
+    const NdArray<double, 1> b = cummax(NdArray<double, 1>({1.0, std::nan(""), 2.0}));
+    ASSERT_EQ(b[0], 1.0);
+    ASSERT_TRUE(std::isnan(b[1]) && std::isnan(b[2]));
+}
+
+TEST(ScanTest, CumulativeParallel) {
+    const NdArray<int, 1> a = iota(0, 200000) % 7;
+    NdArray<int, 2> b(Shape<2>({100000, 3}));
+    for (index_t i = 0; i < 100000; ++i) {
+        b[i, 0] = 1;
+        b[i, 1] = static_cast<int>(i % 5);
+        b[i, 2] = -static_cast<int>(i % 3);
+    }
+
+    set_num_threads(4);
+    const NdArray<int, 1> c = cumsum(a);
+    const NdArray<int, 2> d = cumsum(b, 0);
+    set_num_threads(std::thread::hardware_concurrency());
+
+    int total = 0;
+    for (index_t i = 0; i < 200000; ++i) {
+        total += a[i];
+        ASSERT_EQ(c[i], total);
+    }
+    std::array<int, 3> totals = {};
+    for (index_t i = 0; i < 100000; ++i) {
+        for (index_t j = 0; j < 3; ++j) {
+            totals[j] += b[i, j];
+            ASSERT_EQ((d[i, j]), totals[j]);
+        }
+    }
+}
+
+TEST(ReduceTest, Reduce) {
+    const NdArray<int, 2> a = {{1, 2, 3}, {4, 5, 6}};
+    NdArray<int, 2> f(Shape<2>({2, 3}), Order::F);
+    f[":", ":"] = a;
+
+    ASSERT_TRUE((reduce(std::plus<int>(), a, 0) == NdArray<int, 1>({5, 7, 9})).all());
+    ASSERT_TRUE((reduce(std::plus<int>(), a, -1) == NdArray<int, 1>({6, 15})).all());
+    ASSERT_TRUE((reduce(std::multiplies<>(), f, 1) == NdArray<int, 1>({6, 120})).all());
+    ASSERT_TRUE((reduce(util::scan_max<int>(), a[":", "::-2"], 0) == NdArray<int, 1>({6, 4})).all());
+    ASSERT_EQ(reduce(std::plus<int>(), a), 21);
+    ASSERT_EQ(reduce(std::plus<std::string>(), NdArray<std::string, 1>({"a", "b", "c"})), "abc");
+
+    ASSERT_TRUE((accumulate(std::plus<int>(), a, 0) == cumsum(a, 0)).all());
+    EXPECT_THROW(reduce(std::plus<int>(), NdArray<int, 2>(Shape<2>({2, 0})), 1), std::invalid_argument);
+    ASSERT_EQ(reduce(std::plus<int>(), NdArray<int, 2>(Shape<2>({0, 2})), 1).size(), 0);
+}
+
+TEST(ReduceTest, Reduceat) {
+    const NdArray<int, 1> x = iota(0, 8);
+    const NdArray<int, 1> indices = {0, 4, 1, 5, 5, 2, 6, 7};
+    ASSERT_TRUE((reduceat(std::plus<int>(), x, indices) == NdArray<int, 1>({6, 4, 10, 5, 5, 14, 6, 7})).all());
+
+    const NdArray<int, 2> a = {{1, 2}, {3, 4}, {5, 6}, {7, 8}};
+    const NdArray<index_t, 1> starts = {0, 1, 3};
+    ASSERT_TRUE((reduceat(std::plus<int>(), a, starts, 0) == NdArray<int, 2>({{1, 2}, {8, 10}, {7, 8}})).all());
+    ASSERT_TRUE((reduceat(std::multiplies<int>(), a, NdArray<int, 1>({1}), 1) == NdArray<int, 2>({{2}, {4}, {6}, {8}}))
+                    .all());
+    EXPECT_THROW(reduceat(std::plus<int>(), a, NdArray<int, 1>({4}), 0), std::out_of_range);
+}
+
+TEST(ReduceTest, ReduceParallel) {
+    const NdArray<int, 1> a = iota(0, 200000) % 7;
+    NdArray<double, 2> b(Shape<2>({100000, 3}));
+    for (index_t i = 0; i < b.size(); ++i) {
+        b.item(i) = 1.0 / static_cast<double>(i + 1);
+    }
+
+    set_num_threads(4);
+    const int total = reduce(std::plus<int>(), a);
+    const int last = reduce([](int, int y) { return y; }, a);
+    const NdArray<double, 1> sums = reduce(std::plus<double>(), b, 0);
+    const NdArray<double, 1> again = reduce(std::plus<double>(), b, 0);
+    set_num_threads(std::thread::hardware_concurrency());
+
+    int expected = 0;
+    for (index_t i = 0; i < a.size(); ++i) {
+        expected += a[i];
+    }
+    ASSERT_EQ(total, expected);
+    ASSERT_EQ(last, a[a.size() - 1]);
+    for (index_t j = 0; j < 3; ++j) {
+        double serial = 0;
+        for (index_t i = 0; i < 100000; ++i) {
+            serial += b[i, j];
+        }
+        ASSERT_EQ(sums[j], again[j]);
+        ASSERT_NEAR(sums[j], serial, 1e-9);
+    }
+}
+
+#ifdef __cpp_lib_mdspan
+TEST(MdspanTest, Export) {
+    NdArray<int, 2> a = {{0, 1, 2}, {3, 4, 5}};
+
+    auto span = to_mdspan(a);
+    auto column = to_mdspan(a[":", 1]);
+    span[1, 2] = -1;
+
+    ASSERT_EQ(span.extent(0), 2);
+    ASSERT_EQ(span.extent(1), 3);
+    ASSERT_EQ((column[1]), 4);
+    ASSERT_EQ(column.stride(0), 3);
+    ASSERT_EQ((a[1, 2]), -1);
+    EXPECT_ANY_THROW(to_mdspan(a[":", "::-1"]));
+
+    const std::array<int, 6> column_major = {0, 3, 1, 4, 2, -1};
+    const NdArray<int, 2> f(Shape<2>({2, 3}), column_major.data(), Order::F);
+    auto fortran = to_mdspan(f);
+
+    ASSERT_EQ(fortran.stride(0), 1);
+    ASSERT_EQ(fortran.stride(1), 2);
+    ASSERT_EQ((fortran[1, 2]), -1);
+    ASSERT_EQ((fortran[0, 1]), 1);
+
+    /* Unused strides of empty arrays and of axes of length 1 are made positive; broadcast axes are rejected. */
+    NdArray<int, 2> empty(Shape<2>({3, 0}));
+    auto empty_span = to_mdspan(empty);
+    const NdArray<int, 2> row = {{1, 2, 3}};
+
+    ASSERT_EQ(empty_span.extent(0), 3);
+    ASSERT_GT(empty_span.stride(0), 0);
+    ASSERT_EQ(to_mdspan(broadcast_to(row, Shape<2>({1, 3}))).stride(0), 3);
+    EXPECT_ANY_THROW(to_mdspan(broadcast_to(row, Shape<2>({4, 3}))));
+}
+
+TEST(MdspanTest, Import) {
+    std::array<double, 6> buffer = {0, 1, 2, 3, 4, 5};
+    std::mdspan<double, std::dextents<index_t, 2>> span(buffer.data(), 2, 3);
+
+    auto view = from_mdspan(span);
+    view[":", 0] = NdArray<double, 1>({-1, -2});
+
+    ASSERT_TRUE((view + 1 == NdArray<double, 2>({{0, 2, 3}, {-1, 5, 6}})).all());
+    ASSERT_EQ(buffer[3], -2);
+}
+#endif
+
+TEST(LazyTest, Eval) {
+    NdArray<double, 2> a({{1, 2, 3}, {4, 5, 6}});
+    NdArray<double, 2> b({{6, 5, 4}, {3, 2, 1}});
+
+    auto x = lazy(a);
+    auto y = lazy(b);
+    NdArray<double, 2> result = ((x + y) * 2.0 - x / y + (-x)).eval();
+    ASSERT_TRUE((result == (a + b) * 2.0 - a / b - a).all());
+
+    ASSERT_TRUE((lazy(a).eval() == a).all());
+    ASSERT_TRUE(((1.0 - lazy(a[Slice(0, 2), Slice(1, 3)])).eval() == 1.0 - a[Slice(0, 2), Slice(1, 3)]).all());
+    ASSERT_THROW(lazy(a) + lazy(NdArray<double, 2>(Shape<2>({3, 2}))), std::invalid_argument);
+
+    /* Temporaries are kept alive until the evaluation, whether stored inline or on the heap. */
+    auto t = lazy(a * 2.0) + lazy(a);
+    ASSERT_TRUE((t.eval() == a * 3.0).all());
+    NdArray<double, 2> large(Shape<2>({100, 100}));
+    large.fill(1.0);
+    auto u = lazy(large + 1.0) * lazy(large.reshape(Shape<2>({100, 100}), Order::F));
+    ASSERT_TRUE((u.eval() == 2.0).all());
+}
+
+TEST(LazyTest, Optimize) {
+    NdArray<float, 1> a(Shape<1>({5000}));
+    NdArray<float, 1> b(Shape<1>({5000}));
+    for (index_t i = 0; i < 5000; ++i) {
+        a[i] = static_cast<float>(i);
+        b[i] = static_cast<float>(i % 7);
+    }
+
+    /* a + b and b + a are the same subexpression. */
+    auto x = lazy(a);
+    auto y = lazy(b);
+    auto s = (x + y) * (y + x);
+    auto t = (x + y) * 2.0f;
+    auto program = util::compile_lazy<float, 1>({s.node(), t.node()});
+    ASSERT_EQ(program.inputs.size(), 2);
+    ASSERT_EQ(program.instructions.size(), 3);
+    ASSERT_EQ(program.num_slots, 1);
+
+    /* A long chain only needs one scratch slot. */
+    auto chain = x;
+    for (int i = 0; i < 10; ++i) {
+        chain = chain * 2.0f + y;
+    }
+    ASSERT_EQ((util::compile_lazy<float, 1>({chain.node()}).num_slots), 1);
+
+    auto [u, v, w] = eval(s, t, s);
+    ASSERT_TRUE((u == (a + b) * (a + b)).all());
+    ASSERT_TRUE((v == (a + b) * 2.0f).all());
+    ASSERT_TRUE((w == u).all());
+
+    NdArray<float, 1> expected = a;
+    for (int i = 0; i < 10; ++i) {
+        expected = expected * 2.0f + b;
+    }
+    ASSERT_TRUE((chain.eval() == expected).all());
+}
+
+TEST(LazyTest, ShapeMismatch) {
+    const NdArray<double, 1> small = {1, 2, 3, 4};
+    const NdArray<double, 1> large(Shape<1>({100000}));
+
+    EXPECT_THROW(eval(lazy(small) + 1.0, lazy(large) * 3.0), std::invalid_argument);
+    EXPECT_THROW(eval(lazy(large) * 3.0, lazy(small) + 1.0), std::invalid_argument);
+    EXPECT_THROW((util::compile_lazy<double, 1>({lazy(small).node(), lazy(large).node()})), std::invalid_argument);
+}
+
+TEST(FactoryTest, Ranges) {
+    ASSERT_TRUE((arange<int>(5) == NdArray<int, 1>({0, 1, 2, 3, 4})).all());
+    ASSERT_TRUE((arange<double>(1.0, 4.0) == NdArray<double, 1>({1, 2, 3})).all());
+    ASSERT_TRUE((arange<int>(5, -2, -3) == NdArray<int, 1>({5, 2, -1})).all());
+    ASSERT_EQ(arange<int>(3, 1, 1).size(), 0);
+    ASSERT_TRUE((arange<int>(100000) == iota(0, 100000)).all());
+
+    ASSERT_TRUE((linspace(0, 1, 5) == NdArray<double, 1>({0, 0.25, 0.5, 0.75, 1})).all());
+    ASSERT_TRUE((linspace<float>(0, 1, 4, false) == NdArray<float, 1>({0, 0.25f, 0.5f, 0.75f})).all());
+    ASSERT_EQ(linspace(0.1, 0.7, 100001)[-1], 0.7);
+    ASSERT_THROW(linspace(0, 1, -1), std::invalid_argument);
+    ASSERT_TRUE((logspace(0, 3, 4) == NdArray<double, 1>({1, 10, 100, 1000})).all());
+    ASSERT_TRUE((logspace(0, 2, 3, true, 2) == NdArray<double, 1>({1, 2, 4})).all());
+}
+
+TEST(FactoryTest, Filled) {
+    ASSERT_TRUE((full(Shape<2>({2, 3}), 7) == NdArray<int, 2>({{7, 7, 7}, {7, 7, 7}})).all());
+    ASSERT_TRUE((full<float>(Shape<1>({100000}), 0.5) == 0.5f).all());
+    ASSERT_TRUE((ones<int>(Shape<2>({1, 2})) == NdArray<int, 2>({{1, 1}})).all());
+    ASSERT_TRUE((eye<int>(3) == NdArray<int, 2>({{1, 0, 0}, {0, 1, 0}, {0, 0, 1}})).all());
+    ASSERT_TRUE((eye<int>(2, 4, 1) == NdArray<int, 2>({{0, 1, 0, 0}, {0, 0, 1, 0}})).all());
+    ASSERT_TRUE((eye<int>(3, 2, -1) == NdArray<int, 2>({{0, 0}, {1, 0}, {0, 1}})).all());
+
+    const NdArray<double, 2> f(Shape<2>({2, 3}), Order::F);
+    const NdArray<double, 2> z = zeros_like(f);
+    ASSERT_EQ(z.shape(), f.shape());
+    ASSERT_EQ(z.order(), Order::F);
+    ASSERT_TRUE((z == 0.0).all());
+    ASSERT_TRUE((ones_like(f[":", "::2"]) == NdArray<double, 2>({{1, 1}, {1, 1}})).all());
+    ASSERT_TRUE((full_like(f, 2.5) == 2.5).all());
+    ASSERT_EQ(empty_like(f).shape(), f.shape());
+}
+
+TEST(FactoryTest, Grids) {
+    const NdArray<int, 1> x = {0, 1, 2};
+    const NdArray<double, 1> y = {10, 20};
+
+    const auto [gx, gy] = meshgrid(x, y);
+    ASSERT_EQ(gx.shape(), Shape<2>({2, 3}));
+    ASSERT_EQ(gx.strides(), (std::array<index_t, 2>{0, 1}));
+    ASSERT_TRUE((gx == NdArray<int, 2>({{0, 1, 2}, {0, 1, 2}})).all());
+    ASSERT_TRUE((gy == NdArray<double, 2>({{10, 10, 10}, {20, 20, 20}})).all());
+    ASSERT_TRUE((gx * gy == NdArray<double, 2>({{0, 10, 20}, {0, 20, 40}})).all());
+
+    const auto [ix, iy, iz] = meshgrid(Indexing::ij, x, y, x["::-1"]);
+    ASSERT_EQ(ix.shape(), Shape<3>({3, 2, 3}));
+    ASSERT_EQ((iz[1, 1, 0]), 2);
+    ASSERT_TRUE((NdArray<double, 3>(iy)[":", 1, ":"] == 20.0).all());
+
+    const auto [rows, cols] = indices(Shape<2>({2, 3}));
+    ASSERT_TRUE((rows == NdArray<index_t, 2>({{0, 0, 0}, {1, 1, 1}})).all());
+    ASSERT_TRUE((cols == NdArray<index_t, 2>({{0, 1, 2}, {0, 1, 2}})).all());
+    ASSERT_TRUE((rows * 3 + cols == arange<index_t>(6).reshape(Shape<2>({2, 3}))).all());
+}
+
+TEST(PerfTest, Measure) {
+    PerfCounters counters;
+    const NdArray<double, 1> a = full(Shape<1>({1 << 20}), 1.0);
+    NdArray<double, 1> b(a.shape());
+
+    const PerfSample sample = counters.measure([&]() { b = a * 2.0 + 1.0; }, 2 * a.nbytes());
+    ASSERT_TRUE((b == 3.0).all());
+    ASSERT_GT(sample.seconds, 0);
+    ASSERT_GT(sample.bandwidth(), 0);
+    ASSERT_EQ(sample.cycles.has_value() && sample.instructions.has_value(), sample.ipc().has_value());
+    if (counters.available() && sample.instructions) {
+        ASSERT_GT(*sample.instructions, static_cast<std::uint64_t>(a.size()));
+    }
+
+    const double stream = stream_bandwidth(1 << 20, 2);
+    ASSERT_GT(stream, 0);
+    ASSERT_NE(sample.to_string(stream).find("% of STREAM"), std::string::npos);
+}
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <filesystem>
+#include <numeric>
+#include <sstream>
+
+#include "../include/ndarray.hpp"
+
+using namespace ndarray;
+
+template <typename T, std::size_t Dim, typename Derived>
+static std::string saved(const NdArrayBase<T, Dim, Derived> &arr, const Compression &compression = Compression()) {
+    std::ostringstream os;
+    save(os, arr, compression);
+    return os.str();
+}
+
+template <typename T, std::size_t Dim>
+static NdArray<T, Dim> loaded(const std::string &bytes) {
+    std::istringstream is(bytes);
+    return load<T, Dim>(is);
+}
+
+TEST(IoTest, Codec) {
+    std::vector<std::uint8_t> input(100000);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        input[i] = static_cast<std::uint8_t>(i % 7 == 0 ? i / 7 : i % 3);
+    }
+
+    std::vector<std::uint8_t> compressed;
+    ASSERT_TRUE(util::lz_compress(input.data(), input.size(), compressed));
+    ASSERT_LT(compressed.size(), input.size() / 3);
+    std::vector<std::uint8_t> output(input.size());
+    util::lz_decompress(compressed.data(), compressed.size(), output.data(), output.size());
+    ASSERT_EQ(output, input);
+
+    /* Runs are encoded as matches overlapping their own output. */
+    const std::vector<std::uint8_t> run(1000, 42);
+    ASSERT_TRUE(util::lz_compress(run.data(), run.size(), compressed));
+    ASSERT_LT(compressed.size(), 16u);
+    util::lz_decompress(compressed.data(), compressed.size(), output.data(), run.size());
+    ASSERT_TRUE(std::equal(run.begin(), run.end(), output.begin()));
+
+    const std::vector<std::uint8_t> tiny = {1, 2, 3};
+    ASSERT_FALSE(util::lz_compress(tiny.data(), tiny.size(), compressed));
+
+    compressed[0] = 0x0F;
+    ASSERT_THROW(util::lz_decompress(compressed.data(), 1, output.data(), 10), std::runtime_error);
+    const std::vector<std::uint8_t> bad_offset = {0x10, 'a', 0x05, 0x00};
+    ASSERT_THROW(util::lz_decompress(bad_offset.data(), bad_offset.size(), output.data(), 10), std::runtime_error);
+}
+
+TEST(IoTest, RoundTrip) {
+    NdArray<int, 2> labels(Shape<2>({300, 500}));
+    for (index_t i = 0; i < labels.size(); ++i) {
+        labels.data()[i] = static_cast<int>((i / 1000) % 5);
+    }
+    const std::string label_bytes = saved(labels, {.chunk_bytes = 1 << 16});
+    ASSERT_LT(label_bytes.size(), labels.nbytes() / 10);
+    ASSERT_TRUE((loaded<int, 2>(label_bytes) == labels).all());
+
+    NdArray<float, 1> field(Shape<1>({200000}));
+    for (index_t i = 0; i < field.size(); ++i) {
+        field.data()[i] = std::sin(static_cast<float>(i) * 1e-4f);
+    }
+    const std::string shuffled = saved(field);
+    const std::string field_bytes = saved(field, {.delta = true, .shuffle = true});
+    ASSERT_LT(field_bytes.size(), shuffled.size());
+    ASSERT_LT(field_bytes.size(), field.nbytes() / 3);
+    ASSERT_TRUE((loaded<float, 1>(field_bytes) == field).all());
+    ASSERT_TRUE((loaded<float, 1>(saved(field, {.shuffle = false})) == field).all());
+
+    /* Slices are saved in C order and Fortran-ordered arrays in their own order. */
+    const NdArray<int, 2> sub = labels["::7", "3:100:2"];
+    ASSERT_TRUE((loaded<int, 2>(saved(labels["::7", "3:100:2"])) == sub).all());
+    const NdArray<float, 2> fortran = NdArray<float, 2>({{1, 2, 3}, {4, 5, 6}}).reshape(Shape<2>({2, 3}), Order::F);
+    const NdArray<float, 2> restored = loaded<float, 2>(saved(fortran, {.delta = true}));
+    ASSERT_EQ(restored.order(), Order::F);
+    ASSERT_TRUE((restored == fortran).all());
+
+    const NdArray<bool, 1> flags = {true, false, false, true};
+    ASSERT_TRUE((loaded<bool, 1>(saved(flags)) == flags).all());
+}
+
+TEST(IoTest, Deterministic) {
+    const NdArray<float, 3> a = random::Generator(1).uniform<float>(Shape<3>({64, 64, 64}));
+    const std::size_t num_threads = get_num_threads();
+
+    set_num_threads(1);
+    const std::string serial = saved(a, {.chunk_bytes = 1 << 14});
+    set_num_threads(6);
+    const std::string parallel = saved(a, {.chunk_bytes = 1 << 14});
+    set_num_threads(num_threads);
+
+    ASSERT_EQ(serial, parallel);
+    ASSERT_TRUE((loaded<float, 3>(parallel) == a).all());
+}
+
+TEST(IoTest, Errors) {
+    const NdArray<std::int16_t, 1> a = {1, 2, 3};
+    const std::string bytes = saved(a);
+
+    ASSERT_THROW((loaded<std::uint16_t, 1>(bytes)), std::runtime_error);
+    ASSERT_THROW((loaded<std::int16_t, 2>(bytes)), std::runtime_error);
+    ASSERT_THROW((loaded<std::int16_t, 1>(bytes.substr(0, bytes.size() - 1))), std::runtime_error);
+    ASSERT_THROW((loaded<std::int16_t, 1>("not an array")), std::runtime_error);
+
+    const NdArray<std::array<char, 3>, 1> triples(Shape<1>({4}));
+    ASSERT_THROW(saved(triples, {.delta = true}), std::invalid_argument);
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "ndarray-io-test.ndz";
+    save(path.string(), a);
+    ASSERT_TRUE((load<std::int16_t, 1>(path.string()) == a).all());
+    std::filesystem::remove(path);
+    ASSERT_THROW((load<std::int16_t, 1>(path.string())), std::runtime_error);
+}
+
+class StoreTest : public ::testing::Test {
+protected:
+    void SetUp(void) override {
+        const std::string name = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        this->path = std::filesystem::temp_directory_path() / std::format("ndarray-store-test-{}", name);
+        std::filesystem::remove_all(this->path);
+    }
+
+    void TearDown(void) override {
+        std::filesystem::remove_all(this->path);
+    }
+
+    std::filesystem::path path;
+};
+
+TEST_F(StoreTest, ReadWrite) {
+    NdArray<int, 3> a(Shape<3>({20, 30, 17}));
+    std::iota(a.data(), a.data() + a.size(), 0);
+
+    auto store = ChunkedStore<int, 3>::create(this->path, a.shape(), Shape<3>({8, 8, 8}), {.delta = true});
+    ASSERT_TRUE((store.read() == 0).all());
+    store.write(a);
+
+    /* Only the chunks holding a selection are needed to read it. */
+    std::filesystem::remove(store.chunk_path({0, 0, 0}));
+    std::filesystem::remove(store.chunk_path({2, 3, 2}));
+    const NdArray<int, 2> region = store.read(12, "9:28:3", Slice(16, 7, -2));
+    ASSERT_TRUE((region == a[12, "9:28:3", Slice(16, 7, -2)]).all());
+    ASSERT_TRUE((store.read(Slice(-1, 0, -5), 5, -1) == a[Slice(-1, 0, -5), 5, -1]).all());
+    ASSERT_THROW(store.read(20), std::out_of_range);
+
+    const auto reopened = ChunkedStore<int, 3>::open(this->path);
+    ASSERT_EQ(reopened.shape(), a.shape());
+    ASSERT_EQ(reopened.chunk_shape(), Shape<3>({8, 8, 8}));
+    ASSERT_TRUE((reopened.read(":8", ":8", ":8") == 0).all());
+    ASSERT_TRUE((reopened.read("8:16", "8:") == a["8:16", "8:"]).all());
+    ASSERT_TRUE((reopened.read("16:", "24:", 16) == 0).all());
+    ASSERT_THROW((ChunkedStore<float, 3>::open(this->path)), std::runtime_error);
+    ASSERT_THROW((ChunkedStore<int, 3>::create(this->path, a.shape(), a.shape())), std::runtime_error);
+}
+
+TEST_F(StoreTest, PartialWrite) {
+    auto store = ChunkedStore<double, 2>::create(this->path, Shape<2>({100, 100}), Shape<2>({32, 16}));
+    NdArray<double, 2> expected = zeros<double>(Shape<2>({100, 100}));
+
+    const NdArray<double, 2> block = full(Shape<2>({10, 40}), 1.5);
+    store.write(block, "5:15", "30:70");
+    expected["5:15", "30:70"] = block;
+
+    const NdArray<double, 2> f = NdArray<double, 2>({{1, 2}, {3, 4}, {5, 6}}).reshape(Shape<2>({3, 2}), Order::F);
+    store.write(f, "::40", Slice(99, 90, -8));
+    expected["::40", Slice(99, 90, -8)] = f;
+    store.write(expected[50, ":"], 50);
+    store.write(NdArray<double, 1>({7, 8}), 60, "::99");
+    expected[60, "::99"] = NdArray<double, 1>({7, 8});
+
+    ASSERT_TRUE((store.read() == expected).all());
+    ASSERT_FALSE(std::filesystem::exists(store.chunk_path({3, 0})));
+    ASSERT_THROW(store.write(block, "5:15", "30:60"), std::invalid_argument);
+}
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <numeric>
+#include <thread>
+
 #include "../include/ndarray.hpp"
 
 using namespace ndarray;
@@ -122,3 +125,246 @@ TEST(NdArrayMethodTest, ToVector2) {
 
     ASSERT_EQ((a[":", "1:3", "1:3"]).to_vector(), v);
 }
+
+TEST(NdArrayMethodTest, SmallBuffer) {
+    const auto is_inline = [](const auto &arr) {
+        const auto *begin = reinterpret_cast<const std::byte *>(&arr);
+        const auto *data = reinterpret_cast<const std::byte *>(arr.data());
+        return data >= begin && data < begin + sizeof(arr);
+    };
+
+    NdArray<int, 2> a = {{0, 1, 2}, {3, 4, 5}};
+    NdArray<int, 2> b = zeros<int>(Shape<2>({100, 100}));
+    const NdArray<int, 2> c = a;
+
+    ASSERT_TRUE(is_inline(a));
+    ASSERT_FALSE(is_inline(b));
+
+    NdArray<int, 2> d = std::move(a);
+    NdArray<int, 2> e = std::move(b);
+
+    ASSERT_TRUE(is_inline(d));
+    ASSERT_FALSE(is_inline(e));
+    ASSERT_TRUE((d == c).all());
+    ASSERT_EQ(e.shape(), Shape<2>({100, 100}));
+
+    e = d;
+    d = zeros<int>(Shape<2>({2, 3}));
+
+    ASSERT_TRUE(is_inline(e));
+    ASSERT_TRUE((e == c).all());
+    ASSERT_FALSE(d.any());
+}
+
+TEST(NdArrayMethodTest, Adopt) {
+    int *buffer = new int[6]{0, 1, 2, 3, 4, 5};
+    bool released = false;
+
+    {
+        NdArray<int, 2> a = NdArray<int, 2>::adopt(Shape<2>({2, 3}), buffer, [&released](int *ptr) {
+            released = true;
+            delete[] ptr;
+        });
+        NdArray<int, 2> b = std::move(a);
+        const NdArray<int, 2> c = b;
+
+        ASSERT_EQ(b.data(), buffer);
+        ASSERT_NE(c.data(), buffer);
+        ASSERT_EQ((b[1, 2]), 5);
+        ASSERT_FALSE(released);
+    }
+
+    ASSERT_TRUE(released);
+}
+
+TEST(NdArrayMethodTest, Borrow) {
+    auto buffer = std::make_shared<std::vector<double>>(std::vector<double>{0, 1, 2, 3});
+
+    NdArray<double, 1> a = NdArray<double, 1>::borrow(Shape<1>({4}), buffer->data(), buffer);
+    std::weak_ptr<std::vector<double>> weak = buffer;
+    buffer.reset();
+
+    a["1:3"] = -1.0;
+    ASSERT_FALSE(weak.expired());
+    ASSERT_EQ((*weak.lock())[1], -1.0);
+
+    /* Same-size assignments write into the buffer, by copy or by move. */
+    const NdArray<double, 1> b = {4, 5, 6, 7};
+    const double *data = a.data();
+    a = b;
+    ASSERT_EQ(a.data(), data);
+    ASSERT_EQ((*weak.lock())[0], 4);
+    a = NdArray<double, 1>({8, 9, 10, 11});
+    ASSERT_EQ(a.data(), data);
+    ASSERT_EQ((*weak.lock())[3], 11);
+    NdArray<double, 1> c = {-1, -2, -3, -4};
+    a = std::move(c);
+    ASSERT_EQ(a.data(), data);
+    ASSERT_EQ((*weak.lock())[2], -3);
+
+    a = NdArray<double, 1>({1, 2});
+    ASSERT_TRUE(weak.expired());
+}
+
+/* Element type whose construction fails on demand, so that an allocation throws. */
+class ThrowingElement {
+public:
+    static inline bool fail = false;
+
+    ThrowingElement(void) {
+        if (fail) {
+            throw std::runtime_error("construction failed");
+        }
+    }
+
+    int value = 0;
+};
+
+TEST(NdArrayMethodTest, AssignFailure) {
+    NdArray<ThrowingElement, 1> a(Shape<1>({4}));
+    const NdArray<ThrowingElement, 1> b(Shape<1>({8}));
+    a[2].value = 7;
+
+    ThrowingElement::fail = true;
+    ASSERT_THROW(a = b, std::runtime_error);
+    ThrowingElement::fail = false;
+
+    ASSERT_EQ(a.shape(), Shape<1>({4}));
+    ASSERT_EQ(a[2].value, 7);
+    a = b;
+    ASSERT_EQ(a.size(), 8);
+}
+
+TEST(NdArrayMethodTest, FortranOrder) {
+    /* Column-major storage of {{0, 1, 2}, {3, 4, 5}}. */
+    const int column_major[] = {0, 3, 1, 4, 2, 5};
+    const NdArray<int, 2> c = {{0, 1, 2}, {3, 4, 5}};
+    NdArray<int, 2> f(Shape<2>({2, 3}), column_major, Order::F);
+
+    ASSERT_EQ(f.order(), Order::F);
+    ASSERT_EQ(f.strides(), (std::array<index_t, 2>{1, 2}));
+    ASSERT_EQ((f[1, 0]), 3);
+    ASSERT_EQ(f.item(1), 1);
+    ASSERT_EQ(f.to_string(), c.to_string());
+    ASSERT_TRUE((f == c).all());
+    ASSERT_TRUE((f[":", 1] == c[":", 1]).all());
+
+    f[0, 2] = -2;
+    ASSERT_EQ(f.data()[4], -2);
+    f[0, 2] = 2;
+
+    ASSERT_TRUE((f.flatten() == NdArray<int, 1>({0, 1, 2, 3, 4, 5})).all());
+    ASSERT_TRUE((f.flatten(Order::F) == NdArray<int, 1>({0, 3, 1, 4, 2, 5})).all());
+    ASSERT_TRUE((f.reshape(Shape<2>({3, 2})) == c.reshape(Shape<2>({3, 2}))).all());
+    const NdArray<int, 2> g = f.reshape(Shape<2>({3, 2}), Order::F);
+    ASSERT_EQ(g.order(), Order::F);
+    ASSERT_TRUE(std::equal(g.data(), g.data() + 6, column_major));
+    ASSERT_EQ((NdArray<int, 1>(Shape<1>({3}), Order::F).order()), Order::C);
+
+    /* Nested initializer lists read Fortran-ordered sub-arrays by index. */
+    const NdArray<int, 3> nested = {f, f};
+    ASSERT_TRUE((nested[0] == c).all());
+    ASSERT_TRUE((nested[1] == c).all());
+}
+
+TEST(NdArrayMethodTest, FortranOrderOperations) {
+    const NdArray<double, 2> c = {{0, 1, 2}, {3, 4, 5}};
+    const NdArray<double, 2> f = c.reshape(Shape<2>({2, 3}), Order::F);
+    ASSERT_EQ(f.order(), Order::F);
+
+    /* Fortran-ordered operands give a Fortran-ordered result; mixed operands give a C-ordered one. */
+    const NdArray<double, 2> ff = f * 2 + f;
+    const NdArray<double, 2> fc = f + c;
+    ASSERT_EQ(ff.order(), Order::F);
+    ASSERT_EQ(fc.order(), Order::C);
+    ASSERT_TRUE((ff == c * 3).all());
+    ASSERT_TRUE((fc == c * 2).all());
+    ASSERT_EQ(ff.as_type<int>().order(), Order::F);
+
+    NdArray<double, 2> h = f;
+    h += c;
+    h -= c["::-1", ":"];
+    ASSERT_EQ(h.order(), Order::F);
+    ASSERT_TRUE((h == c * 2 - c["::-1", ":"]).all());
+
+    ASSERT_TRUE((concatenate(std::vector{f, c}, 1) == concatenate(std::vector{c, c}, 1)).all());
+    ASSERT_TRUE((cumsum(f, 0) == cumsum(c, 0)).all());
+    ASSERT_TRUE((sort(f["::-1", ":"]) == c["::-1", ":"]).all());
+    ASSERT_TRUE(((lazy(f) * 2.0).eval() == c * 2).all());
+
+    std::vector<double> buffer = {0, 3, 1, 4, 2, 5};
+    NdArray<double, 2> borrowed = NdArray<double, 2>::borrow(Shape<2>({2, 3}), buffer.data(), Order::F);
+    borrowed = c * 10;
+    ASSERT_EQ(buffer[1], 30);
+}
+
+TEST(NdArrayMethodTest, MemoryPolicy) {
+    const MemoryPolicy saved = get_memory_policy();
+    const Shape<2> shape({512, 1024});
+
+    for (NumaPolicy numa : {NumaPolicy::local, NumaPolicy::interleave, NumaPolicy::first_touch}) {
+        set_memory_policy(MemoryPolicy{numa, 1 << 20});
+        NdArray<double, 2> a(shape);
+        a = 1.5;
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(a.data()) % 4096, 0u);
+
+        const NdArray<double, 2> b = a * 2.0;
+        ASSERT_TRUE((b == 3.0).all());
+
+        /* Every page has been written, so every page has a node. */
+        const std::vector<int> nodes = numa_nodes(a);
+        ASSERT_FALSE(nodes.empty());
+        ASSERT_TRUE(std::all_of(nodes.begin(), nodes.end(), [](int node) { return node >= 0; }));
+    }
+    set_memory_policy(saved);
+
+    NdArray<float, 1> c = NdArray<float, 1>::with_policy(Shape<1>({1 << 20}), MemoryPolicy{NumaPolicy::first_touch, 0});
+    ASSERT_TRUE((c == 0.0f).all());
+    NdArray<float, 1> d = std::move(c);
+    numa_bind(d, 0);
+    ASSERT_TRUE((d == 0.0f).all());
+    ASSERT_THROW(numa_bind(d, -1), std::out_of_range);
+
+    ASSERT_GE(numa_num_nodes(), 1u);
+
+    /* The global policy may be changed while other threads allocate. */
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t]() {
+            for (int i = 0; i < 50; ++i) {
+                set_memory_policy(MemoryPolicy{t % 2 == 0 ? NumaPolicy::none : NumaPolicy::local, 1 << 16});
+                const NdArray<int, 1> e(Shape<1>({1 << 15}));
+                ASSERT_EQ(e.size(), 1 << 15);
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    set_memory_policy(saved);
+}
+
+TEST(NdArrayMethodTest, HugePages) {
+    const Shape<2> shape({1000, 1000});
+    NdArray<int, 2> reference(shape);
+    std::iota(reference.data(), reference.data() + reference.size(), 0);
+
+    /* Explicit huge pages fall back to transparent ones when none are reserved. */
+    for (HugePages huge_pages : {HugePages::transparent, HugePages::hugetlb}) {
+        const MemoryPolicy policy{NumaPolicy::none, 1 << 20, huge_pages};
+        NdArray<int, 2> a = NdArray<int, 2>::with_policy(shape, policy);
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(a.data()) % (1 << 21), 0u);
+
+        a = reference;
+        ASSERT_TRUE((a["::7", "::13"] == reference["::7", "::13"]).all());
+    }
+
+    /* Buffers below the threshold are allocated as usual. */
+    const MemoryPolicy policy{NumaPolicy::none, std::size_t(1) << 21, HugePages::hugetlb};
+    const NdArray<int, 1> small = NdArray<int, 1>::with_policy(Shape<1>({1000}), policy);
+    ASSERT_EQ(small.size(), 1000);
+
+    /* Sizes of the multi-gigabyte arrays these policies target do not overflow. */
+    static_assert(Shape<2>({100000, 30000}).size() == index_t(3000000000));
+    ASSERT_EQ(Shape<3>({100000, 30000, 4}).size(), index_t(12000000000));
+}
@@ -24,3 +24,321 @@ TEST(BinaryArithmeticOpTest, AddString) {
 
     ASSERT_TRUE((c == d).all());
 }
+
+TEST(BinaryArithmeticOpTest, AddMixedType) {
+    const NdArray<int, 2> a = {{1, 2, 3}, {4, 5, 6}};
+    const NdArray<float, 3> b = {{{0.5f, 1.5f, 2.5f, 3.5f}, {4.5f, 5.5f, 6.5f, 7.5f}}};
+    const NdArray<double, 2> c = {{2.5, 4.5, 6.5}, {9.5, 11.5, 13.5}};
+
+    const auto d = a + b[0, ":", "1:"];
+
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(d)>, NdArray<double, 2>>);
+    ASSERT_TRUE((c == d).all());
+}
+
+TEST(BinaryArithmeticOpTest, Promotion) {
+    static_assert(std::is_same_v<util::promote_t<bool, std::int8_t>, std::int8_t>);
+    static_assert(std::is_same_v<util::promote_t<std::int8_t, std::int16_t>, std::int16_t>);
+    static_assert(std::is_same_v<util::promote_t<std::uint8_t, std::int8_t>, std::int16_t>);
+    static_assert(std::is_same_v<util::promote_t<std::uint32_t, std::int32_t>, std::int64_t>);
+    static_assert(std::is_same_v<util::promote_t<std::uint64_t, std::int64_t>, double>);
+    static_assert(std::is_same_v<util::promote_t<std::int16_t, float>, float>);
+    static_assert(std::is_same_v<util::promote_t<std::int32_t, float>, double>);
+    static_assert(std::is_same_v<util::weak_promote_t<float, int>, float>);
+    static_assert(std::is_same_v<util::weak_promote_t<int, double>, double>);
+
+    const NdArray<std::uint8_t, 1> a = {200, 100};
+    const NdArray<std::int8_t, 1> b = {100, -100};
+    const NdArray<std::int16_t, 1> c = {300, 0};
+
+    ASSERT_TRUE((a + b == c).all());
+}
+
+TEST(BinaryArithmeticOpTest, ScalarMixedType) {
+    const NdArray<float, 1> a = {1.0f, 2.0f, 3.0f};
+    const NdArray<int, 1> b = {1, 2, 3};
+
+    const auto c = a * 2;
+    const auto d = b * 1.5;
+
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(c)>, NdArray<float, 1>>);
+    static_assert(std::is_same_v<std::remove_cvref_t<decltype(d)>, NdArray<double, 1>>);
+    ASSERT_TRUE((c == NdArray<float, 1>({2.0f, 4.0f, 6.0f})).all());
+    ASSERT_TRUE((d == NdArray<double, 1>({1.5, 3.0, 4.5})).all());
+    ASSERT_TRUE((b < 2.5).any());
+}
+
+TEST(CompoundAssignmentOpTest, MixedType) {
+    NdArray<int, 2> a = {{1, 2, 3}, {4, 5, 6}};
+    const NdArray<double, 2> b = {{1.5, 1.5, 1.5}, {1.5, 1.5, 1.5}};
+    const NdArray<int, 2> c = {{2, 5, 7}, {8, 11, 13}};
+
+    auto sa = a[":", "1:"];
+    a *= 2;
+    sa += b[":", "1:"];
+    a %= 100;
+
+    ASSERT_TRUE((a == c).all());
+}
+
+TEST(ComparisonOpTest, Mask) {
+    const NdArray<int, 2> a = {{0, 1, 2}, {3, 4, 5}};
+
+    const NdArrayMask<2> m = a > 1;
+    const NdArray<bool, 2> b = a >= 3;
+
+    ASSERT_EQ(m.count_nonzero(), 4);
+    ASSERT_FALSE((m[0, 1]));
+    ASSERT_TRUE((m[-1, -1]));
+    ASSERT_TRUE(m.any());
+    ASSERT_FALSE(m.all());
+    ASSERT_TRUE((b == NdArray<bool, 2>({{false, false, false}, {true, true, true}})).all());
+    ASSERT_EQ(m.to_string(), "NdArrayMask({{0, 0, 1}, {1, 1, 1}})");
+    ASSERT_EQ(m.nbytes(), 8);
+}
+
+TEST(ComparisonOpTest, MaskLogical) {
+    const NdArray<int, 1> a = {0, 1, 2, 3, 4, 5};
+
+    const NdArrayMask<1> m = (a > 1) & (a < 5);
+
+    ASSERT_EQ(m.count_nonzero(), 3);
+    ASSERT_EQ((m | (a == 0)).count_nonzero(), 4);
+    ASSERT_EQ((m ^ (a > 2)).count_nonzero(), 2);
+    ASSERT_EQ((!m).count_nonzero(), 3);
+    ASSERT_TRUE((~(a < 0)).all());
+    ASSERT_TRUE((!a)[0]);
+}
+
+TEST(ComparisonOpTest, MaskIndexing) {
+    const NdArray<int, 2> a = {{0, 1, 2}, {3, 4, 5}};
+
+    ASSERT_TRUE((a[a % 2 == 0] == NdArray<int, 1>({0, 2, 4})).all());
+    ASSERT_TRUE((a[":", "1:"][a[":", "1:"] > 3] == NdArray<int, 1>({4, 5})).all());
+    EXPECT_ANY_THROW(a[NdArrayMask<2>(Shape<2>({3, 2}))]);
+
+    /* Elements are selected in C order, whatever the layout of the array. */
+    const std::array<int, 6> column_major = {0, 3, 1, 4, 2, 5};
+    const NdArray<int, 2> f(Shape<2>({2, 3}), column_major.data(), Order::F);
+    ASSERT_TRUE((f[f % 2 == 1] == NdArray<int, 1>({1, 3, 5})).all());
+    ASSERT_TRUE((a["::-1", "::2"][a["::-1", "::2"] > 1] == NdArray<int, 1>({3, 5, 2})).all());
+
+    const NdArray<bool, 2> b = a > 1;
+    ASSERT_EQ(NdArrayMask<2>(b[":", "::-2"]).to_string(), "NdArrayMask({{1, 0}, {1, 1}})");
+}
+
+TEST(ComparisonOpTest, MaskLarge) {
+    NdArray<int, 1> a(Shape<1>({100003}));
+    for (index_t i = 0; i < a.size(); ++i) {
+        a[i] = static_cast<int>(i % 3);
+    }
+
+    set_num_threads(4);
+    const NdArrayMask<1> m = a == 0;
+    set_num_threads(std::thread::hardware_concurrency());
+
+    ASSERT_EQ(m.count_nonzero(), 33335);
+    ASSERT_TRUE((a[m] == 0).all());
+    ASSERT_TRUE((a >= 0).all());
+    ASSERT_FALSE((a > 0).all());
+}
+
+TEST(IterTest, Coalescing) {
+    NdArray<int, 3> a(Shape<3>({4, 5, 6}));
+    NdArray<int, 3> f(Shape<3>({4, 5, 6}), Order::F);
+    std::vector<index_t> runs;
+    auto record = [&runs](index_t length, const auto &, auto...) { runs.push_back(length); };
+
+    nditer(record, a, a);
+    ASSERT_EQ(runs, std::vector<index_t>({120}));
+
+    runs.clear();
+    nditer(record, f);
+    ASSERT_EQ(runs, std::vector<index_t>({120}));
+
+    /* A slice keeping whole rows coalesces its last two axes, a stepped one only its rows. */
+    runs.clear();
+    nditer(record, a[":2"]);
+    ASSERT_EQ(runs, std::vector<index_t>({60}));
+    runs.clear();
+    nditer(record, a[":", "::2"]);
+    ASSERT_EQ(runs.size(), 12);
+    ASSERT_EQ(runs[0], 6);
+
+    runs.clear();
+    nditer([&runs](index_t length, const auto &, auto...) {
+        runs.push_back(length);
+        return runs.size() < 3;
+    }, a[":", "::2"]);
+    ASSERT_EQ(runs.size(), 3);
+}
+
+TEST(IterTest, StridedOperands) {
+    NdArray<int, 3> a(Shape<3>({4, 5, 6}));
+    NdArray<int, 3> f(Shape<3>({4, 5, 6}), Order::F);
+    for (index_t i = 0; i < a.size(); ++i) {
+        a.item(i) = static_cast<int>(i);
+        f.item(i) = static_cast<int>(3 * i);
+    }
+
+    const auto check = [](const auto &result, const auto &lhs, const auto &rhs) {
+        for (index_t i = 0; i < result.size(); ++i) {
+            ASSERT_EQ(result.item(i), lhs.item(i) + rhs.item(i));
+        }
+    };
+    check(a + f, a, f);
+    check(f + a, f, a);
+    check(a["3:1:-1", "1:", "::2"] + f["2:", "1:", "1::2"], a["3:1:-1", "1:", "::2"], f["2:", "1:", "1::2"]);
+    check(a[1, "::-2"] + a[2, "::2"], a[1, "::-2"], a[2, "::2"]);
+
+    const NdArray<double, 2> s = a[1, "::-1", "::3"].as_type<double>();
+    ASSERT_EQ(s.item(0), 54);
+    ASSERT_EQ(s.item(1), 57);
+    ASSERT_TRUE((a["1:", 1].any()));
+    ASSERT_FALSE((a[":", "::2"].all()));
+    ASSERT_TRUE((a[":", ":", "1:"] > 0).all());
+
+    a[":", "::2"] = f[":", "2:"];
+    ASSERT_EQ((a[1, 2, 3]), (f[1, 3, 3]));
+    a[":", "1::2"] = 7;
+    ASSERT_EQ((a[1, 3, 3]), 7);
+}
+
+TEST(CompoundAssignmentOpTest, Overlap) {
+    NdArray<int, 1> a = {1, 2, 3, 4, 5, 6};
+    auto tail = a["1:"];
+    tail += a[":-1"];
+    ASSERT_TRUE((a == NdArray<int, 1>({1, 3, 5, 7, 9, 11})).all());
+
+    a += a["::-1"];
+    ASSERT_TRUE((a == NdArray<int, 1>({12, 12, 12, 12, 12, 12})).all());
+
+    NdArray<int, 2> b = {{1, 2}, {3, 4}};
+    auto all = b[":", ":"];
+    all *= b;
+    ASSERT_TRUE((b == NdArray<int, 2>({{1, 4}, {9, 16}})).all());
+    auto reversed = b["::-1"];
+    reversed -= 1;
+    ASSERT_TRUE((b == NdArray<int, 2>({{0, 3}, {8, 15}})).all());
+}
+
+TEST(UfuncTest, Broadcast) {
+    const NdArray<int, 2> row = {{1, 2, 3}};
+    const NdArray<int, 2> col = {{10}, {20}};
+
+    ASSERT_EQ(broadcast_shape(row.shape(), col.shape()), Shape<2>({2, 3}));
+    EXPECT_THROW(broadcast_shape(row.shape(), Shape<2>({2, 2})), std::invalid_argument);
+
+    const auto grid = broadcast_to(row, Shape<2>({2, 3}));
+    ASSERT_EQ(grid.strides()[0], 0);
+    ASSERT_EQ((grid[1, 2]), 3);
+    EXPECT_THROW(broadcast_to(row, Shape<2>({2, 4})), std::invalid_argument);
+
+    const NdArray<int, 2> sum = vectorize([](int x, int y) { return x + y; })(row, col);
+    ASSERT_TRUE((sum == NdArray<int, 2>({{11, 12, 13}, {21, 22, 23}})).all());
+}
+
+TEST(UfuncTest, Vectorize) {
+    NdArray<double, 2> a = {{1, 2, 3}, {4, 5, 6}};
+    const NdArray<int, 1> x = {7, 8, 9};
+
+    const auto halve = vectorize([](double v) { return v / 2; });
+    ASSERT_TRUE((halve(a[":", "::-1"]) == NdArray<double, 2>({{1.5, 1, 0.5}, {3, 2.5, 2}})).all());
+
+    const auto [q, r] = vectorize([](int v, int d) { return std::tuple{v / d, v % d}; })(x, NdArray<int, 1>({2}));
+    ASSERT_TRUE((q == NdArray<int, 1>({3, 4, 4})).all());
+    ASSERT_TRUE((r == NdArray<int, 1>({1, 0, 1})).all());
+
+    /* Batch kernels get contiguous buffers, also for strided operands. */
+    const auto negate = vectorize<double>([](index_t n, double *out, const double *in) {
+        for (index_t i = 0; i < n; ++i) {
+            out[i] = -in[i];
+        }
+    });
+    ASSERT_TRUE((negate(a) == -a).all());
+    ASSERT_TRUE((negate(a[":", "::2"]) == NdArray<double, 2>({{-1, -3}, {-4, -6}})).all());
+
+    /* In-place and overlapping outputs. */
+    apply([](double v) { return 10 * v; }, a[":", "::2"], a[":", "::2"]);
+    ASSERT_TRUE((a == NdArray<double, 2>({{10, 2, 30}, {40, 5, 60}})).all());
+    halve.apply(a[":", "1:"], a[":", ":-1"]);
+    ASSERT_TRUE((a == NdArray<double, 2>({{10, 5, 1}, {40, 20, 2.5}})).all());
+    NdArray<int, 1> lo(Shape<1>({3})), hi(Shape<1>({3}));
+    apply([](int v) { return std::tuple{v - 1, v + 1}; }, std::tie(lo, hi), x);
+    ASSERT_TRUE((hi - lo == 2).all());
+    EXPECT_THROW(apply([](int v) { return v; }, lo, NdArray<int, 1>({1, 2})), std::invalid_argument);
+}
+
+TEST(UfuncTest, Parallel) {
+    NdArray<float, 2> a(Shape<2>({300, 1001}));
+    for (index_t i = 0; i < a.size(); ++i) {
+        a.item(i) = static_cast<float>(i % 17);
+    }
+    const NdArray<float, 2> b = a[":", "1:"];
+
+    set_num_threads(4);
+    const NdArray<float, 2> c = vectorize([](float x, float y) { return x * y + 1; })(a[":", ":-1"], b);
+    set_num_threads(std::thread::hardware_concurrency());
+
+    for (index_t i = 0; i < c.size(); ++i) {
+        const index_t row = i / 1000, col = i % 1000;
+        ASSERT_EQ(c.item(i), (a[row, col]) * (a[row, col + 1]) + 1);
+    }
+}
+
+TEST(CompareTest, ArrayEqual) {
+    const NdArray<int, 2> a({{1, 2, 3}, {4, 5, 6}});
+    NdArray<int, 2> f(a.shape(), Order::F);
+    f[":", ":"] = a;
+    ASSERT_TRUE(array_equal(a, NdArray<int, 2>({{1, 2, 3}, {4, 5, 6}})));
+    ASSERT_TRUE(array_equal(a, f));
+    ASSERT_TRUE(array_equal(a, NdArray<double, 2>({{1, 2, 3}, {4, 5, 6}})));
+    ASSERT_TRUE((array_equal(a[":", "::2"], NdArray<int, 2>({{1, 3}, {4, 6}}))));
+    ASSERT_FALSE(array_equal(a, NdArray<int, 2>({{1, 2, 3}, {4, 5, 7}})));
+    ASSERT_FALSE(array_equal(a, NdArray<int, 2>({{1, 2}, {4, 5}})));
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const NdArray<double, 1> x({1.0, nan, -0.0});
+    ASSERT_FALSE(array_equal(x, x));
+    ASSERT_TRUE(array_equal(x, NdArray<double, 1>({1.0, nan, 0.0}), true));
+}
+
+TEST(CompareTest, Close) {
+    const double inf = std::numeric_limits<double>::infinity(), nan = std::numeric_limits<double>::quiet_NaN();
+    const NdArray<double, 1> a({1.0, 1e10, inf, nan, 0.0});
+    const NdArray<double, 1> b({1.0 + 1e-9, 1.00001e10, inf, nan, 1e-7});
+    const NdArrayMask<1> close = isclose(a, b);
+    ASSERT_TRUE(close[0] && close[1] && close[2]);
+    ASSERT_FALSE(close[3] || close[4]);
+    ASSERT_TRUE(isclose(a, b, 1e-5, 1e-8, true)[3]);
+    ASSERT_FALSE(allclose(a, b));
+    ASSERT_TRUE((allclose(a["0:3"], b["0:3"])));
+    ASSERT_TRUE((allclose(a, b, 1e-5, 1e-6, true)));
+    ASSERT_TRUE(allclose(NdArray<int, 1>({1, 2}), NdArray<float, 1>({1.0f, 2.0f})));
+    EXPECT_THROW(allclose(a, NdArray<double, 1>({1.0})), std::invalid_argument);
+
+    ASSERT_EQ(count_nonzero(NdArray<int, 2>({{0, 1, 2}, {3, 0, 0}})), 3);
+    ASSERT_EQ(count_nonzero(a), 4);
+    ASSERT_EQ(count_nonzero(a["::2"]), 2);
+}
+
+TEST(CompareTest, Parallel) {
+    NdArray<std::int64_t, 2> a(Shape<2>({512, 1000}));
+    for (index_t i = 0; i < a.size(); ++i) {
+        a.item(i) = i % 7;
+    }
+    NdArray<std::int64_t, 2> b = a;
+    NdArray<double, 2> c = a.as_type<double>();
+
+    set_num_threads(4);
+    ASSERT_TRUE(array_equal(a, b));
+    ASSERT_TRUE(array_equal(a, c));
+    ASSERT_TRUE((array_equal(a[":", "1:"], b[":", "1:"])));
+    ASSERT_EQ(count_nonzero(a), a.size() - (a.size() + 6) / 7);
+    b.item(b.size() - 1) += 1;
+    c.item(b.size() / 2) += 1e-3;
+    ASSERT_FALSE(array_equal(a, b));
+    ASSERT_FALSE(allclose(a, c));
+    ASSERT_TRUE(allclose(a, c, 0, 1e-2));
+    set_num_threads(std::thread::hardware_concurrency());
+}
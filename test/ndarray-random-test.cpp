@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <numeric>
+
+#include "../include/ndarray.hpp"
+
+using namespace ndarray;
+
+TEST(NdArrayRandomTest, Philox) {
+    /* Known answers of the Random123 reference implementation. */
+    ASSERT_EQ(util::philox({0, 0, 0, 0}, {0, 0}),
+              (util::philox_counter_t{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+    ASSERT_EQ(util::philox({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff}),
+              (util::philox_counter_t{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+    ASSERT_EQ(util::mul_high(0xffffffffffffffff, 0xffffffffffffffff), 0xfffffffffffffffe);
+}
+
+TEST(NdArrayRandomTest, Reproducible) {
+    const Shape<2> shape({300, 1001});
+    const std::size_t num_threads = get_num_threads();
+
+    set_num_threads(1);
+    random::Generator serial(42);
+    const NdArray<double, 2> a = serial.normal(shape);
+    const NdArray<float, 2> b = serial.uniform<float>(shape);
+
+    set_num_threads(7);
+    random::Generator parallel(42);
+    ASSERT_TRUE((parallel.normal(shape) == a).all());
+    ASSERT_TRUE((parallel.uniform<float>(shape) == b).all());
+    ASSERT_EQ(parallel.counter(), serial.counter());
+    set_num_threads(num_threads);
+
+    /* Consecutive draws and different seeds give different values. */
+    ASSERT_FALSE((serial.normal(shape) == a).any());
+    ASSERT_FALSE((random::Generator(43).normal(shape) == a).any());
+
+    random::seed(42);
+    ASSERT_TRUE((random::normal(shape) == a).all());
+}
+
+TEST(NdArrayRandomTest, Distributions) {
+    random::Generator generator(7);
+    const Shape<1> shape({1 << 20});
+    const double n = static_cast<double>(shape.size());
+
+    const NdArray<double, 1> u = generator.uniform(shape, -2.0, 3.0);
+    ASSERT_TRUE(((u >= -2.0) & (u < 3.0)).all());
+    ASSERT_NEAR(std::accumulate(u.data(), u.data() + u.size(), 0.0) / n, 0.5, 0.01);
+
+    const NdArray<double, 1> single = generator.normal<float>(shape, 1.0f, 2.0f).as_type<double>();
+    for (const NdArray<double, 1> &x : {generator.normal(shape, 1.0, 2.0), single}) {
+        const double mean = std::accumulate(x.data(), x.data() + x.size(), 0.0) / n;
+        double variance = 0;
+        for (index_t i = 0; i < x.size(); ++i) {
+            variance += (x.data()[i] - mean) * (x.data()[i] - mean);
+        }
+        ASSERT_NEAR(mean, 1.0, 0.01);
+        ASSERT_NEAR(std::sqrt(variance / n), 2.0, 0.01);
+    }
+
+    const NdArray<int, 1> k = generator.integers(shape, -3, 4);
+    ASSERT_TRUE(((k >= -3) & (k < 4)).all());
+    for (int value = -3; value < 4; ++value) {
+        ASSERT_NEAR(static_cast<double>((k == value).count_nonzero()) / n, 1.0 / 7, 0.005);
+    }
+    const NdArray<std::uint8_t, 2> bytes = generator.integers<std::uint8_t>(Shape<2>({3, 5}), 0, 255);
+    ASSERT_TRUE((bytes < 255).all());
+
+    ASSERT_THROW(generator.integers(shape, 1, 1), std::invalid_argument);
+    ASSERT_THROW(generator.uniform(shape, 1.0, 0.0), std::invalid_argument);
+    ASSERT_THROW(generator.normal(shape, 0.0, -1.0), std::invalid_argument);
+}
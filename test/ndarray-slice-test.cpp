@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <thread>
+
 #include "../include/ndarray.hpp"
 
 using namespace ndarray;
@@ -163,6 +166,128 @@ TEST(NdArraySliceTest, Assign2dString) {
     EXPECT_TRUE((a == c).all());
 }
 
+TEST(NdArraySliceTest, AssignSlice) {
+    NdArray<int, 2> a = {{0, 1, 2}, {3, 4, 5}};
+    const NdArray<int, 2> b = {{6, 7, 8}, {9, 10, 11}};
+    const NdArray<int, 2> c = {{8, 6, 2}, {11, 9, 5}};
+
+    a[":", ":2"] = b[":", "::-2"];
+    a[1] = a[1];
+
+    EXPECT_TRUE((a == c).all());
+    EXPECT_ANY_THROW((a[":", ":2"] = b[":", ":"]));
+}
+
+TEST(NdArraySliceTest, AssignOverlap) {
+    NdArray<int, 1> a = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    NdArray<int, 2> b = {{0, 1, 2, 3}, {4, 5, 6, 7}, {8, 9, 10, 11}};
+
+    a["1:"] = a[":-1"];
+    EXPECT_TRUE((a == NdArray<int, 1>({0, 0, 1, 2, 3, 4, 5, 6, 7, 8})).all());
+    a[":-2"] = a["2:"];
+    EXPECT_TRUE((a == NdArray<int, 1>({1, 2, 3, 4, 5, 6, 7, 8, 7, 8})).all());
+    a[":"] = a["::-1"];
+    EXPECT_TRUE((a == NdArray<int, 1>({8, 7, 8, 7, 6, 5, 4, 3, 2, 1})).all());
+
+    b["1:", "1:"] = b[":-1", ":-1"];
+    EXPECT_TRUE((b == NdArray<int, 2>({{0, 1, 2, 3}, {4, 0, 1, 2}, {8, 4, 5, 6}})).all());
+    b[":", 0] = b[0, ":3"];
+    EXPECT_TRUE((b == NdArray<int, 2>({{0, 1, 2, 3}, {1, 0, 1, 2}, {2, 4, 5, 6}})).all());
+}
+
+TEST(NdArraySliceTest, AssignOverlapFortran) {
+    NdArray<int, 2> a(Shape<2>({3, 3}), Order::F);
+    a[":", ":"] = NdArray<int, 2>({{0, 1, 2}, {3, 4, 5}, {6, 7, 8}});
+    a[":-1", "1:"] = a["1:", ":-1"];
+    EXPECT_TRUE((a == NdArray<int, 2>({{0, 3, 4}, {3, 6, 7}, {6, 7, 8}})).all());
+
+    /* Shift a 3-D array by one along every axis in every direction, against the same shifts of a C-ordered copy. */
+    const char *ranges[2] = {"1:", ":-1"};
+    for (int dir = 0; dir < 8; ++dir) {
+        NdArray<int, 3> c(Shape<3>({3, 4, 5}));
+        for (index_t i = 0; i < c.size(); ++i) {
+            c.item(i) = static_cast<int>(i);
+        }
+        NdArray<int, 3> f(c.shape(), Order::F);
+        f[":", ":", ":"] = c;
+
+        const char *dst[3] = {ranges[dir & 1], ranges[(dir >> 1) & 1], ranges[(dir >> 2) & 1]};
+        const char *src[3] = {ranges[1 - (dir & 1)], ranges[1 - ((dir >> 1) & 1)], ranges[1 - ((dir >> 2) & 1)]};
+        c[dst[0], dst[1], dst[2]] = c[src[0], src[1], src[2]];
+        f[dst[0], dst[1], dst[2]] = f[src[0], src[1], src[2]];
+        EXPECT_TRUE((f == c).all()) << "direction " << dir;
+    }
+}
+
+TEST(NdArraySliceTest, AssignMixedType) {
+    NdArray<double, 1> a = {0.0, 0.0, 0.0};
+    const NdArray<int, 1> b = {1, 2, 3, 4};
+
+    a[":"] = b["1:"];
+
+    EXPECT_TRUE((a == NdArray<double, 1>({2.0, 3.0, 4.0})).all());
+}
+
+TEST(NdArraySliceTest, CopyView) {
+    NdArray<int, 2> a = {{0, 1, 2}, {3, 4, 5}};
+
+    std::vector<NdArraySlice<int, 1, NdArray<int, 2>>> columns;
+    for (index_t j = 0; j < 3; ++j) {
+        columns.push_back(a[":", j]);
+    }
+    auto row = a[1, "::-1"];
+    auto copy = row;
+
+    std::thread([&columns]() { columns[1].fill(-1); }).join();
+
+    EXPECT_TRUE((columns[2] == NdArray<int, 1>({2, 5})).all());
+    EXPECT_TRUE((copy == NdArray<int, 1>({5, -1, 3})).all());
+    EXPECT_EQ(row.strides(), (std::array<index_t, 1>{-1}));
+    EXPECT_EQ(&copy[0], (&a[1, 2]));
+}
+
+TEST(NdArraySliceTest, RebindView) {
+    NdArray<int, 2> a = {{0, 1, 2}, {3, 4, 5}, {6, 7, 8}};
+    const NdArray<int, 2> original = a;
+
+    /* Containers and algorithms move handles around without touching the viewed elements. */
+    std::vector<SliceHandle<int, 1, NdArray<int, 2>>> rows = {a[2], a[0], a[1]};
+    rows.erase(rows.begin());
+    rows.insert(rows.begin() + 1, a[2]);
+    std::sort(rows.begin(), rows.end(), [](const auto &x, const auto &y) { return (*x)[0] > (*y)[0]; });
+    EXPECT_TRUE((a == original).all());
+    EXPECT_EQ(&(*rows[0])[0], (&a[2, 0]));
+    EXPECT_EQ(&(*rows[2])[0], (&a[0, 0]));
+
+    /* rebind() makes a view refer to another one, even of another shape. */
+    auto v = a[0];
+    v.rebind(a[1, "1:"]);
+    EXPECT_EQ(v.shape(), Shape<1>({2}));
+    EXPECT_EQ(&v[0], (&a[1, 1]));
+    EXPECT_TRUE((a == original).all());
+
+    /* Assigning a view assigns its elements, whatever the right-hand side. */
+    auto w = a[2];
+    w = a[0];
+    EXPECT_TRUE((a[2] == NdArray<int, 1>({0, 1, 2})).all());
+    EXPECT_EQ(&w[0], (&a[2, 0]));
+    *rows[1] = NdArray<int, 1>({9, 9, 9});
+    EXPECT_TRUE((a[1] == 9).all());
+    a[1] = a[0];
+    EXPECT_TRUE((a[1] == NdArray<int, 1>({0, 1, 2})).all());
+    EXPECT_THROW(w = v, std::invalid_argument);
+}
+
+TEST(NdArraySliceTest, SharedView) {
+    auto a = std::make_shared<NdArray<int, 2>>(NdArray<int, 2>({{0, 1, 2}, {3, 4, 5}}));
+
+    auto col = view(a)[":", 1];
+    a.reset();
+
+    EXPECT_NE(col.owner(), nullptr);
+    EXPECT_TRUE((col == NdArray<int, 1>({1, 4})).all());
+}
+
 TEST(NdArraySliceTest, NdArrayCast1d) {
     const NdArray<int, 1> a = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
     const NdArray<int, 1> b = a["2:8"];
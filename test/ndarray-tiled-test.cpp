@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <numeric>
+
+#include "../include/ndarray.hpp"
+
+using namespace ndarray;
+
+template <std::size_t Dim>
+static NdArray<int, Dim> iota_array(const Shape<Dim> &shape) {
+    NdArray<int, Dim> result(shape);
+    std::iota(result.data(), result.data() + result.size(), 0);
+    return result;
+}
+
+TEST(TiledNdArrayTest, Conversion) {
+    const NdArray<int, 2> a = iota_array(Shape<2>({37, 21}));
+    const NdArray<int, 3> b = iota_array(Shape<3>({5, 9, 11}));
+
+    for (TileOrder order : {TileOrder::row_major, TileOrder::morton}) {
+        const TiledNdArray<int, 2, 8> ta(a, order);
+        const TiledNdArray<int, 3, 4> tb(b, order);
+
+        ASSERT_EQ(ta.shape(), a.shape());
+        ASSERT_EQ(ta.grid(), (std::array<index_t, 2>{5, 3}));
+        ASSERT_EQ(ta.num_tiles(), 15);
+        ASSERT_TRUE((ta.to_array() == a).all());
+        ASSERT_TRUE((NdArray<int, 3>(tb) == b).all());
+        ASSERT_EQ(ta.to_string(), a.to_string());
+    }
+
+    /* The first tile holds the top-left 8x8 block in C order. */
+    const TiledNdArray<int, 2, 8> ta(a);
+    ASSERT_EQ(ta.tile_data({0, 0})[9], (a[1, 1]));
+    ASSERT_EQ(ta.tile_data({1, 2})[0], (a[8, 16]));
+}
+
+TEST(TiledNdArrayTest, Morton) {
+    TiledNdArray<int, 2, 4> a(Shape<2>({16, 16}), TileOrder::morton);
+
+    /* Tiles (0, 0), (0, 1), (1, 0), (1, 1) come first. */
+    ASSERT_EQ(a.tile_data({0, 1}), a.data() + 16);
+    ASSERT_EQ(a.tile_data({1, 0}), a.data() + 32);
+    ASSERT_EQ(a.tile_data({1, 1}), a.data() + 48);
+    ASSERT_EQ(a.tile_data({0, 2}), a.data() + 64);
+    ASSERT_ANY_THROW(a.tile_data({4, 0}));
+}
+
+TEST(TiledNdArrayTest, Indexing) {
+    const NdArray<int, 2> a = iota_array(Shape<2>({10, 12}));
+    TiledNdArray<int, 2, 4> ta(a, TileOrder::morton);
+
+    ta[5, 7] = -1;
+
+    EXPECT_EQ((ta[-1, 0]), 108);
+    EXPECT_EQ((ta[5, 7]), -1);
+    EXPECT_EQ(ta.item(67), -1);
+    EXPECT_EQ(ta.item(-1), 119);
+    EXPECT_ANY_THROW((ta[10, 0]));
+}
+
+TEST(TiledNdArrayTest, Slicing) {
+    NdArray<int, 3> a = iota_array(Shape<3>({6, 7, 9}));
+    TiledNdArray<int, 3, 4> ta(a);
+
+    ASSERT_TRUE((ta[2] == a[2]).all());
+    ASSERT_TRUE((ta["1:5", 3, "::-2"] == a["1:5", 3, "::-2"]).all());
+    ASSERT_TRUE((ta["1:5", 3, "::-2"]["1:", 2] == a["1:5", 3, "::-2"]["1:", 2]).all());
+
+    ta[":", "2:4", "1:"] = 0;
+    a[":", "2:4", "1:"] = 0;
+    ASSERT_TRUE((ta == a).all());
+
+    ta[0] = ta[5];
+    a[0] = a[5];
+    ASSERT_TRUE((ta.to_array() == a).all());
+}
+
+TEST(TiledNdArrayTest, Arithmetic) {
+    const NdArray<float, 2> a = iota_array(Shape<2>({33, 40})).as_type<float>();
+    const TiledNdArray<float, 2> ta(a, TileOrder::morton);
+
+    const NdArray<float, 2> b = ta * 2 + a;
+    ASSERT_TRUE((b == a * 3).all());
+    ASSERT_TRUE((ta == a).all());
+    ASSERT_FALSE(ta.all());
+    ASSERT_TRUE(ta.any());
+
+    TiledNdArray<float, 2> tb(ta.shape());
+    tb = b;
+    ASSERT_TRUE((tb == b).all());
+    ASSERT_TRUE((tb.reshape(Shape<1>({33 * 40})) == b.flatten()).all());
+}